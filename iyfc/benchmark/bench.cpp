@@ -1,11 +1,211 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
 #include "bench.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include "benchmark/benchmark.h"
+#include "iyfc_include.h"
+#include "synthetic_dag.h"
+
+using namespace iyfc;
 
 namespace iyfcbench
 {
+    std::size_t readPeakMemoryKb()
+    {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line))
+        {
+            if (line.compare(0, 6, "VmHWM:") == 0)
+            {
+                std::istringstream fields(line.substr(6));
+                std::size_t kb = 0;
+                fields >> kb;
+                return kb;
+            }
+        }
+        return 0;
+    }
+
+    void resetPeakMemory()
+    {
+        // Linux resets VmHWM to the current RSS on "5"
+        std::ofstream clear_refs("/proc/self/clear_refs");
+        if (clear_refs)
+        {
+            clear_refs << "5";
+        }
+    }
+
+    void PassStats::beginPass(const std::string &name, const Dag & /*dag*/)
+    {
+        std::string key = std::to_string(m_stack.size()) + name;
+        auto iter = m_index.find(key);
+        if (iter == m_index.end())
+        {
+            iter = m_index.emplace(key, m_entries.size()).first;
+            Entry entry;
+            entry.name = name;
+            entry.level = m_stack.size();
+            m_entries.push_back(entry);
+        }
+        // A nested pass resets the peak, its parent keeps the maximum
+        if (!m_stack.empty())
+        {
+            m_stack.back().peak_kb = std::max(m_stack.back().peak_kb, readPeakMemoryKb());
+        }
+        resetPeakMemory();
+        m_stack.push_back({ iter->second, std::chrono::steady_clock::now(), 0 });
+    }
+
+    void PassStats::endPass(const std::string & /*name*/, const Dag &dag)
+    {
+        Frame frame = m_stack.back();
+        m_stack.pop_back();
+        std::size_t peak_kb = std::max(frame.peak_kb, readPeakMemoryKb());
+        if (!m_stack.empty())
+        {
+            m_stack.back().peak_kb = std::max(m_stack.back().peak_kb, peak_kb);
+        }
+
+        Entry &entry = m_entries[frame.entry];
+        entry.calls++;
+        entry.ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame.start).count();
+        entry.nodes = dag.getNodeArena().liveCnt();
+        entry.peak_kb = std::max(entry.peak_kb, peak_kb);
+    }
+
+    double PassStats::totalMs() const
+    {
+        double ms = 0;
+        for (auto &entry : m_entries)
+        {
+            if (entry.level == 0)
+            {
+                ms += entry.ms;
+            }
+        }
+        return ms;
+    }
+
+    std::size_t PassStats::peakKb() const
+    {
+        std::size_t kb = 0;
+        for (auto &entry : m_entries)
+        {
+            kb = std::max(kb, entry.peak_kb);
+        }
+        return kb;
+    }
+
+    void PassStats::report(std::ostream &os) const
+    {
+        os << std::left << std::setw(48) << "pass" << std::right << std::setw(7) << "calls" << std::setw(12) << "ms"
+           << std::setw(10) << "nodes" << std::setw(12) << "peak_MB" << "\n";
+        for (auto &entry : m_entries)
+        {
+            os << std::left << std::setw(48) << (std::string(2 * entry.level, ' ') + entry.name) << std::right
+               << std::setw(7) << entry.calls << std::setw(12) << std::fixed << std::setprecision(2) << entry.ms
+               << std::setw(10) << entry.nodes << std::setw(12) << std::setprecision(1) << entry.peak_kb / 1024.0
+               << "\n";
+        }
+        os.flush();
+    }
+
+    /**
+     * @brief Compile a synthetic DAG of range(0) x range(1) nodes, reporting
+     * every pass of the decision pipeline and of the chosen library
+     */
+    void compileSynthetic(benchmark::State &state, std::uint32_t max_mult_depth)
+    {
+        SyntheticDagConfig config;
+        config.width = static_cast<std::uint32_t>(state.range(0));
+        config.depth = static_cast<std::uint32_t>(state.range(1));
+        config.max_mult_depth = max_mult_depth;
+
+        std::size_t nodes = 0;
+        std::shared_ptr<PassStats> stats;
+        std::string lib;
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            DagPtr dag = makeSyntheticDag("bench", config);
+            nodes = dag->getNodeArena().liveCnt();
+            stats = std::make_shared<PassStats>();
+            dag->setPassProfiler(stats);
+            state.ResumeTiming();
+
+            compileDag(dag);
+
+            state.PauseTiming();
+            std::vector<std::string> libs = getLibInfo(dag);
+            lib = libs.empty() ? "" : libs[0];
+            releaseDag(dag);
+            state.ResumeTiming();
+        }
+
+        state.counters["nodes"] = static_cast<double>(nodes);
+        state.counters["pass_ms"] = stats->totalMs();
+        state.counters["peak_MB"] = stats->peakKb() / 1024.0;
+        state.SetLabel(lib);
+        std::cout << "\n" << lib << " width " << config.width << " depth " << config.depth << ", " << nodes << " nodes\n";
+        stats->report(std::cout);
+    }
+
+    void BM_CompileCkks(benchmark::State &state)
+    {
+        compileSynthetic(state, 4);
+    }
+
+    // Deeper than the SEAL parameter tables, the decision picks OpenFHE
+    void BM_CompileDeepCkks(benchmark::State &state)
+    {
+        compileSynthetic(state, 16);
+    }
+
+    // width x depth, 1k to 1M nodes
+    void compileSizes(benchmark::internal::Benchmark *bench)
+    {
+        bench->Args({ 32, 32 })->Args({ 100, 100 })->Args({ 316, 316 })->Args({ 1000, 1000 });
+        bench->ArgNames({ "width", "depth" })->Iterations(1)->Unit(benchmark::kMillisecond);
+    }
 
+    BENCHMARK(BM_CompileCkks)->Apply(compileSizes);
+    BENCHMARK(BM_CompileDeepCkks)->Apply(compileSizes);
 } // namespace iyfcbench
 
 int main(int argc, char **argv)
 {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
     return 0;
-}
\ No newline at end of file
+}
@@ -1,6 +1,83 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
+#include "dag/iyfc_dag.h"
 
 namespace iyfcbench
 {
+    /**
+     * @brief Peak resident set size of the process in KiB, since the last
+     * resetPeakMemory. 0 where /proc is not available.
+     */
+    std::size_t readPeakMemoryKb();
+    void resetPeakMemory();
 
+    /**
+     * @class PassStats
+     * @brief Times every pass run over a DAG, with the node count after it
+     * and the peak memory during it. Nested passes are counted in their
+     * parent as well.
+     */
+    class PassStats : public iyfc::PassProfiler
+    {
+    public:
+        struct Entry
+        {
+            std::string name;
+            std::size_t level = 0;
+            std::size_t calls = 0;
+            double ms = 0;
+            std::size_t nodes = 0;
+            std::size_t peak_kb = 0;
+        };
+
+        void beginPass(const std::string &name, const iyfc::Dag &dag) override;
+        void endPass(const std::string &name, const iyfc::Dag &dag) override;
+
+        const std::vector<Entry> &entries() const
+        {
+            return m_entries;
+        }
+        double totalMs() const;
+        std::size_t peakKb() const;
+        void report(std::ostream &os) const;
+
+    private:
+        struct Frame
+        {
+            std::size_t entry;
+            std::chrono::steady_clock::time_point start;
+            std::size_t peak_kb;
+        };
+        std::vector<Entry> m_entries;
+        std::unordered_map<std::string, std::size_t> m_index;
+        std::vector<Frame> m_stack;
+    };
 } // namespace iyfcbench
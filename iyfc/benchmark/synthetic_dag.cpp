@@ -0,0 +1,112 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "synthetic_dag.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace iyfc;
+
+namespace iyfcbench
+{
+    DagPtr makeSyntheticDag(const std::string &name, const SyntheticDagConfig &config)
+    {
+        if (config.width == 0 || config.depth == 0 || config.fan_out == 0)
+        {
+            throw std::logic_error("synthetic dag needs a non-empty shape");
+        }
+        std::mt19937 rng(config.seed);
+        std::uniform_real_distribution<double> coin(0.0, 1.0);
+        std::uniform_int_distribution<std::uint32_t> pick(0, config.width - 1);
+        std::uniform_int_distribution<std::uint32_t> op_pick(0, 2);
+        std::uniform_int_distribution<std::uint32_t> rot_pick(0, 9);
+
+        DagPtr dag = initDag(name, config.vec_size);
+        std::vector<Expr> layer;
+        std::vector<std::uint32_t> mult_depth(config.width, 0);
+        for (std::uint32_t i = 0; i < config.width; i++)
+        {
+            layer.push_back(setInputName(dag, "in_" + std::to_string(i)));
+        }
+
+        for (std::uint32_t d = 0; d < config.depth; d++)
+        {
+            std::vector<Expr> next;
+            std::vector<std::uint32_t> next_depth(config.width, 0);
+            for (std::uint32_t i = 0; i < config.width; i++)
+            {
+                if (coin(rng) < config.rotation_density)
+                {
+                    // Power of two steps keep the rotation key set small
+                    std::uint32_t step = (1u << rot_pick(rng)) % config.vec_size;
+                    next.push_back(layer[i] << std::max(step, 1u));
+                    next_depth[i] = mult_depth[i];
+                    continue;
+                }
+
+                Expr node = layer[i];
+                std::uint32_t depth = mult_depth[i];
+                for (std::uint32_t k = 1; k < config.fan_out; k++)
+                {
+                    std::uint32_t j = pick(rng);
+                    std::uint32_t op = op_pick(rng);
+                    if (coin(rng) < config.constant_density)
+                    {
+                        // Plaintext products take a level too
+                        double value = coin(rng);
+                        if (op == 2 && depth < config.max_mult_depth)
+                        {
+                            node = node * value;
+                            depth++;
+                        }
+                        else
+                        {
+                            node = node + value;
+                        }
+                        continue;
+                    }
+                    if (op == 2 && std::max(depth, mult_depth[j]) < config.max_mult_depth)
+                    {
+                        node = node * layer[j];
+                        depth = std::max(depth, mult_depth[j]) + 1;
+                    }
+                    else
+                    {
+                        node = op == 1 ? node - layer[j] : node + layer[j];
+                        depth = std::max(depth, mult_depth[j]);
+                    }
+                }
+                next.push_back(node);
+                next_depth[i] = depth;
+            }
+            layer.swap(next);
+            mult_depth.swap(next_depth);
+        }
+
+        for (std::uint32_t i = 0; i < config.width; i++)
+        {
+            setOutput(dag, "out_" + std::to_string(i), layer[i]);
+        }
+        return dag;
+    }
+} // namespace iyfcbench
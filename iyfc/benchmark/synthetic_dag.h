@@ -0,0 +1,58 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "iyfc_include.h"
+
+namespace iyfcbench
+{
+    /**
+     * @brief Shape of a synthetic DAG. Nodes are built in layers of width
+     * nodes, each reading fan_out nodes of the layer above, so the DAG has
+     * about width * depth * (fan_out - 1) nodes.
+     */
+    struct SyntheticDagConfig
+    {
+        std::uint32_t width = 32;
+        std::uint32_t depth = 32;
+        // Operands of a node, and so uses of a node in the next layer
+        std::uint32_t fan_out = 2;
+        // Share of nodes that rotate their operand
+        double rotation_density = 0.1;
+        // Share of operands replaced by a plaintext constant
+        double constant_density = 0.1;
+        // Ciphertext multiplications on any path, decides the library
+        std::uint32_t max_mult_depth = 4;
+        std::uint32_t vec_size = 1024;
+        std::uint32_t seed = 1;
+    };
+
+    /**
+     * @brief Build a random CKKS DAG of the given shape. Inputs are named
+     * in_<i>, the nodes of the last layer are the outputs out_<i>.
+     * @return The DAG, to be released with iyfc::releaseDag
+     */
+    iyfc::DagPtr makeSyntheticDag(const std::string &name, const SyntheticDagConfig &config);
+} // namespace iyfcbench
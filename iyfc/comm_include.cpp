@@ -23,6 +23,10 @@
 
 #include "comm_include.h"
 
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+
 namespace iyfc {
 
 DagSerializePara::DagSerializePara(bool node_info, bool gen_key, bool sig, bool exe_ctx,
@@ -54,5 +58,89 @@ DagSerializePara::DagSerializePara(bool node_info, bool gen_key, bool sig, bool
     need_decrypt_ctx = par;
   }
 
+std::vector<uint32_t> SlotSelection::indices(uint32_t vec_size) const {
+  if (stride == 0) {
+    throw std::logic_error("slot selection stride must be positive");
+  }
+  std::vector<uint32_t> result;
+  uint64_t end = static_cast<uint64_t>(vec_size) * std::max(replicas, 1u);
+  for (uint64_t idx = offset; idx < end; idx += stride) {
+    if (count != 0 && result.size() == count) break;
+    result.push_back(static_cast<uint32_t>(idx));
+  }
+  return result;
+}
+
+template <typename T>
+static void pickVectorSlots(std::vector<T> &vec,
+                            const std::vector<uint32_t> &indices) {
+  std::vector<T> picked;
+  picked.reserve(indices.size());
+  for (auto idx : indices) {
+    if (idx >= vec.size()) break;
+    picked.push_back(vec[idx]);
+  }
+  vec = std::move(picked);
+}
+
+void pickSlots(ValuationType &value, const std::vector<uint32_t> &indices) {
+  if (auto *v = std::get_if<std::vector<double>>(&value)) {
+    pickVectorSlots(*v, indices);
+  } else if (auto *v = std::get_if<std::vector<int64_t>>(&value)) {
+    pickVectorSlots(*v, indices);
+  } else if (auto *v = std::get_if<std::vector<std::complex<double>>>(&value)) {
+    pickVectorSlots(*v, indices);
+  }
+}
+
+void pickSlots(ValuationType &value, const SlotSelection &slots) {
+  if (auto *v = std::get_if<std::vector<double>>(&value)) {
+    pickVectorSlots(*v, slots.indices(v->size()));
+  } else if (auto *v = std::get_if<std::vector<int64_t>>(&value)) {
+    pickVectorSlots(*v, slots.indices(v->size()));
+  } else if (auto *v = std::get_if<std::vector<std::complex<double>>>(&value)) {
+    pickVectorSlots(*v, slots.indices(v->size()));
+  }
+}
+
+InputSpan toInputSpan(const ValuationType &value) {
+  if (auto *v = std::get_if<std::vector<double>>(&value)) {
+    return InputSpan(v->data(), v->size());
+  } else if (auto *v = std::get_if<std::vector<int64_t>>(&value)) {
+    return InputSpan(v->data(), v->size());
+  } else if (auto *v = std::get_if<double>(&value)) {
+    return InputSpan(v, 1);
+  } else if (auto *v = std::get_if<int64_t>(&value)) {
+    return InputSpan(v, 1);
+  }
+  return InputSpan();
+}
+
+void writeOutput(const ValuationType &value, OutputBuffer &buffer) {
+  auto write = [&](const auto &src) {
+    buffer.size = std::min(src.size(), buffer.capacity);
+    for (size_t i = 0; i < buffer.size; ++i) {
+      if (buffer.f64) {
+        buffer.f64[i] = static_cast<double>(src[i]);
+      } else if constexpr (std::is_floating_point_v<
+                               std::decay_t<decltype(src[i])>>) {
+        buffer.i64[i] = static_cast<int64_t>(std::llround(src[i]));
+      } else {
+        // Exact beyond 2^53, BFV values are not rounded through double
+        buffer.i64[i] = src[i];
+      }
+    }
+  };
+  if (buffer.f64 == nullptr && buffer.i64 == nullptr) {
+    throw std::logic_error("output buffer without data");
+  }
+  if (auto *v = std::get_if<std::vector<double>>(&value)) {
+    write(*v);
+  } else if (auto *v = std::get_if<std::vector<int64_t>>(&value)) {
+    write(*v);
+  } else {
+    throw std::logic_error("output buffers hold real vectors only");
+  }
+}
 
 }  // namespace iyfc
\ No newline at end of file
@@ -20,7 +20,10 @@
  * SOFTWARE.
  */
 #pragma once
+#include <algorithm>
+#include <complex>
 #include <memory>
+#include <string>
 #include <unordered_map>
 #include <variant>
 #include <vector>
@@ -39,6 +42,9 @@ const std::unordered_map<int, int> MAP_P2LEN = {{3, 32}, {7, 16}};
 const int CMP_BIT_LEN = MAP_P2LEN.at(CMP_P);
 const int FFT_N = MAP_P2LEN.at(CMP_P);
 const uint32_t CMP_DAG_SIZE = 16384;
+// Longer vectors are split into tiles of this size (largest SEAL CKKS slot
+// count)
+const uint32_t MAX_TILE_SIZE = 16384;
 
 // Parameters related to modular chain and algorithm library decision logic
 const uint32_t DEFAULT_SCALE = 60;
@@ -47,6 +53,16 @@ const uint32_t MAX_SEAL_BITS = 881;
 const uint32_t DEFAULT_Q_CNT = 3; // Reserved for the length of input and output modular chains. 3
 const uint32_t MAX_MULT_DEPTH_NO_BOOT = 15;
 const uint32_t LEVELS_BEFORE_BOOTSTRAP = 6;
+// SEAL BFV plaintext modulus bits without declared input ranges, and at most
+const uint32_t DEFAULT_BFV_PLAIN_BITS = 20;
+const uint32_t MAX_BFV_PLAIN_BITS = 60;
+// Bits the BFV data primes keep above the estimated noise
+const uint32_t BFV_NOISE_MARGIN_BITS = 10;
+// Bit of the BFV budget left for the rounding noise of mod switches, without
+// it every node has exactly the budget it needs and none can be switched
+const uint32_t BFV_MOD_SWITCH_SLACK_BITS = 1;
+// CKKS output precision targeted by the noise report, in bits
+const uint32_t DEFAULT_CKKS_PRECISION_BITS = 20;
 
 // Encryption pre-processing options
 enum ENCRPYT_TYPE {
@@ -60,6 +76,14 @@ enum CMP_TYPE {
   EQ = 2,
 };
 
+// Encryption mode of cipher inputs
+enum ENCRYPT_MODE {
+  PUBLIC_KEY_MODE = 0,  // Public-key encryption (default)
+  SYMMETRIC_MODE = 1,   // Secret-key encryption, requires the secret key on
+                        // the client. SEAL serializes the ciphertexts seeded,
+                        // about half the size
+};
+
 // Serialize stream by type
 enum SERIALIZE_DATA_TYPE {
   // ToDo  add other types
@@ -72,11 +96,184 @@ typedef std::pair<Expr, Expr>
 typedef std::shared_ptr<Node> NodePtr;
 typedef Dag* DagPtr;  // dag.h has many dependencies, so it is not exposed here temporarily
 // CKKS, BFV uint8_t reserved for concrete
+// complex vectors fill the CKKS slots with both parts (seal ckks only)
 typedef std::variant<std::vector<double>, double, std::vector<int64_t>, int64_t,
-                     uint8_t>
+                     uint8_t, std::vector<std::complex<double>>>
     ValuationType;
 typedef std::unordered_map<std::string, ValuationType> Valuation;
 
+// Offline/online encryption: public-key encryptions of zero are precomputed
+// per level, online encryption is then encode + add
+struct EncryptPoolConfig {
+  uint32_t size_per_level{0};  // Pooled encryptions per level, 0 disables
+  bool refill_thread{true};    // Refill consumed entries in the background
+  std::string persist_path;    // Optional, loaded (and consumed) on enable,
+                               // remaining entries are saved on disable
+};
+
+struct EncryptPoolMetrics {
+  uint64_t hits{0};       // Encryptions served from the pool
+  uint64_t misses{0};     // Encryptions that fell back to full encryption
+  uint64_t generated{0};  // Encryptions of zero produced
+  uint64_t available{0};  // Encryptions of zero currently pooled
+};
+
+// Static noise estimate of one input or output of a compiled DAG
+struct NoiseEstimate {
+  double value_bits{0};    // log2 bound of the values, inf when unknown
+  double noise_bits{0};    // CKKS log2 error bound, BFV noise budget left
+  uint32_t min_scale{0};   // CKKS smallest scale, BFV plaintext modulus bits
+  uint32_t primes{0};      // Data primes the value holds
+  uint32_t min_primes{0};  // Data primes it needs
+};
+
+// Static noise estimate of a compiled DAG, see estimateNoise
+// CKKS recommends scales meeting the precision target, BFV the plaintext
+// modulus holding the outputs and the primes holding the noise
+struct NoiseReport {
+  std::string lib;
+  uint32_t scale{0};       // CKKS input scale, BFV plaintext modulus bits
+  uint32_t min_scale{0};   // Smallest one meeting every output
+  uint32_t primes{0};      // Data primes of the chain
+  uint32_t min_primes{0};  // Data primes the outputs need
+  uint32_t poly_modulus_degree{0};
+  std::unordered_map<std::string, NoiseEstimate> inputs;
+  std::unordered_map<std::string, NoiseEstimate> outputs;
+};
+
+// Noise of one ciphertext node measured on the secret key after execution,
+// see setNoiseCheck. CKKS measures the imaginary part of real slots.
+struct NoiseMeasurement {
+  uint64_t node_index{0};
+  std::string op;
+  double estimated_bits{0};  // CKKS log2 error bound, BFV noise budget
+  double measured_bits{0};
+};
+
+// Rescale placement of seal ckks, see setRescaleStrategy
+enum RESCALE_STRATEGY {
+  AUTO_RESCALE = 0,   // The strategy with the lower predicted cost (default)
+  EAGER_RESCALE = 1,  // Rescale a product as soon as it passes the waterline
+  LAZY_RESCALE = 2,   // Defer rescales past additions and rotations to the
+                      // next product or output, one rescale per sum
+};
+
+// Rescale placement of the last seal ckks compile, see getRescaleReport
+struct RescaleReport {
+  RESCALE_STRATEGY strategy{AUTO_RESCALE};  // Strategy applied
+  uint32_t rescales{0};      // Rescale nodes inserted
+  uint32_t scale_ups{0};     // Multiplications by 1 aligning addition scales
+  uint32_t chain_length{0};  // Rescale primes on the longest path
+  double cost{0};            // Predicted latency, see CkksParameterSearch
+  double eager_cost{0};      // Predicted latency of each candidate
+  double lazy_cost{0};
+};
+
+// Relinearization placement of the last seal compile, see getRelinReport
+struct RelinReport {
+  uint32_t relins{0};       // Relinearize nodes inserted
+  uint32_t lazy_relins{0};  // Relinearize nodes the greedy placement needs
+};
+
+// Slots kept by a partial decryption: offset, offset + stride, ...
+// count 0 keeps every stride-th slot up to the end of the vector
+// replicas > 1 extends the vector over that many vec_size replicas, as
+// packed by RequestBatcher (SEAL only)
+struct SlotSelection {
+  uint32_t offset{0};
+  uint32_t stride{1};
+  uint32_t count{0};
+  uint32_t replicas{1};
+
+  /**
+   * @brief Selected slot indices, clipped to vec_size * replicas
+   */
+  std::vector<uint32_t> indices(uint32_t vec_size) const;
+};
+
+/**
+ * @brief Keep only the given slots of a decrypted vector, in that order
+ * @param [in,out] value Decrypted output, scalars are left unchanged
+ * @param [in] indices Slot indices, see SlotSelection::indices
+ */
+void pickSlots(ValuationType &value, const std::vector<uint32_t> &indices);
+void pickSlots(ValuationType &value, const SlotSelection &slots);
+
+// Non-owning view of one input, the caller keeps the data alive until
+// encryption returns. A single value fills every slot.
+struct InputSpan {
+  const double *f64{nullptr};
+  const int64_t *i64{nullptr};
+  size_t size{0};
+
+  InputSpan() {}
+  InputSpan(const double *data, size_t len) : f64(data), size(len) {}
+  InputSpan(const int64_t *data, size_t len) : i64(data), size(len) {}
+};
+typedef std::unordered_map<std::string, InputSpan> InputSpans;
+
+// Caller-owned buffer for one output, size is set to the number of slots
+// written (at most capacity)
+struct OutputBuffer {
+  double *f64{nullptr};
+  int64_t *i64{nullptr};
+  size_t capacity{0};
+  size_t size{0};
+
+  OutputBuffer() {}
+  OutputBuffer(double *data, size_t cap) : f64(data), capacity(cap) {}
+  OutputBuffer(int64_t *data, size_t cap) : i64(data), capacity(cap) {}
+};
+typedef std::unordered_map<std::string, OutputBuffer> OutputBuffers;
+
+/**
+ * @brief View of a real Valuation entry, empty for complex and uint8_t
+ */
+InputSpan toInputSpan(const ValuationType &value);
+
+/**
+ * @brief Number of slots after which an input repeats: vec_size, or the
+ * input size for inputs packing several vec_size replicas
+ */
+inline size_t inputPeriod(const InputSpan &in, size_t vec_size) {
+  if (in.size > vec_size && in.size % vec_size == 0) return in.size;
+  return vec_size;
+}
+
+/**
+ * @brief Convert an input into dst in one pass, repeating it every
+ * inputPeriod slots. Shorter inputs are zero padded, a single value fills
+ * every slot.
+ */
+template <typename T>
+void fillSlots(const InputSpan &in, T *dst, size_t dst_size,
+               size_t vec_size) {
+  auto fill = [&](auto *src) {
+    if (in.size == 1) {
+      std::fill(dst, dst + dst_size, static_cast<T>(src[0]));
+      return;
+    }
+    size_t period = std::min(inputPeriod(in, vec_size), dst_size);
+    size_t copy_cnt = std::min(in.size, period);
+    for (size_t i = 0; i < copy_cnt; ++i) dst[i] = static_cast<T>(src[i]);
+    std::fill(dst + copy_cnt, dst + period, T(0));
+    for (size_t i = period; i < dst_size; ++i) dst[i] = dst[i - period];
+  };
+  if (in.f64) {
+    fill(in.f64);
+  } else if (in.i64) {
+    fill(in.i64);
+  } else {
+    std::fill(dst, dst + dst_size, T(0));
+  }
+}
+
+/**
+ * @brief Copy a decrypted vector into a caller-owned buffer, converting the
+ * element type
+ */
+void writeOutput(const ValuationType &value, OutputBuffer &buffer);
+
 // Parameters related to DAG serialization
 class IYFC_SO_EXPORT DagSerializePara {
  public:
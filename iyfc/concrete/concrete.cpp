@@ -29,6 +29,7 @@
 #include "concrete.h"
 #include "util/overloaded.h"
 #include "concrete_executor.h"
+#include "util/thread_util.h"
 
 namespace iyfc {
 
@@ -36,29 +37,38 @@ unique_ptr<ConcreteValuation> ConcreteSecret::encrypt(
     const Valuation &variant_inputs) {
 
   auto concret_input = make_unique<ConcreteValuation>();
-
+  std::vector<const Valuation::value_type *> items;
   for (auto &in : variant_inputs) {
-        auto name = in.first; 
-        // uint8_t
-        auto &v = get<uint8_t>(in.second);
-        // Currently only supports shortint4.
-        if (v > 15) {
-          warn("only support uint2(<15) div");
-          return {};
-        }
-        if (!m_client_key) {
-          warn("encrypt m_client_key null ");
-          return {};
-        }
-        (*concret_input)[name] =
-            std::make_shared<ConcreteCipher>(c_try_encrypt(m_client_key, v));
-      }
+    // uint8_t
+    auto &v = get<uint8_t>(in.second);
+    // Currently only supports shortint4.
+    if (v > 15) {
+      warn("only support uint2(<15) div");
+      return {};
+    }
+    items.push_back(&in);
+  }
+  if (!items.empty() && !m_client_key) {
+    warn("encrypt m_client_key null ");
+    return {};
+  }
+  // The client key is read-only during encryption, inputs run concurrently
+  std::vector<std::shared_ptr<ConcreteCipher>> ciphers(items.size());
+  parallelFor(items.size(), [&](size_t idx, size_t) {
+    ciphers[idx] = std::make_shared<ConcreteCipher>(
+        c_try_encrypt(m_client_key, get<uint8_t>(items[idx]->second)));
+  });
+  for (size_t i = 0; i < items.size(); i++) {
+    (*concret_input)[items[i]->first] = ciphers[i];
+  }
   return concret_input;
 }
 
 std::unique_ptr<Valuation> ConcreteSecret::decrypt(
     const ConcreteValuation &enc_outputs) {
   auto outputs = std::make_unique<Valuation>();
+  std::vector<const std::shared_ptr<ConcreteCipher> *> ciphers;
+  std::vector<std::string> names;
   for (auto &out : enc_outputs) {
     auto name = out.first;
     visit(Overloaded{[&](const std::shared_ptr<ConcreteCipher> &cipher) {
@@ -70,13 +80,19 @@ std::unique_ptr<Valuation> ConcreteSecret::decrypt(
                          warn("m_client_key null");
                          return;
                        }
-                       uint8_t value =
-                           c_decrypt(m_client_key, cipher->m_fhe_value);
-                       (*outputs)[name] = value;
+                       ciphers.push_back(&cipher);
+                       names.push_back(name);
                      },
                      [&](const uint8_t &plain) { (*outputs)[name] = plain; }},
           out.second);
   }
+  std::vector<uint8_t> values(ciphers.size());
+  parallelFor(ciphers.size(), [&](size_t idx, size_t) {
+    values[idx] = c_decrypt(m_client_key, (*ciphers[idx])->m_fhe_value);
+  });
+  for (size_t i = 0; i < names.size(); i++) {
+    (*outputs)[names[i]] = values[i];
+  }
   return outputs;
 }
 
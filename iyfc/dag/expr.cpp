@@ -27,6 +27,8 @@
 
 #include <algorithm>
 #include <iostream>
+#include <map>
+#include <stdexcept>
 
 #include "iyfc_dag.h"
 #include "node.h"
@@ -711,6 +713,128 @@ Expr IYFC_SO_EXPORT QuerySum(const Expr &lhs, const Expr &rhs) {
 
 Expr IYFC_SO_EXPORT QueryCnt(const Expr &lhs) { return SumCntHelper(lhs); }
 
+// Rotate by a signed slot offset, positive offsets rotate left
+static Expr rotateBySlots(const Expr &lhs, int32_t offset) {
+  if (offset > 0) return lhs << uint32_t(offset);
+  if (offset < 0) return lhs >> uint32_t(-offset);
+  return lhs;
+}
+
+/**
+ * @brief Shared lowering of Conv1D/Conv2D
+ * @details out(i, j) = sum kernel[ky][kx] * x(i*s + ky - p, j*s + kx - p).
+ *          Baby steps rotate the input by the column offsets once, each kernel
+ *          row multiplies them by masks pre-rotated by the row offset, and the
+ *          row partial sum takes one giant-step rotation.
+ */
+static Expr ConvHelper(const Expr &input, uint32_t in_height,
+                       uint32_t in_width, const vector<vector<double>> &kernel,
+                       uint32_t stride_h, uint32_t stride_w, uint32_t pad_h,
+                       uint32_t pad_w) {
+  if (kernel.empty() || kernel[0].empty()) {
+    throw std::logic_error("conv kernel is empty");
+  }
+  uint32_t kh = kernel.size();
+  uint32_t kw = kernel[0].size();
+  for (auto &row : kernel) {
+    if (row.size() != kw) {
+      throw std::logic_error("conv kernel rows have different sizes");
+    }
+  }
+  if (stride_h == 0 || stride_w == 0) {
+    throw std::logic_error("conv stride must be positive");
+  }
+  if (2 * pad_h >= kh || 2 * pad_w >= kw) {
+    throw std::logic_error("conv padding must be less than half kernel size");
+  }
+  if (in_height + 2 * pad_h < kh || in_width + 2 * pad_w < kw) {
+    throw std::logic_error("conv kernel is larger than the padded input");
+  }
+  uint32_t vec_size = input.m_dag->getVecSize();
+  if (uint64_t(in_height) * in_width > vec_size) {
+    throw std::logic_error("conv input does not fit into vec size " +
+                           std::to_string(vec_size));
+  }
+
+  uint32_t out_h = (in_height + 2 * pad_h - kh) / stride_h + 1;
+  uint32_t out_w = (in_width + 2 * pad_w - kw) / stride_w + 1;
+
+  // Baby steps, one rotation per distinct column offset
+  std::map<int32_t, Expr> baby_steps;
+  Expr result;
+  bool has_result = false;
+  for (uint32_t ky = 0; ky < kh; ky++) {
+    int32_t dy = int32_t(ky) - int32_t(pad_h);
+    int32_t row_offset = dy * int32_t(in_width);
+    Expr row_sum;
+    bool has_row = false;
+    for (uint32_t kx = 0; kx < kw; kx++) {
+      double weight = kernel[ky][kx];
+      if (weight == 0.0) continue;
+      int32_t dx = int32_t(kx) - int32_t(pad_w);
+
+      // Mask of the output anchors whose tap stays inside the image, rotated
+      // right by the row offset so that the giant step lines it up again
+      vector<double> vec_mask(vec_size, 0.0);
+      bool any_valid = false;
+      for (uint32_t i = 0; i < out_h; i++) {
+        int64_t src_r = int64_t(i) * stride_h + dy;
+        if (src_r < 0 || src_r >= in_height) continue;
+        for (uint32_t j = 0; j < out_w; j++) {
+          int64_t src_c = int64_t(j) * stride_w + dx;
+          if (src_c < 0 || src_c >= in_width) continue;
+          int64_t anchor =
+              int64_t(i) * stride_h * in_width + int64_t(j) * stride_w;
+          int64_t slot = ((anchor + row_offset) % vec_size + vec_size) % vec_size;
+          vec_mask[slot] = weight;
+          any_valid = true;
+        }
+      }
+      if (!any_valid) continue;
+
+      auto iter = baby_steps.find(dx);
+      if (iter == baby_steps.end()) {
+        iter = baby_steps.emplace(dx, rotateBySlots(input, dx)).first;
+      }
+      Expr term = vec_mask * iter->second;
+      if (has_row) {
+        row_sum += term;
+      } else {
+        row_sum = term;
+        has_row = true;
+      }
+    }
+    if (!has_row) continue;
+
+    Expr row_out = rotateBySlots(row_sum, row_offset);
+    if (has_result) {
+      result += row_out;
+    } else {
+      result = row_out;
+      has_result = true;
+    }
+  }
+  if (!has_result) {
+    // All weights are zero
+    return vector<double>(vec_size, 0.0) * input;
+  }
+  return result;
+}
+
+Expr IYFC_SO_EXPORT Conv1D(const Expr &input, uint32_t in_len,
+                           const vector<double> &kernel, uint32_t stride,
+                           uint32_t padding) {
+  return ConvHelper(input, 1, in_len, {kernel}, 1, stride, 0, padding);
+}
+
+Expr IYFC_SO_EXPORT Conv2D(const Expr &input, uint32_t in_height,
+                           uint32_t in_width,
+                           const vector<vector<double>> &kernel,
+                           uint32_t stride, uint32_t padding) {
+  return ConvHelper(input, in_height, in_width, kernel, stride, stride, padding,
+                    padding);
+}
+
 /*Multiplication depth is not enough*/
 // Expr  QueryAvg(const Expr &lhs, const Expr &rhs) {
 //   return QuerySum / SumCntHelper(rhs);
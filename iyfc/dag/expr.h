@@ -505,4 +505,41 @@ void getCmpExprP3(const Expr &input_expr, Expr &lt_result, Expr &eq_result);
  */
 void getCmpExprP7(const Expr &input_expr, Expr &lt_result, Expr &eq_result);
 
+/**
+ * @brief Construct a 1-D convolution (cross-correlation) over a packed vector
+ * @details The input holds in_len values in slots [0, in_len). Output j is
+ *          sum_t kernel[t] * x[j * stride + t - padding] and is placed at slot
+ *          j * stride, other slots are zero. Each distinct tap offset costs one
+ *          rotation, and the kernel weights are folded into a single plaintext
+ *          mask per tap, so the multiplication depth is 1.
+ * @param[in] input Packed input expression
+ * @param[in] in_len Number of valid input slots, must not exceed the vec size
+ * @param[in] kernel Kernel weights
+ * @param[in] stride Output stride
+ * @param[in] padding Zero padding on both ends, must be less than half of the kernel size
+ * @return Expr Convolution result
+ */
+Expr Conv1D(const Expr &input, uint32_t in_len, const vector<double> &kernel,
+            uint32_t stride = 1, uint32_t padding = 0);
+
+/**
+ * @brief Construct a 2-D convolution (cross-correlation) over a packed image
+ * @details The input is packed row-major, pixel (r, c) in slot r * in_width + c.
+ *          Output (i, j) is placed at slot (i * stride) * in_width + j * stride,
+ *          other slots are zero. Column rotations are shared by all kernel rows
+ *          (baby steps) and each kernel row costs one more rotation of its
+ *          partial sum (giant step), so kh + kw rotations are used instead of
+ *          kh * kw. The masks of every row are pre-rotated in plaintext.
+ * @param[in] input Packed input expression
+ * @param[in] in_height Image height
+ * @param[in] in_width Image width, in_height * in_width must not exceed the vec size
+ * @param[in] kernel Kernel weights, kernel[ky][kx], all rows of the same size
+ * @param[in] stride Output stride in both dimensions
+ * @param[in] padding Zero padding on every side, must be less than half of the kernel size
+ * @return Expr Convolution result
+ */
+Expr Conv2D(const Expr &input, uint32_t in_height, uint32_t in_width,
+            const vector<vector<double>> &kernel, uint32_t stride = 1,
+            uint32_t padding = 0);
+
 };  // namespace iyfc
@@ -20,8 +20,10 @@
  * SOFTWARE.
  */
 #include "iyfc_dag.h"
+#include <algorithm>
 #include <fstream>
 #include <sstream>
+#include "daghandler/tile_handler.h"
 #include "decision/alo_decision.h"
 #include "err_code.h"
 
@@ -53,6 +55,10 @@ Dag::Dag(std::string name, std::uint64_t vec_size)
 }
 
 Dag::~Dag() {
+  // Kept executors hold node maps registered on this DAG
+  if (m_incremental_exe && m_alo_decision != nullptr) {
+    m_alo_decision->releaseExecutor(*this);
+  }
   m_exprnode_collect.clear();
   m_outputs.clear();
   m_inputs.clear();
@@ -81,6 +87,24 @@ const std::unordered_map<std::string, NodePtr> &Dag::getOutputs() const {
 std::string Dag::getName() const { return m_dagname; }
 void Dag::setName(std::string newName) { m_dagname = newName; }
 std::uint32_t Dag::getVecSize() const { return m_vec_size; }
+std::uint32_t Dag::getLogicalVecSize() const {
+  return m_tile_cnt > 1 ? m_logical_vec_size : m_vec_size;
+}
+void Dag::setTileSize(uint32_t tile_size) {
+  if (tile_size != 0 && (tile_size & (tile_size - 1)) != 0) {
+    throw std::logic_error("tile size must be a power of two");
+  }
+  m_tile_size = tile_size;
+}
+void Dag::setIncrementalExe(bool enable) {
+  if (!enable && m_incremental_exe && m_alo_decision != nullptr) {
+    m_alo_decision->releaseExecutor(*this);
+  }
+  m_incremental_exe = enable;
+}
+void Dag::setPassProfiler(std::shared_ptr<PassProfiler> profiler) {
+  m_pass_profiler = std::move(profiler);
+}
 void Dag::setVecSize(uint32_t vec_size) { m_vec_size = vec_size; }
 std::uint32_t Dag::getNumSize() const { return m_num_size; }
 void Dag::setNumSize(uint32_t num_size) { m_num_size = num_size; }
@@ -116,13 +140,16 @@ vector<NodePtr> Dag::getSinks() const { return toNodePtrs(this->m_sinks); }
 
 //
 NodePtr Dag::makeNode(OpType op_type, const std::vector<NodePtr> &operands) {
-  auto node = std::make_shared<Node>(op_type, this);
+  auto node = std::allocate_shared<Node>(ArenaAllocator<Node>(m_node_arena),
+                                        op_type, this);
   if (operands.size() > 0) {
     node->setOperands(operands);
   }
   if (op_type == OpType::Div) m_short_int = true;
   if (op_type != OpType::Input && op_type != OpType::Output)
     collectExprNode(node);
+  // Log isolated new nodes too, their edges are logged by the node
+  noteChange(node.get());
   return node;
 }
 
@@ -218,10 +245,21 @@ void Dag::setInputScale(uint32_t scale) {
 
 void Dag::setOutPutRange(uint32_t range) {
   for (auto &entry : getOutputs()) {
-    entry.second->set<RangeAttr>(range);
+    auto declared = m_output_ranges.find(entry.first);
+    entry.second->set<RangeAttr>(
+        declared == m_output_ranges.end() ? range : declared->second);
   }
 }
 
+void Dag::setOutputRange(const std::string &name, uint32_t range) {
+  m_output_ranges[name] = range;
+}
+
+void Dag::setInputRange(const std::string &name, uint32_t range) {
+  // Tiling copies the attribute to the tiles of the input
+  getInput(name)->set<RangeAttr>(range);
+}
+
 NodePtr Dag::getInput(std::string name) const { return m_inputs.at(name); }
 
 int Dag::setOutput(const string &name, const Expr &epxr) {
@@ -234,7 +272,30 @@ int Dag::setOutput(const string &name, const Expr &epxr) {
 
 void Dag::updateNodeMapIndex() {
   for (NodeMapBase *node_map : m_node_maps) {
-    node_map->resize(m_next_node_index);
+    node_map->resizeTo(m_next_node_index);
+  }
+}
+
+uint64_t Dag::getNodeIndexBase() const {
+  // Nodes created later get at least the next index
+  return std::min(m_min_node_index, m_next_node_index);
+}
+
+void Dag::noteChange(Node *node) {
+  m_structure_version++;
+  if (m_change_logs.empty()) return;
+  // Expired for a node being destroyed, traversals skip it
+  std::weak_ptr<Node> weak = node->weak_from_this();
+  for (ChangeLog *log : m_change_logs) log->push_back(weak);
+}
+
+void Dag::watchChanges(ChangeLog *log, bool enable) {
+  if (enable) {
+    m_change_logs.push_back(log);
+  } else {
+    m_change_logs.erase(
+        std::remove(m_change_logs.begin(), m_change_logs.end(), log),
+        m_change_logs.end());
   }
 }
 
@@ -246,7 +307,7 @@ uint64_t Dag::allocateIndex() {
 }
 
 void Dag::initNodeMap(NodeMapBase &node_map) {
-  node_map.resize(m_next_node_index);
+  node_map.resizeTo(m_next_node_index);
 }
 
 void Dag::registerNodeMap(NodeMapBase *node_map) {
@@ -274,6 +335,8 @@ void Dag::collectExprNode(NodePtr node) {
 void Dag::freeNode(NodePtr &node) {}
 void Dag::setSecLevel(int level) { m_sec_level = level; }
 
+void Dag::setOutputModSwitch(bool enable) { m_output_mod_switch = enable; }
+
 template <class Attr>
 void dumpAttr(stringstream &s, Node *Node, std::string label) {
   if (Node->has<Attr>()) {
@@ -436,6 +499,9 @@ void Dag::eraseSource(Node *node) { m_sources.erase(node); }
 void Dag::eraseSinks(Node *node) { m_sinks.erase(node); }
 
 int Dag::doTranspile() {
+  if (m_tile_size > 0 && m_vec_size > m_tile_size) {
+    VectorTiler(*this, m_tile_size).run();
+  }
   m_alo_decision = std::make_shared<AloDecision>();
   // Decide algorithm
   return m_alo_decision->deLibAndAlo(*this);
@@ -445,19 +511,238 @@ int Dag::genKey() { return m_alo_decision->genKeys(*this); }
 
 int Dag::encryptInput(const Valuation &inputs, bool replace) {
   checkNullAlo();
+  if (m_tile_cnt > 1) {
+    InputSpans spans;
+    for (auto &in : inputs) {
+      spans[in.first] = toInputSpan(in.second);
+      if (spans[in.first].size == 0) {
+        throw std::logic_error("tiled input must be real: " + in.first);
+      }
+    }
+    return encryptInputSpans(spans, replace);
+  }
   return m_alo_decision->encryptInput(inputs, replace);
 }
 
-int Dag::executor() {
+int Dag::encryptInputSpans(const InputSpans &inputs, bool replace) {
+  checkNullAlo();
+  if (m_tile_cnt > 1) {
+    // Every tile views its part of the caller's vector
+    InputSpans tiles;
+    for (auto &in : inputs) {
+      for (uint32_t t = 0; t < m_tile_cnt; t++) {
+        InputSpan tile = in.second;
+        if (in.second.size > 1) {
+          size_t begin = std::min<size_t>(size_t(t) * m_vec_size, tile.size);
+          if (tile.f64) tile.f64 += begin;
+          if (tile.i64) tile.i64 += begin;
+          tile.size = std::min<size_t>(m_vec_size, in.second.size - begin);
+        }
+        tiles[in.first + "_" + std::to_string(t)] = tile;
+      }
+    }
+    return m_alo_decision->encryptInputSpans(tiles, replace);
+  }
+  return m_alo_decision->encryptInputSpans(inputs, replace);
+}
+
+int Dag::setEncryptMode(ENCRYPT_MODE mode) {
+  checkNullAlo();
+  return m_alo_decision->setEncryptMode(mode);
+}
+
+int Dag::setEncryptPool(const EncryptPoolConfig &config) {
+  checkNullAlo();
+  return m_alo_decision->setEncryptPool(config);
+}
+
+int Dag::getEncryptPoolMetrics(EncryptPoolMetrics &metrics) {
+  checkNullAlo();
+  return m_alo_decision->getEncryptPoolMetrics(metrics);
+}
+
+uint32_t Dag::getSlotCount() {
+  checkNullAlo();
+  return m_alo_decision->getSlotCount();
+}
+
+int Dag::estimateNoise(uint32_t precision_bits, NoiseReport &report) {
+  checkNullAlo();
+  return m_alo_decision->estimateNoise(*this, precision_bits, report);
+}
+
+int Dag::getNoiseMeasurements(std::vector<NoiseMeasurement> &measurements) {
+  checkNullAlo();
+  return m_alo_decision->getNoiseMeasurements(measurements);
+}
+
+int Dag::executor(const std::unordered_set<std::string> &set_inputs) {
   checkNullAlo();
-  return m_alo_decision->executor(*this);
+  m_exe_inputs.clear();
+  for (auto &name : set_inputs) {
+    if (m_tile_cnt > 1 && m_inputs.count(name) == 0) {
+      for (uint32_t t = 0; t < m_tile_cnt; t++) {
+        m_exe_inputs.insert(name + "_" + std::to_string(t));
+      }
+    } else {
+      m_exe_inputs.insert(name);
+    }
+  }
+  m_exe_outputs.clear();
+  int ret = m_alo_decision->executor(*this);
+  m_exe_inputs.clear();
+  return ret;
+}
+
+Dag::NodeSetPtr Dag::getOutputCone(
+    const std::vector<std::string> &output_names) {
+  std::vector<std::string> key;
+  for (auto &name : output_names) {
+    if (m_tile_cnt > 1 && getOutputs().count(name) == 0) {
+      for (uint32_t t = 0; t < m_tile_cnt; t++) {
+        key.push_back(name + "_" + std::to_string(t));
+      }
+    } else {
+      key.push_back(name);
+    }
+  }
+  std::sort(key.begin(), key.end());
+  key.erase(std::unique(key.begin(), key.end()), key.end());
+
+  if (m_cone_cache_version != getStructureVersion()) {
+    m_cone_cache.clear();
+    m_cone_cache_version = getStructureVersion();
+  }
+  auto iter = m_cone_cache.find(key);
+  if (iter != m_cone_cache.end()) return iter->second;
+
+  auto cone = std::make_shared<std::unordered_set<const Node *>>();
+  std::vector<const Node *> stack;
+  for (auto &name : key) {
+    auto out = getOutputs().find(name);
+    if (out == getOutputs().end()) {
+      throw std::logic_error("executorForOutputs unknown output " + name);
+    }
+    if (cone->insert(out->second.get()).second) {
+      stack.push_back(out->second.get());
+    }
+  }
+  while (!stack.empty()) {
+    const Node *node = stack.back();
+    stack.pop_back();
+    for (auto &operand : node->getOperands()) {
+      if (cone->insert(operand.get()).second) stack.push_back(operand.get());
+    }
+  }
+  LOG(LOGLEVEL::Debug, "output cone of %zu outputs: %zu nodes", key.size(),
+      cone->size());
+  m_cone_cache[key] = cone;
+  return cone;
+}
+
+int Dag::executorForOutputs(const std::vector<std::string> &output_names) {
+  m_exe_cone = getOutputCone(output_names);
+  int ret = 0;
+  try {
+    ret = executor();
+  } catch (...) {
+    m_exe_cone = nullptr;
+    throw;
+  }
+  m_exe_cone = nullptr;
+  m_exe_outputs = output_names;
+  return ret;
 }
 
 int Dag::getDecryptOutput(Valuation &valuation) {
   checkNullAlo();
+  if (m_tile_cnt > 1) {
+    // A pruned run only produced the outputs it was asked for
+    return getPartialDecryptOutput(
+        m_exe_outputs.empty() ? m_tiled_outputs : m_exe_outputs,
+        SlotSelection(), valuation);
+  }
   return m_alo_decision->getDecryptOutput(valuation);
 }
 
+/**
+ * @brief Concatenate the decrypted tiles of one output
+ */
+static ValuationType mergeTiles(const std::vector<ValuationType *> &tiles,
+                                size_t logical_size) {
+  return std::visit(
+      [&](const auto &first) -> ValuationType {
+        using V = std::decay_t<decltype(first)>;
+        if constexpr (std::is_same_v<V, double> ||
+                      std::is_same_v<V, int64_t> ||
+                      std::is_same_v<V, uint8_t>) {
+          return first;
+        } else {
+          V merged;
+          merged.reserve(logical_size);
+          for (auto *tile : tiles) {
+            auto &part = std::get<V>(*tile);
+            merged.insert(merged.end(), part.begin(), part.end());
+          }
+          merged.resize(logical_size);
+          return merged;
+        }
+      },
+      *tiles[0]);
+}
+
+int Dag::getPartialDecryptOutput(const std::vector<std::string> &names,
+                                 const SlotSelection &slots,
+                                 Valuation &valuation) {
+  checkNullAlo();
+  if (m_tile_cnt <= 1) {
+    return m_alo_decision->getPartialDecryptOutput(names, slots, valuation);
+  }
+  std::vector<std::string> tile_names;
+  for (auto &name : names) {
+    for (uint32_t t = 0; t < m_tile_cnt; t++) {
+      tile_names.push_back(name + "_" + std::to_string(t));
+    }
+  }
+  Valuation tiles;
+  int ret = m_alo_decision->getPartialDecryptOutput(tile_names,
+                                                    SlotSelection(), tiles);
+  if (ret != 0) return ret;
+  valuation.clear();
+  bool all_slots = slots.offset == 0 && slots.stride == 1 && slots.count == 0;
+  for (auto &name : names) {
+    std::vector<ValuationType *> parts;
+    for (uint32_t t = 0; t < m_tile_cnt; t++) {
+      auto iter = tiles.find(name + "_" + std::to_string(t));
+      if (iter == tiles.end()) break;
+      parts.push_back(&iter->second);
+    }
+    if (parts.size() != m_tile_cnt) continue;
+    valuation[name] = mergeTiles(parts, m_logical_vec_size);
+    if (!all_slots) pickSlots(valuation[name], slots);
+  }
+  return 0;
+}
+
+int Dag::getDecryptOutputTo(OutputBuffers &buffers,
+                            const SlotSelection &slots) {
+  checkNullAlo();
+  std::vector<std::string> names;
+  names.reserve(buffers.size());
+  for (auto &buffer : buffers) names.push_back(buffer.first);
+  Valuation valuation;
+  int ret = getPartialDecryptOutput(names, slots, valuation);
+  if (ret != 0) return ret;
+  for (auto &buffer : buffers) {
+    auto iter = valuation.find(buffer.first);
+    if (iter == valuation.end()) {
+      throw std::logic_error("output not found: " + buffer.first);
+    }
+    writeOutput(iter->second, buffer.second);
+  }
+  return 0;
+}
+
 int Dag::saveAloInfoToFile(const std::string &path) {
   if (m_alo_decision == nullptr) {
     // Decision execution separation
@@ -630,7 +915,7 @@ Valuation Dag::getDecryptOutputForPython() {
   if (m_alo_decision == nullptr) {
     throw std::logic_error("err getDecryptOutput alo_decision_ptr null");
   }
-  m_alo_decision->getDecryptOutput(valuation);
+  getDecryptOutput(valuation);
   return valuation;
 }
 
@@ -669,6 +954,8 @@ void DagGroup::addDag(const string &name, DagPtr dag) {
   this->m_vec_size = std::max(this->m_vec_size, dag->m_vec_size);
 
   m_name2dag[name] = dag;
+  if (isIncrementalExe()) dag->setIncrementalExe(true);
+  if (m_pass_profiler != nullptr) dag->setPassProfiler(m_pass_profiler);
   // Update all scales to maintain consistency
   if (dag->m_scale < m_scale) {
     m_scale = dag->m_scale;
@@ -742,6 +1029,36 @@ NodePtr DagGroup::getInput(std::string name) const {
   return m_group_inputs.at(name);
 }
 
+void DagGroup::setIncrementalExe(bool enable) {
+  Dag::setIncrementalExe(enable);
+  for (auto &item : m_name2dag) item.second->setIncrementalExe(enable);
+}
+
+void DagGroup::setPassProfiler(std::shared_ptr<PassProfiler> profiler) {
+  Dag::setPassProfiler(profiler);
+  for (auto &item : m_name2dag) item.second->setPassProfiler(profiler);
+}
+
+uint64_t DagGroup::getNodeIndexBase() const {
+  uint64_t base = Dag::getNodeIndexBase();
+  for (auto &item : m_name2dag) {
+    base = std::min(base, item.second->getNodeIndexBase());
+  }
+  return base;
+}
+
+uint64_t DagGroup::getStructureVersion() const {
+  // Versions only grow, so the sum changes with any of them
+  uint64_t version = Dag::getStructureVersion();
+  for (auto &item : m_name2dag) version += item.second->getStructureVersion();
+  return version;
+}
+
+void DagGroup::watchChanges(ChangeLog *log, bool enable) {
+  Dag::watchChanges(log, enable);
+  for (auto &item : m_name2dag) item.second->watchChanges(log, enable);
+}
+
 void DagGroup::updateGroupIndex() {
   uint64_t total_index = m_next_node_index;
   // Find the maximum index among all shared indices and update
@@ -25,6 +25,7 @@
  */
 
 #pragma once
+#include <map>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -35,6 +36,7 @@
 #include "constant_value.h"
 #include "expr.h"
 #include "node.h"
+#include "node_arena.h"
 #include "node_attr.h"
 #include "op_type.h"
 #include "proto/iyfc.pb.h"
@@ -53,8 +55,22 @@ class NodeMap;
 class NodeMapBase;
 class Expr;
 class AloDecision;
+class Dag;
 typedef std::shared_ptr<Node> NodePtr;
 
+/**
+ * @class PassProfiler
+ * @brief Observer of the compile passes run over a DAG, see
+ * Dag::setPassProfiler.
+ * @details Passes may nest, an end always follows its begin.
+ */
+class PassProfiler {
+ public:
+  virtual ~PassProfiler() {}
+  virtual void beginPass(const std::string &name, const Dag &dag) = 0;
+  virtual void endPass(const std::string &name, const Dag &dag) = 0;
+};
+
 /**
  * @class Dag
  * @brief DAG, core class, represents the IR graph composed of nodes generated
@@ -230,6 +246,124 @@ class Dag : public std::enable_shared_from_this<Dag> {
    */
   void setSecLevel(int level);
 
+  /**
+   * @brief Mod-switch every output to the lowest level that still holds its
+   * scale and range before it is serialized (CKKS only).
+   * @param[in] enable Whether to drop the spare primes of the outputs.
+   */
+  void setOutputModSwitch(bool enable);
+
+  /**
+   * @brief Declare the range in bits of one output, default is the scale.
+   * @details Smaller ranges let setOutputModSwitch drop more primes.
+   * @param[in] name Output name.
+   * @param[in] range Range of the output values in bits.
+   */
+  void setOutputRange(const std::string &name, uint32_t range);
+  const std::unordered_map<std::string, uint32_t> &getOutputRanges() const {
+    return m_output_ranges;
+  }
+
+  /**
+   * @brief Declare that the values of an input stay below 2^range in
+   * magnitude.
+   * @details BFV sizes its plaintext modulus from the input ranges and the
+   * arithmetic of the DAG. Call after setInput.
+   * @param[in] name Input name.
+   * @param[in] range Range of the input values in bits.
+   */
+  void setInputRange(const std::string &name, uint32_t range);
+
+  /**
+   * @brief Split vectors longer than tile_size into tiles when compiling.
+   * @details Inputs and outputs "x" become "x_<t>", encryptInput and the
+   * decrypt functions still take and return the whole vectors.
+   * @param[in] tile_size Power of two, 0 disables tiling. Default
+   * MAX_TILE_SIZE.
+   */
+  void setTileSize(uint32_t tile_size);
+
+  /**
+   * @brief Vector size given by the user, larger than getVecSize() once the
+   * DAG is tiled.
+   */
+  std::uint32_t getLogicalVecSize() const;
+
+  /**
+   * @brief Number of tiles, 1 if the DAG is not tiled.
+   */
+  std::uint32_t getTileCnt() const { return m_tile_cnt; }
+
+  /**
+   * @brief Keep intermediate values between executions and recompute only
+   * the nodes that depend on inputs encrypted since the last run.
+   * @details Holds every intermediate ciphertext in memory and disables
+   * in-place evaluation. A DagGroup applies it to its children.
+   */
+  virtual void setIncrementalExe(bool enable);
+  bool isIncrementalExe() const { return m_incremental_exe; }
+
+  /**
+   * @brief Nodes the last incremental execution recomputed, changed inputs
+   * included. Every node of the DAG for a full run.
+   */
+  void setRecomputedCnt(size_t cnt) { m_recomputed_cnt = cnt; }
+  size_t getRecomputedCnt() const { return m_recomputed_cnt; }
+
+  /**
+   * @brief Measure the noise of every ciphertext on the secret key during
+   * execution, next to its static estimate, see getNoiseMeasurements.
+   * @details For debugging parameters, each node costs a decryption.
+   */
+  void setNoiseCheck(bool enable) { m_noise_check = enable; }
+  bool isNoiseCheck() const { return m_noise_check; }
+
+  /**
+   * @brief Rescale placement of seal ckks, AUTO_RESCALE picks the strategy
+   * with the lower predicted cost.
+   */
+  void setRescaleStrategy(RESCALE_STRATEGY strategy) {
+    m_rescale_strategy = strategy;
+  }
+  RESCALE_STRATEGY getRescaleStrategy() const { return m_rescale_strategy; }
+
+  /**
+   * @brief Rescale placement chosen by the last seal ckks compile.
+   */
+  void setRescaleReport(const RescaleReport &report) {
+    m_rescale_report = report;
+  }
+  const RescaleReport &getRescaleReport() const { return m_rescale_report; }
+
+  /**
+   * @brief Relinearization placement of the last seal compile.
+   */
+  void setRelinReport(const RelinReport &report) { m_relin_report = report; }
+  const RelinReport &getRelinReport() const { return m_relin_report; }
+
+  /**
+   * @brief Report every traversal and type update over the DAG to profiler,
+   * nullptr to stop. A DagGroup applies it to its children.
+   */
+  virtual void setPassProfiler(std::shared_ptr<PassProfiler> profiler);
+  PassProfiler *getPassProfiler() const { return m_pass_profiler.get(); }
+
+  /**
+   * @brief Inputs given to the running executor call, empty when all inputs
+   * may have changed.
+   */
+  const std::unordered_set<std::string> &getExeInputs() const {
+    return m_exe_inputs;
+  }
+
+  /**
+   * @brief Whether the running executor call has to evaluate the node, false
+   * outside the backward cone of the outputs given to executorForOutputs.
+   */
+  bool inExeCone(const Node &node) const {
+    return m_exe_cone == nullptr || m_exe_cone->count(&node) > 0;
+  }
+
   /**
    * @brief Get the number of slots.
    * @return The number of slots.
@@ -308,6 +442,29 @@ class Dag : public std::enable_shared_from_this<Dag> {
    */
   void updateNodeMapIndex();
 
+  /**
+   * @brief Lowest node index a nodemap created now has to hold.
+   */
+  virtual uint64_t getNodeIndexBase() const;
+
+  /**
+   * @brief Arena the nodes of the DAG are allocated from.
+   */
+  const NodeArena &getNodeArena() const { return *m_node_arena; }
+
+  /**
+   * @brief Version of the graph structure, bumped whenever a node or an
+   * edge is added or removed. Caches of the graph shape compare it.
+   */
+  virtual uint64_t getStructureVersion() const { return m_structure_version; }
+
+  typedef std::vector<std::weak_ptr<Node>> ChangeLog;
+  /**
+   * @brief Start or stop logging the nodes whose edges change, and the new
+   * nodes, into log. Nodes destroyed meanwhile are logged as expired.
+   */
+  virtual void watchChanges(ChangeLog *log, bool enable);
+
   /**
    * @brief Set the index value for the next node in the DAG.
    * @param next_node_index The new index value for the next node.
@@ -336,11 +493,68 @@ class Dag : public std::enable_shared_from_this<Dag> {
    */
   int encryptInput(const Valuation &inputs, bool replace);
 
+  /**
+   * @brief Encrypt caller-owned inputs without copying them.
+   * @param inputs Input views, valid until the call returns.
+   * @param replace Whether to replace all existing inputs.
+   * @return 0 if encryption is successful.
+   */
+  int encryptInputSpans(const InputSpans &inputs, bool replace);
+
+  /**
+   * @brief Select public-key or symmetric encryption of cipher inputs.
+   * @param mode SYMMETRIC_MODE requires the secret context.
+   * @return 0 if successful.
+   */
+  int setEncryptMode(ENCRYPT_MODE mode);
+
+  /**
+   * @brief Configure the offline/online encryption pool, call after genKey.
+   * @param config Pool size, refill thread and persistence options.
+   * @return 0 if successful.
+   */
+  int setEncryptPool(const EncryptPoolConfig &config);
+
+  /**
+   * @brief Get the metrics of the offline/online encryption pool.
+   */
+  int getEncryptPoolMetrics(EncryptPoolMetrics &metrics);
+
+  /**
+   * @brief Slots of one ciphertext of the decided library, 0 if inputs are
+   * not replicated across them.
+   */
+  uint32_t getSlotCount();
+
+  /**
+   * @brief Static noise and precision estimate, call after compiling.
+   * @param precision_bits CKKS output precision to recommend scales for.
+   * @return 0 if successful.
+   */
+  int estimateNoise(uint32_t precision_bits, NoiseReport &report);
+
+  /**
+   * @brief Noise measured by the last execution, see setNoiseCheck.
+   * @return 0 if successful.
+   */
+  int getNoiseMeasurements(std::vector<NoiseMeasurement> &measurements);
+
   /**
    * @brief Execute.
+   * @param set_inputs Inputs changed since the last run, only used by
+   * incremental execution. Empty to detect them from the encryptions.
    * @return 0 if execution is successful.
    */
-  int executor();
+  int executor(const std::unordered_set<std::string> &set_inputs = {});
+
+  /**
+   * @brief Execute only the nodes the given outputs depend on.
+   * @details The pruned node set is cached per output subset. Only the
+   * given outputs are produced, getDecryptOutput then returns just them.
+   * @param output_names Outputs to compute.
+   * @return 0 if execution is successful.
+   */
+  int executorForOutputs(const std::vector<std::string> &output_names);
 
   /**
    * @brief Decrypt the results.
@@ -349,6 +563,25 @@ class Dag : public std::enable_shared_from_this<Dag> {
    */
   int getDecryptOutput(Valuation &valuation);
 
+  /**
+   * @brief Decrypt only the named results and only the selected slots.
+   * @param names Outputs to decrypt, others are skipped.
+   * @param slots Slots to keep, in SlotSelection order.
+   * @param valuation Valuation& Plain results.
+   * @return 0 if execution is successful.
+   */
+  int getPartialDecryptOutput(const std::vector<std::string> &names,
+                              const SlotSelection &slots,
+                              Valuation &valuation);
+
+  /**
+   * @brief Decrypt the results into caller-owned buffers.
+   * @param buffers Outputs to decrypt, each size is set to the slots written.
+   * @param slots Slots to keep, in SlotSelection order.
+   * @return 0 if execution is successful.
+   */
+  int getDecryptOutputTo(OutputBuffers &buffers, const SlotSelection &slots);
+
   /**
    * @brief Decrypt the results for Python interface.
    */
@@ -452,7 +685,15 @@ class Dag : public std::enable_shared_from_this<Dag> {
   bool m_short_int{false};  // Includes short_int division
   bool m_has_int64{false};
   bool m_has_double{true};         // Default to using CKKS
+  bool m_has_complex{false};       // Has complex-slot inputs, seal ckks only
   bool m_enable_bootstrap{false};  // Whether bootstrapping is needed
+  bool m_output_mod_switch{false};  // Drop spare primes of the outputs
+  // Tiling of long vectors, set by VectorTiler
+  uint32_t m_tile_size{MAX_TILE_SIZE};
+  uint32_t m_tile_cnt{1};
+  uint32_t m_logical_vec_size{0};
+  std::vector<std::string> m_tiled_inputs;   // Names before tiling
+  std::vector<std::string> m_tiled_outputs;  // Names before tiling
   uint32_t m_after_reduction_depth{
       0};  // Multiplication depth after rebalancing
   uint32_t m_scale{DEFAULT_SCALE};
@@ -541,6 +782,36 @@ class Dag : public std::enable_shared_from_this<Dag> {
   // DAG multidepth
   void setInputScale(uint32_t scale);
   void setOutPutRange(uint32_t range);
+  // Ranges declared per output, override setOutPutRange
+  std::unordered_map<std::string, uint32_t> m_output_ranges;
+  bool m_incremental_exe{false};
+  size_t m_recomputed_cnt{0};
+  bool m_noise_check{false};
+  RESCALE_STRATEGY m_rescale_strategy{AUTO_RESCALE};
+  RescaleReport m_rescale_report;
+  RelinReport m_relin_report;
+  std::shared_ptr<PassProfiler> m_pass_profiler;
+  std::unordered_set<std::string> m_exe_inputs;
+  typedef std::shared_ptr<const std::unordered_set<const Node *>> NodeSetPtr;
+  /**
+   * @brief Backward cone of the outputs, cached per sorted output subset
+   * until nodes are added to the DAG.
+   */
+  NodeSetPtr getOutputCone(const std::vector<std::string> &output_names);
+  NodeSetPtr m_exe_cone;
+  std::vector<std::string> m_exe_outputs;  // Outputs of the last pruned run
+  std::map<std::vector<std::string>, NodeSetPtr> m_cone_cache;
+  std::uint64_t m_cone_cache_version{0};
+  /**
+   * @brief Bump the structure version and log the node to the traversals
+   * watching the DAG.
+   */
+  void noteChange(Node *node);
+  std::vector<ChangeLog *> m_change_logs;
+  std::uint64_t m_structure_version{0};
+  // Forward topological order, valid while the structure version matches
+  std::shared_ptr<const std::vector<Node *>> m_topo_order;
+  std::uint64_t m_topo_order_version{0};
   /**
    * @brief Allocate an index for a new node in the DAG.
    * @return The allocated node index.
@@ -560,12 +831,15 @@ class Dag : public std::enable_shared_from_this<Dag> {
   std::unordered_map<uint64_t, NodePtr> m_exprnode_collect;
   NodePtr m_last_exprnode = nullptr;
   std::vector<NodeMapBase *> m_node_maps;
+  std::shared_ptr<NodeArena> m_node_arena{std::make_shared<NodeArena>()};
 
   friend class Expr;
   friend class Node;
   friend class NodeMapBase;
   friend class AloDecision;
   friend class DagGroup;
+  friend class VectorTiler;
+  friend class DagTraversal;
 
   /**
    * @brief Serialize the DAG.
@@ -647,6 +921,11 @@ class DagGroup : public Dag {
    */
   virtual void updateGroupIndex();
   virtual NodePtr getInput(std::string name) const;
+  virtual void setIncrementalExe(bool enable);
+  virtual void setPassProfiler(std::shared_ptr<PassProfiler> profiler);
+  virtual uint64_t getStructureVersion() const;
+  virtual uint64_t getNodeIndexBase() const;
+  virtual void watchChanges(ChangeLog *log, bool enable);
 
   /**
    * @brief Get a child DAG by name
@@ -679,4 +958,28 @@ class DagGroup : public Dag {
 
 std::unique_ptr<DagGroup> deserialize(const msg::DagGroup &);
 
+/**
+ * @class PassScope
+ * @brief Reports one pass to the profiler of the DAG while it is alive.
+ */
+class PassScope {
+ public:
+  PassScope(const Dag &dag, const std::string &name)
+      : m_dag(dag), m_profiler(dag.getPassProfiler()) {
+    if (m_profiler == nullptr) return;
+    m_name = name;
+    m_profiler->beginPass(m_name, m_dag);
+  }
+  ~PassScope() {
+    if (m_profiler != nullptr) m_profiler->endPass(m_name, m_dag);
+  }
+  PassScope(const PassScope &) = delete;
+  PassScope &operator=(const PassScope &) = delete;
+
+ private:
+  const Dag &m_dag;
+  PassProfiler *m_profiler;
+  std::string m_name;
+};
+
 }  // namespace iyfc
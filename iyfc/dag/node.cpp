@@ -33,6 +33,8 @@ Node::Node(OpType op, Dag *dag)
     : m_op_type(op), m_dag(dag), m_index(dag->allocateIndex()) {
   m_dag->m_sources.insert(this);
   m_dag->m_sinks.insert(this);
+  // Dag::makeNode logs the node once it is owned by a shared_ptr
+  m_dag->m_structure_version++;
 }
 
 Node::~Node() {
@@ -47,6 +49,7 @@ Node::~Node() {
       m_dag->m_sources.erase(this);
     }
     if (m_uses.empty()) m_dag->m_sinks.erase(this);
+    m_dag->m_structure_version++;
   }
 }
 
@@ -155,12 +158,16 @@ void Node::addUse(Node *node) {
     m_dag->m_sinks.erase(this);
   }
   m_uses.emplace_back(node);
+  m_dag->noteChange(this);
+  node->m_dag->noteChange(node);
 }
 
 bool Node::eraseUse(Node *node) {
   auto iter = find(m_uses.begin(), m_uses.end(), node);
   if (iter != m_uses.end()) {
     m_uses.erase(iter);
+    m_dag->noteChange(this);
+    node->m_dag->noteChange(node);
     if (m_uses.empty()) {
       m_dag->m_sinks.insert(this);
       return true;
@@ -0,0 +1,148 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace iyfc {
+
+/**
+ * @class NodeArena
+ * @brief Slab allocator for the nodes of one DAG.
+ * @details Nodes and their shared_ptr control blocks are carved from blocks
+ * of contiguous slots, so passes walking the DAG touch fewer cache lines.
+ * Freed slots are reused by later nodes. The first allocation fixes the
+ * slot size, other sizes fall back to the global heap. Like the rest of the
+ * DAG it is not thread safe.
+ */
+class NodeArena {
+ public:
+  explicit NodeArena(std::size_t block_slots = 256)
+      : m_block_slots(block_slots) {}
+  NodeArena(const NodeArena &) = delete;
+  NodeArena &operator=(const NodeArena &) = delete;
+
+  void *allocate(std::size_t bytes) {
+    if (m_slot_size == 0) m_slot_size = roundUp(bytes);
+    if (roundUp(bytes) != m_slot_size) return ::operator new(bytes);
+    m_live_cnt++;
+    if (m_free_list != nullptr) {
+      FreeSlot *slot = m_free_list;
+      m_free_list = slot->next;
+      return slot;
+    }
+    if (m_blocks.empty() || m_block_used == m_block_slots) {
+      m_blocks.emplace_back(new char[m_slot_size * m_block_slots]);
+      m_block_used = 0;
+    }
+    return m_blocks.back().get() + m_slot_size * m_block_used++;
+  }
+
+  void deallocate(void *ptr, std::size_t bytes) {
+    if (roundUp(bytes) != m_slot_size) {
+      ::operator delete(ptr);
+      return;
+    }
+    m_live_cnt--;
+    FreeSlot *slot = static_cast<FreeSlot *>(ptr);
+    slot->next = m_free_list;
+    m_free_list = slot;
+  }
+
+  /**
+   * @brief Nodes currently allocated from the arena
+   */
+  std::size_t liveCnt() const { return m_live_cnt; }
+  /**
+   * @brief Bytes reserved by the arena blocks
+   */
+  std::size_t reservedBytes() const {
+    return m_blocks.size() * m_block_slots * m_slot_size;
+  }
+
+ private:
+  struct FreeSlot {
+    FreeSlot *next;
+  };
+
+  static std::size_t roundUp(std::size_t bytes) {
+    const std::size_t align = alignof(std::max_align_t);
+    bytes = bytes < sizeof(FreeSlot) ? sizeof(FreeSlot) : bytes;
+    return (bytes + align - 1) / align * align;
+  }
+
+  std::size_t m_block_slots;
+  std::size_t m_slot_size{0};
+  std::size_t m_block_used{0};
+  std::size_t m_live_cnt{0};
+  FreeSlot *m_free_list{nullptr};
+  std::vector<std::unique_ptr<char[]>> m_blocks;
+};
+
+/**
+ * @class ArenaAllocator
+ * @brief Allocator handed to std::allocate_shared. Every control block keeps
+ * the arena alive, as nodes may outlive their DAG.
+ */
+template <class T>
+class ArenaAllocator {
+ public:
+  typedef T value_type;
+
+  explicit ArenaAllocator(std::shared_ptr<NodeArena> arena)
+      : m_arena(std::move(arena)) {}
+  template <class U>
+  ArenaAllocator(const ArenaAllocator<U> &other) : m_arena(other.m_arena) {}
+
+  T *allocate(std::size_t n) {
+    if (n != 1) return static_cast<T *>(::operator new(n * sizeof(T)));
+    return static_cast<T *>(m_arena->allocate(sizeof(T)));
+  }
+
+  void deallocate(T *ptr, std::size_t n) {
+    if (n != 1) {
+      ::operator delete(ptr);
+      return;
+    }
+    m_arena->deallocate(ptr, sizeof(T));
+  }
+
+  template <class U>
+  bool operator==(const ArenaAllocator<U> &other) const {
+    return m_arena == other.m_arena;
+  }
+  template <class U>
+  bool operator!=(const ArenaAllocator<U> &other) const {
+    return m_arena != other.m_arena;
+  }
+
+ private:
+  std::shared_ptr<NodeArena> m_arena;
+  template <class U>
+  friend class ArenaAllocator;
+};
+
+}  // namespace iyfc
@@ -79,7 +79,8 @@ struct Attr {
   X(RangeAttr, std::uint32_t)                                     \
   X(BoolAttr, std::uint32_t)                                      \
   X(EncodeAtScaleAttr, std::uint32_t)                             \
-  X(EncodeAtLevelAttr, std::uint32_t)
+  X(EncodeAtLevelAttr, std::uint32_t)                             \
+  X(ComplexAttr, std::uint32_t)
 
 // Enumeration for attribute type indices
 namespace detail {
@@ -24,7 +24,6 @@
 #pragma once
 #include <cstddef>
 #include <cstdint>
-#include <deque>
 #include <iostream>
 #include <optional>
 #include <variant>
@@ -39,10 +38,13 @@ namespace iyfc {
  */
 class NodeMapBase {
  public:
-  NodeMapBase(Dag &g) : m_dag(&g) { m_dag->registerNodeMap(this); }
+  NodeMapBase(Dag &g) : m_dag(&g), m_base(g.getNodeIndexBase()) {
+    m_dag->registerNodeMap(this);
+  }
   virtual ~NodeMapBase() { m_dag->unregisterNodeMap(this); }
 
-  NodeMapBase(const NodeMapBase &other) : m_dag(other.m_dag) {
+  NodeMapBase(const NodeMapBase &other)
+      : m_dag(other.m_dag), m_base(other.m_base) {
     m_dag->registerNodeMap(this);
   }
   NodeMapBase &operator=(const NodeMapBase &other) = default;
@@ -56,11 +58,28 @@ class NodeMapBase {
   */
   void init() { m_dag->initNodeMap(*this); }
 
-  std::uint64_t getIndex(const Node &node) const { return node.m_index; }
+  /**
+   * @brief Dense slot of the node. Indices below the base belong to nodes
+   * of other DAGs, a DagGroup hands its children index ranges far apart.
+   */
+  std::uint64_t getIndex(const Node &node) const {
+    return node.m_index - m_base;
+  }
+
+  bool inRange(const Node &node, std::size_t size) const {
+    return node.m_index >= m_base && node.m_index - m_base < size;
+  }
 
  private:
   virtual void resize(std::size_t size) = 0;
+  /**
+   * @brief Resize to hold the nodes indexed below next_index.
+   */
+  void resizeTo(std::uint64_t next_index) {
+    resize(next_index > m_base ? next_index - m_base : 0);
+  }
   Dag *m_dag;
+  std::uint64_t m_base;  // Lowest node index the map holds
 };
 
 /**
@@ -83,6 +102,11 @@ class NodeMap : NodeMapBase {
 
   std::size_t size() const { return m_values.size(); }
 
+  /**
+   * @brief Whether the node has a slot in the map.
+   */
+  bool covers(const Node &node) const { return inRange(node, size()); }
+
   TValue &operator[](const NodePtr &Node) { return this->operator[](*Node); }
 
   // const TValue &operator[](const NodePtr &Node);
@@ -91,8 +115,8 @@ class NodeMap : NodeMapBase {
 
  private:
   void resize(std::size_t size) override { m_values.resize(size); }
-  // deque can be inserted at both ends
-  std::deque<TValue> m_values;
+  // Flat storage, references into it do not survive a node creation
+  std::vector<TValue> m_values;
 };
 
 /**
@@ -122,6 +146,8 @@ class NodeMap<bool> : NodeMapBase {
 
   bool operator[](const NodePtr &node) const { return this->operator[](*node); }
 
+  bool covers(const Node &node) const { return inRange(node, size()); }
+
   void clear() { m_values.assign(m_values.size(), false); }
 
  private:
@@ -170,7 +196,7 @@ class NodeMapOptional : NodeMapBase {
  private:
   void resize(std::size_t size) override { m_values.resize(size); }
 
-  std::deque<std::optional<TOptionalValue>> m_values;
+  std::vector<std::optional<TOptionalValue>> m_values;
 };
 
 }  // namespace iyfc
@@ -0,0 +1,220 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "request_batcher.h"
+
+#include "daghandler/ckks_rotation_keys_handler.h"
+#include "iyfc_dag.h"
+#include "util/logging.h"
+
+namespace iyfc {
+
+/**
+ * @brief Replica r of a decrypted output, outputs that were not packed
+ * (raw constants) hold one replica only
+ */
+static ValuationType sliceReplica(const ValuationType &value, uint32_t r,
+                                  uint32_t vec_size) {
+  return std::visit(
+      [&](const auto &v) -> ValuationType {
+        using V = std::decay_t<decltype(v)>;
+        if constexpr (std::is_same_v<V, double> ||
+                      std::is_same_v<V, int64_t> ||
+                      std::is_same_v<V, uint8_t>) {
+          return v;
+        } else {
+          size_t begin = size_t(r) * vec_size;
+          if (v.size() < begin + vec_size) begin = 0;
+          size_t end = std::min(begin + vec_size, v.size());
+          return V(v.begin() + begin, v.begin() + end);
+        }
+      },
+      value);
+}
+
+RequestBatcher::RequestBatcher(DagPtr dag, const BatchConfig &config)
+    : m_dag(dag), m_config(config) {
+  if (m_dag == nullptr) {
+    throw std::logic_error("RequestBatcher dag null");
+  }
+  m_vec_size = m_dag->getLogicalVecSize();
+  uint32_t slot_count = m_dag->getSlotCount();
+  // Tiled DAGs fill their slots already
+  if (m_dag->getTileCnt() <= 1 && slot_count >= m_vec_size) {
+    m_replicas = slot_count / m_vec_size;
+  }
+  if (m_replicas > 1 && !collectRotationSteps(*m_dag).empty()) {
+    LOG(LOGLEVEL::Debug,
+        "RequestBatcher: rotations mix replicas, one request per batch");
+    m_replicas = 1;
+  }
+  m_capacity = m_replicas;
+  if (m_config.max_batch > 0) {
+    m_capacity = std::min(m_capacity, m_config.max_batch);
+  }
+  m_worker = std::thread(&RequestBatcher::workLoop, this);
+}
+
+RequestBatcher::~RequestBatcher() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_cv.notify_all();
+  // The worker drains the queue before it exits
+  m_worker.join();
+}
+
+std::future<Valuation> RequestBatcher::submit(Valuation inputs) {
+  std::set<std::string> names;
+  for (auto &in : inputs) {
+    InputSpan span = toInputSpan(in.second);
+    if ((span.f64 == nullptr && span.i64 == nullptr) ||
+        (span.size != 1 && span.size != m_vec_size)) {
+      throw std::logic_error("RequestBatcher input not match: " + in.first);
+    }
+    names.insert(in.first);
+  }
+
+  Request request;
+  request.inputs = std::move(inputs);
+  request.enqueued = std::chrono::steady_clock::now();
+  auto result = request.result.get_future();
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_input_names.empty()) {
+      m_input_names = names;
+    } else if (names != m_input_names) {
+      throw std::logic_error("RequestBatcher requests must share input names");
+    }
+    m_queue.push_back(std::move(request));
+  }
+  m_cv.notify_one();
+  return result;
+}
+
+void RequestBatcher::flush() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_flush = true;
+  }
+  m_cv.notify_one();
+}
+
+uint64_t RequestBatcher::batchesRun() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_batches;
+}
+
+void RequestBatcher::workLoop() {
+  while (true) {
+    std::vector<Request> batch;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cv.wait(lock, [&] { return m_stop || !m_queue.empty(); });
+      if (m_queue.empty()) return;
+      auto deadline = m_queue.front().enqueued +
+                      std::chrono::milliseconds(m_config.max_latency_ms);
+      m_cv.wait_until(lock, deadline, [&] {
+        return m_stop || m_flush || m_queue.size() >= m_capacity;
+      });
+      size_t cnt = std::min<size_t>(m_capacity, m_queue.size());
+      for (size_t i = 0; i < cnt; ++i) {
+        batch.push_back(std::move(m_queue.front()));
+        m_queue.pop_front();
+      }
+      if (m_queue.empty()) m_flush = false;
+    }
+    std::vector<Valuation> results;
+    std::exception_ptr error;
+    try {
+      results = runBatch(batch);
+    } catch (...) {
+      error = std::current_exception();
+    }
+    // Counted before any caller sees its result
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_batches++;
+    }
+    for (size_t r = 0; r < batch.size(); ++r) {
+      if (error) {
+        batch[r].result.set_exception(error);
+      } else {
+        batch[r].result.set_value(std::move(results[r]));
+      }
+    }
+  }
+}
+
+std::vector<Valuation> RequestBatcher::runBatch(std::vector<Request> &batch) {
+  // Request r fills replica r, the unused replicas stay zero. Without
+  // packing the inputs keep their vec_size and are replicated as usual.
+  size_t packed_size = size_t(m_replicas) * m_vec_size;
+  Valuation packed;
+  for (auto &name : m_input_names) {
+    bool is_int = false;
+    std::visit(
+        [&](const auto &v) {
+          using V = std::decay_t<decltype(v)>;
+          is_int = std::is_same_v<V, int64_t> ||
+                   std::is_same_v<V, std::vector<int64_t>>;
+        },
+        batch[0].inputs.at(name));
+    auto pack = [&](auto &vec) {
+      for (size_t r = 0; r < batch.size(); ++r) {
+        fillSlots(toInputSpan(batch[r].inputs.at(name)),
+                  vec.data() + r * m_vec_size, m_vec_size, m_vec_size);
+      }
+    };
+    if (is_int) {
+      std::vector<int64_t> vec(packed_size, 0);
+      pack(vec);
+      packed[name] = std::move(vec);
+    } else {
+      std::vector<double> vec(packed_size, 0);
+      pack(vec);
+      packed[name] = std::move(vec);
+    }
+  }
+  InputSpans spans;
+  for (auto &in : packed) spans[in.first] = toInputSpan(in.second);
+  m_dag->encryptInputSpans(spans, true);
+  m_dag->executor();
+
+  std::vector<std::string> names;
+  for (auto &out : m_dag->getOutputs()) names.push_back(out.first);
+  SlotSelection slots;
+  slots.replicas = static_cast<uint32_t>(batch.size());
+  Valuation outputs;
+  m_dag->getPartialDecryptOutput(names, slots, outputs);
+
+  std::vector<Valuation> results(batch.size());
+  for (uint32_t r = 0; r < batch.size(); ++r) {
+    for (auto &out : outputs) {
+      results[r][out.first] = sliceReplica(out.second, r, m_vec_size);
+    }
+  }
+  return results;
+}
+
+}  // namespace iyfc
@@ -0,0 +1,118 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+#include "comm_include.h"
+
+namespace iyfc {
+
+struct BatchConfig {
+  uint32_t max_batch{0};       // Requests per execution, 0: every replica
+  uint32_t max_latency_ms{5};  // Longest a request waits for a full batch
+};
+
+/**
+ * @class RequestBatcher
+ * @brief Packs independent requests into the slot replicas of one execution.
+ * @details With vec_size smaller than the slot count every input is
+ * replicated slots / vec_size times. The batcher gives each queued request
+ * its own replica instead, runs the DAG once per batch and hands every
+ * request its slice of the outputs. A batch runs when it is full or when its
+ * oldest request has waited max_latency_ms.
+ *
+ * Replicas only stay independent for slot-wise DAGs. DAGs with rotations
+ * (including sums and other reductions) and libraries that do not replicate
+ * inputs run one request per execution.
+ *
+ * The DAG must be compiled with keys generated (or loaded) on both sides, and
+ * must not be used elsewhere while the batcher is alive.
+ */
+class RequestBatcher {
+ public:
+  RequestBatcher(DagPtr dag, const BatchConfig &config = BatchConfig());
+  ~RequestBatcher();
+
+  RequestBatcher(const RequestBatcher &) = delete;
+  RequestBatcher &operator=(const RequestBatcher &) = delete;
+
+  /**
+   * @brief Queue one request
+   * @param [in] inputs Every input of the DAG, vectors of vec_size or single
+   * values, the same names for all requests
+   * @return Future of the decrypted outputs, each of vec_size
+   */
+  std::future<Valuation> submit(Valuation inputs);
+
+  /**
+   * @brief Run the queued requests now instead of waiting for the deadline
+   */
+  void flush();
+
+  /**
+   * @brief Requests packed into one execution
+   */
+  uint32_t capacity() const { return m_capacity; }
+
+  /**
+   * @brief Executions run so far
+   */
+  uint64_t batchesRun() const;
+
+ private:
+  struct Request {
+    Valuation inputs;
+    std::promise<Valuation> result;
+    std::chrono::steady_clock::time_point enqueued;
+  };
+
+  void workLoop();
+  /**
+   * @brief Execute one batch, result r belongs to request r
+   */
+  std::vector<Valuation> runBatch(std::vector<Request> &batch);
+
+  DagPtr m_dag;
+  BatchConfig m_config;
+  uint32_t m_vec_size{0};
+  uint32_t m_replicas{1};
+  uint32_t m_capacity{1};
+  std::set<std::string> m_input_names;
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::deque<Request> m_queue;
+  std::thread m_worker;
+  bool m_stop{false};
+  bool m_flush{false};
+  uint64_t m_batches{0};
+};
+
+}  // namespace iyfc
@@ -24,6 +24,8 @@
  */
 #include "ckks_rotation_keys_handler.h"
 
+#include "traversal_handler.h"
+
 namespace iyfc {
 
 RotationKeys::RotationKeys(Dag &g, NodeMap<DataType> &m_type)
@@ -55,4 +57,17 @@ bool RotationKeys::isRightRotationOp(const OpType &op_code) {
   return (op_code == OpType::RotateRightConst);
 }
 
+std::set<int> collectRotationSteps(Dag &dag) {
+  std::set<int> steps;
+  DagTraversal dag_traverse(dag);
+  dag_traverse.forwardPass([&](const NodePtr &node) {
+    if (node->m_op_type == OpType::RotateLeftConst) {
+      steps.insert(node->get<RotationAttr>());
+    } else if (node->m_op_type == OpType::RotateRightConst) {
+      steps.insert(-node->get<RotationAttr>());
+    }
+  });
+  return steps;
+}
+
 }  // namespace iyfc
@@ -68,4 +68,10 @@ class RotationKeys {
   bool isRightRotationOp(const OpType &op_code);
 };
 
+/**
+ * @brief Rotation steps (left rotation positive) of all rotation nodes in the
+ * DAG, used to expand only the rotation keys a loaded DAG needs.
+ */
+std::set<int> collectRotationSteps(Dag &dag);
+
 }  // namespace iyfc
@@ -0,0 +1,76 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "incremental_handler.h"
+
+namespace iyfc {
+
+void IncrementalExe::beginRun(
+    Dag &dag, const InputVersions &versions,
+    const std::unordered_set<std::string> &set_inputs) {
+  if (m_structure_version != dag.getStructureVersion()) {
+    m_full_run = true;
+    m_structure_version = dag.getStructureVersion();
+    m_stale_nodes.clear();
+  }
+  m_dirty_inputs.clear();
+  m_dirty_nodes.clear();
+  for (auto &input : dag.getInputs()) {
+    const std::string &name = input.first;
+    auto iter = versions.find(name);
+    uint64_t version = iter == versions.end() ? 0 : iter->second;
+    bool changed = set_inputs.empty() ? m_seen_versions[name] != version
+                                      : set_inputs.count(name) > 0;
+    if (m_full_run || changed) {
+      m_dirty_inputs.insert(name);
+      m_dirty_nodes.insert(input.second.get());
+    }
+    m_seen_versions[name] = version;
+  }
+}
+
+bool IncrementalExe::isInputDirty(const std::string &name) const {
+  return m_dirty_inputs.count(name) > 0;
+}
+
+bool IncrementalExe::needCompute(const Node &node, bool in_cone) {
+  if (node.m_op_type == OpType::Input) {
+    return m_dirty_nodes.count(&node) > 0;
+  }
+  bool dirty = m_full_run || m_stale_nodes.count(&node) > 0;
+  for (auto &operand : node.getOperands()) {
+    if (dirty) break;
+    dirty = m_dirty_nodes.count(operand.get()) > 0;
+  }
+  if (!dirty) return false;
+  // Consumers of a skipped node are outside the cone too and get stale
+  m_dirty_nodes.insert(&node);
+  if (!in_cone) {
+    m_stale_nodes.insert(&node);
+    return false;
+  }
+  m_stale_nodes.erase(&node);
+  return true;
+}
+
+}  // namespace iyfc
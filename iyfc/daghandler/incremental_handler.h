@@ -0,0 +1,89 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "dag/iyfc_dag.h"
+
+namespace iyfc {
+
+/**
+ * @brief Input name to the sequence number of its last encryption
+ */
+typedef std::unordered_map<std::string, uint64_t> InputVersions;
+
+/**
+ * @class IncrementalExe
+ * @brief Dirty tracking for executors that keep the values of their previous
+ * run: only the nodes downstream of changed inputs are recomputed.
+ */
+class IncrementalExe {
+ public:
+  /**
+   * @brief Start a run. The first run, and any run after the DAG changed, is
+   * a full one.
+   * @param [in] dag The executed DAG
+   * @param [in] versions Encryption versions of the inputs held by the
+   * adapter, inputs whose version moved since the last run are changed
+   * @param [in] set_inputs Inputs declared changed by the caller, replaces
+   * the version check when not empty
+   */
+  void beginRun(Dag &dag, const InputVersions &versions,
+                const std::unordered_set<std::string> &set_inputs);
+
+  /**
+   * @brief Whether the input value has to be (re)loaded for this run
+   */
+  bool isInputDirty(const std::string &name) const;
+
+  /**
+   * @brief Whether the node has to be recomputed, call in forward order
+   * @param [in] node
+   * @param [in] in_cone False when the run skips the node, a dirty node is
+   * then kept stale until a run computes it
+   */
+  bool needCompute(const Node &node, bool in_cone = true);
+
+  /**
+   * @brief Finish a successful run, later runs reuse its values
+   */
+  void endRun() { m_full_run = false; }
+
+  /**
+   * @brief Dirty nodes of the current run, changed inputs included
+   */
+  size_t recomputedCnt() const { return m_dirty_nodes.size(); }
+
+ private:
+  bool m_full_run{true};
+  uint64_t m_structure_version{0};
+  InputVersions m_seen_versions;
+  std::unordered_set<std::string> m_dirty_inputs;
+  std::unordered_set<const Node *> m_dirty_nodes;
+  std::unordered_set<const Node *> m_stale_nodes;
+};
+
+}  // namespace iyfc
@@ -0,0 +1,309 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "tile_handler.h"
+
+#include <algorithm>
+#include <string>
+
+#include "traversal_handler.h"
+
+namespace iyfc {
+
+static bool isRotationOp(OpType op) {
+  return op == OpType::RotateLeftConst || op == OpType::RotateRightConst;
+}
+
+static uint32_t log2Floor(uint64_t value) {
+  uint32_t bits = 0;
+  while (value >>= 1) bits++;
+  return bits;
+}
+
+VectorTiler::VectorTiler(Dag &dag, uint32_t tile_size)
+    : m_dag(dag), m_tile_size(tile_size), m_vec_size(dag.getVecSize()) {
+  if (m_tile_size == 0 || (m_tile_size & (m_tile_size - 1)) != 0) {
+    throw std::logic_error("tile size must be a power of two");
+  }
+  // Rotations wrap at vec_size, which padding would move
+  if (m_vec_size % m_tile_size != 0) {
+    throw std::logic_error("vector size must be a multiple of the tile size");
+  }
+  m_tile_cnt = m_vec_size / m_tile_size;
+}
+
+uint64_t VectorTiler::leftSteps(const NodePtr &node) const {
+  uint64_t steps = node->get<RotationAttr>() % m_vec_size;
+  if (node->m_op_type == OpType::RotateRightConst) {
+    steps = (m_vec_size - steps) % m_vec_size;
+  }
+  return steps;
+}
+
+void VectorTiler::markSumChains(const std::vector<NodePtr> &order) {
+  if ((m_vec_size & (m_vec_size - 1)) != 0) return;
+  uint64_t full_mask = (uint64_t(1) << log2Floor(m_vec_size)) - 1;
+  // Add node -> (base, rotation) of one rotate-and-add step
+  std::unordered_map<Node *, std::pair<NodePtr, NodePtr>> step_of;
+  // Add node -> (chain base, step exponents seen so far)
+  std::unordered_map<Node *, std::pair<NodePtr, uint64_t>> chain_of;
+  for (auto &node : order) {
+    if (node->m_op_type != OpType::Add || node->numOperands() != 2) continue;
+    NodePtr base, rot;
+    for (size_t i = 0; i < 2; i++) {
+      auto cand = node->operandAt(i);
+      auto other = node->operandAt(1 - i);
+      if (isRotationOp(cand->m_op_type) && cand->operandAt(0) == other &&
+          cand->numUses() == 1) {
+        base = other;
+        rot = cand;
+        break;
+      }
+    }
+    if (rot == nullptr) continue;
+    uint64_t steps = leftSteps(rot);
+    if (steps == 0 || (steps & (steps - 1)) != 0) continue;
+    uint64_t bit = uint64_t(1) << log2Floor(steps);
+    step_of[node.get()] = {base, rot};
+
+    auto chain = std::make_pair(base, bit);
+    auto prev = chain_of.find(base.get());
+    // An earlier step continues only if nothing else reads it
+    if (prev != chain_of.end() && base->numUses() == 2 &&
+        (prev->second.second & bit) == 0) {
+      chain = {prev->second.first, prev->second.second | bit};
+    }
+    chain_of[node.get()] = chain;
+    if (chain.second != full_mask) continue;
+
+    m_sum_chains[node.get()] = chain.first;
+    NodePtr cur = node;
+    while (cur != chain.first) {
+      auto &step = step_of.at(cur.get());
+      if (cur != node) m_skipped.insert(cur.get());
+      m_skipped.insert(step.second.get());
+      cur = step.first;
+    }
+  }
+}
+
+NodePtr VectorTiler::makeMask(uint32_t lo_cnt, bool lo) {
+  if (m_dag.m_has_int64) {
+    std::vector<int64_t> mask(m_tile_size, lo ? 0 : 1);
+    std::fill(mask.begin(), mask.begin() + lo_cnt, lo ? 1 : 0);
+    return m_dag.makeInt64DenseConstant(std::move(mask));
+  }
+  std::vector<double> mask(m_tile_size, lo ? 0.0 : 1.0);
+  std::fill(mask.begin(), mask.begin() + lo_cnt, lo ? 1.0 : 0.0);
+  return m_dag.makeDenseConstant(std::move(mask));
+}
+
+VectorTiler::Tiles VectorTiler::tileInput(const NodePtr &node) {
+  Tiles tiles(m_tile_cnt);
+  std::string name;
+  for (auto &entry : m_dag.m_inputs) {
+    if (entry.second == node) name = entry.first;
+  }
+  for (uint32_t t = 0; t < m_tile_cnt; t++) {
+    std::string tile_name = name + "_" + std::to_string(t);
+    tiles[t] = m_dag.makeInput(tile_name);
+    tiles[t]->assignAttrFrom(*node);
+    m_dag.m_inputnames.insert(tile_name);
+  }
+  m_dag.m_inputnames.erase(name);
+  m_dag.m_tiled_inputs.push_back(name);
+  return tiles;
+}
+
+/**
+ * @brief Cut a constant of vec_size slots into tiles, identical tiles share
+ * one node
+ */
+template <typename T, typename Make>
+static std::vector<NodePtr> splitConstant(const ConstantValue<T> &value,
+                                          uint32_t vec_size,
+                                          uint32_t tile_size,
+                                          uint32_t tile_cnt, Make make) {
+  std::vector<T> full;
+  value.expandTo(full, vec_size);
+  full.resize(uint64_t(tile_cnt) * tile_size, T(0));
+  bool uniform = true;
+  for (uint32_t t = 1; t < tile_cnt && uniform; t++) {
+    uniform = std::equal(full.begin(), full.begin() + tile_size,
+                         full.begin() + uint64_t(t) * tile_size);
+  }
+  std::vector<NodePtr> tiles(tile_cnt);
+  for (uint32_t t = 0; t < tile_cnt; t++) {
+    if (uniform && t > 0) {
+      tiles[t] = tiles[0];
+      continue;
+    }
+    auto begin = full.begin() + uint64_t(t) * tile_size;
+    tiles[t] = make(std::vector<T>(begin, begin + tile_size));
+  }
+  return tiles;
+}
+
+VectorTiler::Tiles VectorTiler::tileConstant(const NodePtr &node) {
+  if (node->has<ConstValueAttr>()) {
+    return splitConstant(*node->get<ConstValueAttr>(), m_vec_size,
+                         m_tile_size, m_tile_cnt, [&](std::vector<double> v) {
+                           return m_dag.makeDenseConstant(std::move(v));
+                         });
+  }
+  return splitConstant(*node->get<ConstValueInt64Attr>(), m_vec_size,
+                       m_tile_size, m_tile_cnt, [&](std::vector<int64_t> v) {
+                         return m_dag.makeInt64DenseConstant(std::move(v));
+                       });
+}
+
+VectorTiler::Tiles VectorTiler::tileRotation(const NodePtr &node) {
+  auto &src = m_tiles.at(node->operandAt(0).get());
+  uint64_t steps = leftSteps(node);
+  uint32_t q = steps / m_tile_size;
+  uint32_t r = steps % m_tile_size;
+  Tiles tiles(m_tile_cnt);
+  if (r == 0) {
+    // Whole tiles move, nothing is computed
+    for (uint32_t t = 0; t < m_tile_cnt; t++) {
+      tiles[t] = src[(t + q) % m_tile_cnt];
+    }
+    return tiles;
+  }
+  // Slot j of tile t comes from tile t + q for j < tile_size - r, from tile
+  // t + q + 1 otherwise. Every source tile is rotated once and used twice.
+  Tiles rotated(m_tile_cnt);
+  for (uint32_t t = 0; t < m_tile_cnt; t++) {
+    rotated[t] = m_dag.makeLeftRotation(src[t], r);
+  }
+  auto lo_mask = makeMask(m_tile_size - r, true);
+  auto hi_mask = makeMask(m_tile_size - r, false);
+  for (uint32_t t = 0; t < m_tile_cnt; t++) {
+    auto lo = m_dag.makeNode(OpType::Mul,
+                             {rotated[(t + q) % m_tile_cnt], lo_mask});
+    auto hi = m_dag.makeNode(OpType::Mul,
+                             {rotated[(t + q + 1) % m_tile_cnt], hi_mask});
+    tiles[t] = m_dag.makeNode(OpType::Add, {lo, hi});
+  }
+  return tiles;
+}
+
+VectorTiler::Tiles VectorTiler::tileSumChain(const NodePtr &node) {
+  auto &src = m_tiles.at(m_sum_chains.at(node.get()).get());
+  // Sum every tile in place, then add the tiles up: same total, no masks
+  NodePtr total = nullptr;
+  for (uint32_t t = 0; t < m_tile_cnt; t++) {
+    NodePtr acc = src[t];
+    for (uint32_t k = 1; k < m_tile_size; k <<= 1) {
+      acc = m_dag.makeNode(OpType::Add, {acc, m_dag.makeLeftRotation(acc, k)});
+    }
+    total = total ? m_dag.makeNode(OpType::Add, {total, acc}) : acc;
+  }
+  return Tiles(m_tile_cnt, total);
+}
+
+void VectorTiler::run() {
+  if (m_tile_cnt <= 1) return;
+  if (m_dag.m_has_complex) {
+    throw std::logic_error("complex inputs can not be tiled");
+  }
+  std::vector<NodePtr> order;
+  DagTraversal(m_dag).forwardPass(
+      [&](NodePtr &node) { order.push_back(node); });
+  markSumChains(order);
+
+  std::unordered_map<Node *, std::string> output_names;
+  for (auto &entry : m_dag.m_outputs) {
+    output_names[entry.second.get()] = entry.first;
+  }
+  m_dag.setVecSize(m_tile_size);
+  m_dag.m_tiled_inputs.clear();
+  m_dag.m_tiled_outputs.clear();
+
+  for (auto &node : order) {
+    if (m_skipped.count(node.get())) continue;
+    Tiles tiles;
+    switch (node->m_op_type) {
+      case OpType::Input:
+        tiles = tileInput(node);
+        break;
+      case OpType::Constant:
+        tiles = tileConstant(node);
+        break;
+      case OpType::U32Constant:
+        // Scalars are the same in every tile
+        tiles.assign(m_tile_cnt, node);
+        break;
+      case OpType::RotateLeftConst:
+      case OpType::RotateRightConst:
+        tiles = tileRotation(node);
+        break;
+      case OpType::Output: {
+        auto &name = output_names.at(node.get());
+        auto &src = m_tiles.at(node->operandAt(0).get());
+        auto range = m_dag.m_output_ranges.find(name);
+        for (uint32_t t = 0; t < m_tile_cnt; t++) {
+          std::string tile_name = name + "_" + std::to_string(t);
+          m_dag.makeOutput(tile_name, src[t]);
+          if (range != m_dag.m_output_ranges.end()) {
+            m_dag.m_output_ranges[tile_name] = range->second;
+          }
+        }
+        m_dag.m_tiled_outputs.push_back(name);
+        break;
+      }
+      default:
+        if (m_sum_chains.count(node.get())) {
+          tiles = tileSumChain(node);
+          break;
+        }
+        // Slot-wise: one clone per tile
+        for (uint32_t t = 0; t < m_tile_cnt; t++) {
+          std::vector<NodePtr> operands;
+          for (auto &operand : node->getOperands()) {
+            operands.push_back(m_tiles.at(operand.get())[t]);
+          }
+          auto tile = m_dag.makeNode(node->m_op_type, operands);
+          tile->assignAttrFrom(*node);
+          tiles.push_back(tile);
+        }
+    }
+    m_tiles[node.get()] = std::move(tiles);
+  }
+
+  // Detach the untiled nodes, as CleanNodeHandler does
+  for (auto &node : order) {
+    if (node->m_op_type == OpType::U32Constant) continue;
+    node->eraseAllOperand();
+    m_dag.eraseSinks(node.get());
+    m_dag.eraseSource(node.get());
+  }
+  for (auto &name : m_dag.m_tiled_inputs) m_dag.m_inputs.erase(name);
+  for (auto &name : m_dag.m_tiled_outputs) {
+    m_dag.m_outputs.erase(name);
+    m_dag.m_output_ranges.erase(name);
+  }
+  m_dag.m_tile_cnt = m_tile_cnt;
+  m_dag.m_logical_vec_size = m_vec_size;
+}
+
+}  // namespace iyfc
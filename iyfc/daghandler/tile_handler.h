@@ -0,0 +1,83 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "dag/iyfc_dag.h"
+
+namespace iyfc {
+
+/**
+ * @class VectorTiler
+ * @brief Split a DAG whose vectors are longer than one ciphertext into tiles
+ * @details The logical vector of vec_size slots, a multiple of tile_size, is
+ * cut into tile_cnt tiles of tile_size. Input and output "x" become
+ * "x_<t>". Slot-wise nodes are cloned once per tile. A rotation by
+ * q * tile_size + r reads tiles t + q and t + q + 1, both rotated by r, and
+ * selects their halves with 0/1 masks. A rotate-and-add chain over every
+ * power of two (a full slot sum) is reduced within each tile first and then
+ * across tiles, without masks.
+ *
+ *   x_0   x_1        rot(x_0, r)  rot(x_1, r)
+ *    \    /      =>       \   *mask   /  *(1 - mask)
+ *   rot(x, r)              +---------+
+ */
+class VectorTiler {
+ public:
+  VectorTiler(Dag &dag, uint32_t tile_size);
+
+  /**
+   * @brief Rewrite the DAG, it then has vec_size tile_size
+   */
+  void run();
+
+ private:
+  using Tiles = std::vector<NodePtr>;
+
+  void markSumChains(const std::vector<NodePtr> &order);
+  Tiles tileInput(const NodePtr &node);
+  Tiles tileConstant(const NodePtr &node);
+  Tiles tileRotation(const NodePtr &node);
+  Tiles tileSumChain(const NodePtr &node);
+  NodePtr makeMask(uint32_t lo_cnt, bool lo);
+
+  /**
+   * @brief Left rotation step of a rotation node, in [0, vec_size)
+   */
+  uint64_t leftSteps(const NodePtr &node) const;
+
+  Dag &m_dag;
+  uint32_t m_tile_size;
+  uint32_t m_vec_size;
+  uint32_t m_tile_cnt;
+
+  std::unordered_map<Node *, Tiles> m_tiles;
+  // Full rotate-and-add chains: end node -> chain base
+  std::unordered_map<Node *, NodePtr> m_sum_chains;
+  // Nodes inside a full chain, replaced by the chain lowering
+  std::unordered_set<Node *> m_skipped;
+};
+
+}  // namespace iyfc
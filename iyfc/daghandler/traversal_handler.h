@@ -22,8 +22,17 @@
  */
 
 #pragma once
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
 #include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
 #include <vector>
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
 
 #include "dag/iyfc_dag.h"
 #include "dag/node_map.h"
@@ -34,6 +43,11 @@ namespace iyfc {
  * @class DagTraversal
  * @brief Iterator pattern. Subclasses inherit from this class and overload the operator() to process specific nodes.
  * @details Traverse the DAG structure in top-down or bottom-up directions.
+ * A pass that leaves the DAG unchanged caches its topological order on the
+ * DAG, later passes replay it until a node or edge changes. Otherwise nodes
+ * are released by per-node predecessor counters (Kahn), and the nodes
+ * touched by a rewrite are recounted, so a pass costs O(V + E) plus its
+ * rewrites.
  */
 class DagTraversal {
  private:
@@ -41,71 +55,188 @@ class DagTraversal {
 
   NodeMap<bool> m_ready;      // Record nodes that can be used for rewriting
   NodeMap<bool> m_processed;  // processed
+  NodeMap<int> m_pending;     // Unprocessed predecessors, with multiplicity
+  NodeMap<uint64_t> m_stamp;  // Step at which the node was last recounted
+
+  /**
+   * @brief Logs the nodes changed by the rewrites while it is alive.
+   */
+  struct ChangeWatch {
+    ChangeWatch(Dag &g) : dag(g) { dag.watchChanges(&log, true); }
+    ~ChangeWatch() { dag.watchChanges(&log, false); }
+    Dag &dag;
+    Dag::ChangeLog log;
+  };
 
   template <bool is_forward>
-  bool arePredecessorsDone(const NodePtr &node) {
-    for (auto &operand : is_forward ? node->getOperands() : node->getUses()) {
-      if (!m_processed[operand]) return false;
+  int countPending(Node &node) {
+    int pending = 0;
+    if (is_forward) {
+      for (auto &operand : node.getOperands()) {
+        if (!m_processed[*operand]) pending++;
+      }
+    } else {
+      for (auto &use : node.getUses()) {
+        if (!m_processed[use]) pending++;
+      }
+    }
+    return pending;
+  }
+
+  template <bool is_forward>
+  void pushIfReady(const NodePtr &node, std::vector<NodePtr> &ready_nodes) {
+    if (!m_ready[node] && m_pending[node] <= 0) {
+      ready_nodes.push_back(node);
+      m_ready[node] = true;
     }
-    return true;
   }
 
   /**
-   * @brief Breadth-first traversal of each node in the DAG
+   * @brief Kahn traversal of the unprocessed nodes
+   * @details Counters are built by a walk from the sources (sinks) so
+   * nodes erased from the DAG are not visited.
+   * @return The visited nodes in visiting order
    */
-  template <typename Rewriter, bool is_forward>
-  void traverse(Rewriter &&rewrite) {
-    m_processed.clear();
-    m_ready.clear();
-
-    std::vector<NodePtr> m_readyNodes =
+  template <bool is_forward, typename Rewriter>
+  std::vector<Node *> traverseKahn(Rewriter &rewrite, ChangeWatch &watch) {
+    std::vector<NodePtr> ready_nodes;
+    std::vector<NodePtr> stack =
         is_forward ? dag.getSources() : dag.getSinks();
-    for (auto &node : m_readyNodes) {
-      m_ready[node] = true;
+    // m_stamp doubles as the visited mark of the walk
+    m_stamp.clear();
+    for (auto &node : stack) m_stamp[node] = 1;
+    while (!stack.empty()) {
+      NodePtr node = stack.back();
+      stack.pop_back();
+      auto succs = is_forward ? node->getUses() : node->getOperands();
+      for (auto &succ : succs) {
+        if (m_stamp[succ] == 0) {
+          m_stamp[succ] = 1;
+          stack.push_back(succ);
+        }
+      }
+      if (m_processed[node]) continue;
+      m_pending[node] = countPending<is_forward>(*node);
+      // When resuming, nodes a rewrite created behind the processed ones
+      // are not visited, as in a full Kahn pass
+      bool behind = std::any_of(succs.begin(), succs.end(),
+                                [&](const NodePtr &succ) {
+                                  return bool(m_processed[succ]);
+                                });
+      if (!behind) pushIfReady<is_forward>(node, ready_nodes);
     }
 
-    std::vector<NodePtr> vec_check_list;
-
-    // Breadth-first search
-    while (m_readyNodes.size() != 0) {
-      auto node = m_readyNodes.back();
-      m_readyNodes.pop_back();
-
-      // Record op or uses
-      vec_check_list.clear();
-      for (auto &succ : is_forward ? node->getUses() : node->getOperands()) {
-        vec_check_list.push_back(succ);
-      }
+    std::vector<Node *> order;
+    uint64_t step = 1;
+    watch.log.clear();
+    while (!ready_nodes.empty()) {
+      NodePtr node = ready_nodes.back();
+      ready_nodes.pop_back();
+      if (m_processed[node]) continue;
 
+      // The rewriter may reset node, keep it alive until its successors
+      // are released
+      NodePtr keep = node;
+      auto succs_before = is_forward ? node->getUses() : node->getOperands();
       rewrite(node);
-      if (node != nullptr) m_processed[node] = true;
+      m_processed[keep] = true;
+      order.push_back(keep.get());
+      step++;
 
-      // Add branch nodes
-      for (auto &leaf : is_forward ? dag.getSources() : dag.getSinks()) {
-        if (!m_ready[leaf]) {
-          m_readyNodes.push_back(leaf);
-          m_ready[leaf] = true;
+      // Recount the nodes whose edges the rewrite changed. Like the sources
+      // of the DAG, new nodes without predecessors are ready at once, other
+      // recounted nodes only when they follow the processed node.
+      for (auto &weak : watch.log) {
+        NodePtr changed = weak.lock();
+        if (!changed || !m_stamp.covers(*changed) ||
+            m_processed[changed] || m_stamp[changed] == step) {
+          continue;
         }
+        m_stamp[changed] = step;
+        m_pending[changed] = countPending<is_forward>(*changed);
+        bool is_root = is_forward ? changed->numOperands() == 0
+                                  : changed->numUses() == 0;
+        if (is_root) pushIfReady<is_forward>(changed, ready_nodes);
       }
+      watch.log.clear();
 
-      // Add nodes after rewriting the current node; uses and ops are also added to the checklist during breadth-first search
-      if (node)
-        for (auto &succ : is_forward ? node->getUses() : node->getOperands()) {
-          vec_check_list.push_back(succ);
-        }
+      // Edges kept by the rewrite were not recounted
+      auto succs = is_forward ? keep->getUses() : keep->getOperands();
+      for (auto &succ : succs) {
+        if (!m_processed[succ] && m_stamp[succ] != step) m_pending[succ]--;
+      }
+      for (auto &succ : succs_before) {
+        if (!m_processed[succ]) pushIfReady<is_forward>(succ, ready_nodes);
+      }
+      for (auto &succ : succs) {
+        if (!m_processed[succ]) pushIfReady<is_forward>(succ, ready_nodes);
+      }
+    }
+    return order;
+  }
 
-      // Add nodes
-      for (auto &succ : vec_check_list) {
-        if (!m_ready[succ] && arePredecessorsDone<is_forward>(succ)) {
-          m_readyNodes.push_back(succ);
-          m_ready[succ] = true;
+  /**
+   * @brief Readable name of a pass for the profiler, lambdas are named
+   * after the function defining them
+   */
+  template <typename Rewriter>
+  static std::string passName() {
+    std::string name = typeid(std::decay_t<Rewriter>).name();
+#if defined(__GNUG__)
+    int status = 0;
+    char *demangled =
+        abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+    if (status == 0 && demangled != nullptr) name = demangled;
+    std::free(demangled);
+#endif
+    auto lambda = name.find("::{lambda");
+    if (lambda != std::string::npos) {
+      name = name.substr(0, std::min(lambda, name.find('('))) + " lambda";
+    }
+    if (name.compare(0, 6, "iyfc::") == 0) name = name.substr(6);
+    return name;
+  }
+
+  /**
+   * @brief Topological traversal of each node in the DAG
+   */
+  template <typename Rewriter, bool is_forward>
+  void traverse(Rewriter &&rewrite) {
+    m_processed.clear();
+    m_ready.clear();
+    ChangeWatch watch(dag);
+    const uint64_t version = dag.getStructureVersion();
+
+    if (dag.m_topo_order != nullptr && dag.m_topo_order_version == version) {
+      // Replay the cached order until a rewrite changes the DAG
+      auto order = dag.m_topo_order;
+      const size_t size = order->size();
+      for (size_t i = 0; i < size; i++) {
+        NodePtr node =
+            (*order)[is_forward ? i : size - 1 - i]->shared_from_this();
+        NodePtr keep = node;
+        rewrite(node);
+        m_processed[keep] = true;
+        if (dag.getStructureVersion() != version) {
+          traverseKahn<is_forward>(rewrite, watch);
+          return;
         }
       }
+      return;
+    }
+
+    std::vector<Node *> order = traverseKahn<is_forward>(rewrite, watch);
+    if (dag.getStructureVersion() == version) {
+      if (!is_forward) std::reverse(order.begin(), order.end());
+      dag.m_topo_order =
+          std::make_shared<const std::vector<Node *>>(std::move(order));
+      dag.m_topo_order_version = version;
     }
   }
 
  public:
-  DagTraversal(Dag &g) : dag(g), m_ready(g), m_processed(g) {}
+  DagTraversal(Dag &g)
+      : dag(g), m_ready(g), m_processed(g), m_pending(g), m_stamp(g) {}
 
   ~DagTraversal() {}
 
@@ -115,6 +246,9 @@ class DagTraversal {
    */
   template <typename Rewriter>
   void forwardPass(Rewriter &&rewrite) {
+    PassScope scope(dag, dag.getPassProfiler() != nullptr
+                             ? passName<Rewriter>()
+                             : std::string());
     traverse<Rewriter, true>(std::forward<Rewriter>(rewrite));
   }
 
@@ -124,6 +258,9 @@ class DagTraversal {
    */
   template <typename Rewriter>
   void backwardPass(Rewriter &&rewrite) {
+    PassScope scope(dag, dag.getPassProfiler() != nullptr
+                             ? passName<Rewriter>()
+                             : std::string());
     traverse<Rewriter, false>(std::forward<Rewriter>(rewrite));
   }
 };
@@ -21,6 +21,10 @@
  * SOFTWARE.
  */
 #include "type_handler.h"
+#include <deque>
+#include <unordered_set>
+
+#include "traversal_handler.h"
 
 namespace iyfc {
 
@@ -47,4 +51,53 @@ void TypeHandler::operator()(NodePtr &node) {  // forward pass
   }
 }
 
+TypeInference::TypeInference(Dag &g, NodeMap<DataType> &types)
+    : m_dag(g), m_types(types) {
+  m_dag.watchChanges(&m_log, true);
+}
+
+TypeInference::~TypeInference() { m_dag.watchChanges(&m_log, false); }
+
+void TypeInference::update() {
+  TypeHandler infer(m_dag, m_types);
+  if (m_full) {
+    m_log.clear();
+    size_t cnt = 0;
+    DagTraversal(m_dag).forwardPass([&](NodePtr &node) {
+      infer(node);
+      cnt++;
+    });
+    m_full = false;
+    m_retyped_cnt = cnt;
+    return;
+  }
+
+  PassScope scope(m_dag, "TypeInference");
+  std::deque<NodePtr> work;
+  std::unordered_set<const Node *> queued;
+  for (auto &weak : m_log) {
+    NodePtr node = weak.lock();
+    if (node && m_types.covers(*node) && queued.insert(node.get()).second) {
+      work.push_back(node);
+    }
+  }
+  m_log.clear();
+
+  // Types only flow along uses, a node is final once its operands are
+  m_retyped_cnt = 0;
+  while (!work.empty()) {
+    NodePtr node = work.front();
+    work.pop_front();
+    queued.erase(node.get());
+    DataType old_type = m_types[node];
+    infer(node);
+    m_retyped_cnt++;
+    if (m_types[node] == old_type) continue;
+    for (auto &use : node->getUses()) {
+      if (queued.insert(use.get()).second) work.push_back(use);
+    }
+  }
+  LOG(LOGLEVEL::Debug, "TypeInference retyped %zu nodes", m_retyped_cnt);
+}
+
 }  // namespace iyfc
@@ -42,4 +42,33 @@ class TypeHandler {
   void operator()(NodePtr &node);
 };
 
+/**
+ * @class TypeInference
+ * @brief Keeps the types of a DAG up to date across rewriting passes.
+ * @details The first update() types the whole DAG. Later ones retype only
+ * the nodes created or rewired since the previous update, the DAG logs them
+ * for as long as the object lives, and the uses of every node whose type
+ * changed.
+ */
+class TypeInference {
+ public:
+  TypeInference(Dag &g, NodeMap<DataType> &types);
+  ~TypeInference();
+  TypeInference(const TypeInference &) = delete;
+  TypeInference &operator=(const TypeInference &) = delete;
+
+  void update();
+  /**
+   * @brief Nodes typed by the last update
+   */
+  size_t retypedCnt() const { return m_retyped_cnt; }
+
+ private:
+  Dag &m_dag;
+  NodeMap<DataType> &m_types;
+  Dag::ChangeLog m_log;
+  bool m_full{true};
+  size_t m_retyped_cnt{0};
+};
+
 }  // namespace iyfc
@@ -23,9 +23,11 @@
 
 #pragma once
 #include <string>
+#include <vector>
 
 #include "comm_include.h"
 #include "dag/iyfc_dag.h"
+#include "daghandler/incremental_handler.h"
 #include "parameters_interface.h"
 
 namespace iyfc {
@@ -55,11 +57,51 @@ class AdapterInterface {
    * @return ==0 indicates success
    */
   virtual int encrypt(const Valuation &inputs, bool replace) = 0;
+  /**
+   * @brief Encrypt caller-owned input views
+   * @details The default copies them into a Valuation, adapters that can
+   * encode straight from the views override it
+   * @return ==0 indicates success
+   */
+  virtual int encryptSpans(const InputSpans &inputs, bool replace) {
+    Valuation copied;
+    for (auto &in : inputs) {
+      if (in.second.f64) {
+        copied[in.first] = std::vector<double>(
+            in.second.f64, in.second.f64 + in.second.size);
+      } else if (in.second.i64) {
+        copied[in.first] = std::vector<int64_t>(
+            in.second.i64, in.second.i64 + in.second.size);
+      }
+    }
+    return encrypt(copied, replace);
+  }
   /**
    * @brief decrypt
    */
   virtual int decrypt() = 0;
 
+  /**
+   * @brief Decrypt only the named outputs and keep only the selected slots
+   * @details The default decrypts everything and drops the rest, adapters
+   * that can skip the work override it
+   * @return ==0 indicates success
+   */
+  virtual int decryptPartial(const std::vector<std::string> &names,
+                             const SlotSelection &slots) {
+    int ret = decrypt();
+    if (ret != 0 || m_output_de == nullptr) return ret;
+    auto all_outputs = m_output_de;
+    m_output_de = std::make_shared<Valuation>();
+    for (auto &name : names) {
+      auto iter = all_outputs->find(name);
+      if (iter == all_outputs->end()) continue;
+      (*m_output_de)[name] = std::move(iter->second);
+      pickSlots((*m_output_de)[name], slots);
+    }
+    return 0;
+  }
+
   /**
    * @brief execute
    * @return indicates success
@@ -124,5 +166,76 @@ class AdapterInterface {
   virtual int deserializeBootstrappingKey(std::istream &stream) {
     throw std::logic_error("the alo not support bootstrapping!");
   }
+
+  /**
+   * @brief Select public-key or symmetric encryption of cipher inputs
+   * @return ==0 indicates success
+   */
+  virtual int setEncryptMode(ENCRYPT_MODE mode) {
+    if (mode != PUBLIC_KEY_MODE) {
+      throw std::logic_error("the alo not support symmetric encrypt!");
+    }
+    return 0;
+  }
+
+  /**
+   * @brief Configure the offline/online encryption pool
+   * @return ==0 indicates success
+   */
+  virtual int setEncryptPool(const EncryptPoolConfig &config) {
+    // Only SEAL public-key encryption has a pool
+    throw std::logic_error("the alo not support encrypt pool!");
+  }
+
+  /**
+   * @brief Metrics of the offline/online encryption pool
+   */
+  virtual int getEncryptPoolMetrics(EncryptPoolMetrics &metrics) {
+    throw std::logic_error("the alo not support encrypt pool!");
+  }
+
+  /**
+   * @brief Static noise and precision estimate of the compiled DAG
+   * @param [in] precision_bits CKKS output precision to recommend scales for
+   * @return ==0 indicates success
+   */
+  virtual int estimateNoise(Dag &dag, uint32_t precision_bits,
+                            NoiseReport &report) {
+    throw std::logic_error("the alo not support noise estimation!");
+  }
+
+  /**
+   * @brief Noise measured by the last execution with the noise check on
+   * @return ==0 indicates success
+   */
+  virtual int getNoiseMeasurements(
+      std::vector<NoiseMeasurement> &measurements) {
+    throw std::logic_error("the alo not support noise estimation!");
+  }
+
+  /**
+   * @brief Slots of one ciphertext, 0 when inputs are not replicated across
+   * them (RequestBatcher then runs one request at a time)
+   */
+  virtual uint32_t getSlotCount() const { return 0; }
+
+  /**
+   * @brief Drop the values kept for incremental execution of the DAG
+   */
+  virtual void releaseExecutor(const Dag &dag) {}
+
+ protected:
+  /**
+   * @brief Record that the inputs got new ciphertexts, incremental execution
+   * recomputes what depends on them
+   */
+  template <typename Inputs>
+  void touchInputs(const Inputs &inputs) {
+    for (auto &in : inputs) m_input_versions[in.first] = ++m_input_seq;
+  }
+
+  ENCRYPT_MODE m_encrypt_mode{PUBLIC_KEY_MODE};
+  InputVersions m_input_versions;
+  uint64_t m_input_seq{0};
 };
 }  // namespace iyfc
\ No newline at end of file
@@ -39,6 +39,7 @@ namespace iyfc {
 AloDecision::AloDecision() { m_fhe_manager = std::make_shared<FheManager>(); }
 
 void AloDecision::InitDagForDecision(Dag& dag) {
+  PassScope scope(dag, "AloDecision::InitDagForDecision");
   LOG(LOGLEVEL::Debug, "before InitDagForDecision max_index %lu name %s",
       dag.getNextNodeIndex(), dag.getName().c_str());
   auto dag_rewrite = DagTraversal(dag);
@@ -47,11 +48,12 @@ void AloDecision::InitDagForDecision(Dag& dag) {
   NodeMap<DataType> types(dag);
   NodeMapOptional<std::uint32_t> scales(dag);
   // Type inference
-  dag_rewrite.forwardPass(TypeHandler(dag, types));
+  TypeInference inference(dag, types);
+  inference.update();
   // Balance adjustment -- general
   dag_rewrite.forwardPass(Reduction(dag));
   dag_rewrite.forwardPass(ReductionLogExpander(dag, types));
-  dag_rewrite.forwardPass(TypeHandler(dag, types));
+  inference.update();
   MultDepthCnt depth(dag, types);
   dag_rewrite.forwardPass(depth);
   dag.m_after_reduction_depth = depth.getMultDepth();
@@ -62,7 +64,16 @@ void AloDecision::setAloName(Dag& dag, std::string& tmp_alo_name) {
   uint32_t max_dep_for_seal = MAX_SEAL_BITS / dag.m_scale - DEFAULT_Q_CNT;
   LOG(LOGLEVEL::Debug, "max_dep_for_seal %lu, sacle%lu \n", max_dep_for_seal,
       dag.m_scale);
-  if (dag.supportShortInt())
+  if (dag.m_has_complex) {
+    // Complex slots are only encoded by the seal ckks encoder
+    if (dag.supportShortInt() || dag.m_has_int64 ||
+        m_max_mul_dep > max_dep_for_seal) {
+      throw std::logic_error("complex inputs need seal_ckks !");
+    }
+    tmp_alo_name = "seal_ckks";
+    auto dag_rewrite = DagTraversal(dag);
+    dag_rewrite.forwardPass(U32ToConstant(dag, TYPE_DOUBLE));
+  } else if (dag.supportShortInt())
     tmp_alo_name = "concrete";
   else if (dag.m_has_int64) {
     tmp_alo_name = "seal_bfv";
@@ -110,6 +121,8 @@ int AloDecision::deGroupLibAndAlo(
     root_dag.setSupportShortInt(item.second->supportShortInt());
     root_dag.m_has_int64 = item.second->m_has_int64;
     root_dag.m_has_double = item.second->m_has_double;
+    root_dag.m_has_complex =
+        root_dag.m_has_complex || item.second->m_has_complex;
   }
   // std::function<uint32_t(uint32_t, uint32_t)> maxFucUint =
   //     [](uint32_t a, uint32_t b) { return std::max(a, b); };
@@ -161,6 +174,14 @@ int AloDecision::encryptInput(const Valuation& inputs, bool replace) {
   }
 }
 
+int AloDecision::encryptInputSpans(const InputSpans& inputs, bool replace) {
+  if (m_libs.size() > 0)
+    return m_fhe_manager->encryptInputSpans(m_libs[0], inputs, replace);
+  else {
+    throw std::logic_error("libs null !");
+  }
+}
+
 int AloDecision::executor(Dag& dag) {
   auto dag_rewrite = DagTraversal(dag);
   dag_rewrite.backwardPass(CleanNodeHandler(dag));
@@ -179,4 +200,70 @@ int AloDecision::getDecryptOutput(Valuation& valuation) {
   }
 }
 
+int AloDecision::getPartialDecryptOutput(const std::vector<std::string>& names,
+                                         const SlotSelection& slots,
+                                         Valuation& valuation) {
+  if (m_libs.size() > 0)
+    return m_fhe_manager->getPartialDecryptOutput(m_libs[0], names, slots,
+                                                  valuation);
+  else {
+    throw std::logic_error("libs null !");
+  }
+}
+
+int AloDecision::setEncryptMode(ENCRYPT_MODE mode) {
+  if (m_libs.size() > 0)
+    return m_fhe_manager->setEncryptMode(mode);
+  else {
+    throw std::logic_error("libs null !");
+  }
+}
+
+int AloDecision::setEncryptPool(const EncryptPoolConfig& config) {
+  if (m_libs.size() > 0)
+    return m_fhe_manager->setEncryptPool(config);
+  else {
+    throw std::logic_error("libs null !");
+  }
+}
+
+int AloDecision::getEncryptPoolMetrics(EncryptPoolMetrics& metrics) {
+  if (m_libs.size() > 0)
+    return m_fhe_manager->getEncryptPoolMetrics(metrics);
+  else {
+    throw std::logic_error("libs null !");
+  }
+}
+
+uint32_t AloDecision::getSlotCount() {
+  if (m_libs.size() > 0)
+    return m_fhe_manager->getSlotCount();
+  else {
+    throw std::logic_error("libs null !");
+  }
+}
+
+int AloDecision::estimateNoise(Dag& dag, uint32_t precision_bits,
+                               NoiseReport& report) {
+  if (m_libs.size() > 0) {
+    report.lib = m_libs[0];
+    return m_fhe_manager->estimateNoise(dag, precision_bits, report);
+  } else {
+    throw std::logic_error("libs null !");
+  }
+}
+
+int AloDecision::getNoiseMeasurements(
+    std::vector<NoiseMeasurement>& measurements) {
+  if (m_libs.size() > 0)
+    return m_fhe_manager->getNoiseMeasurements(measurements);
+  else {
+    throw std::logic_error("libs null !");
+  }
+}
+
+void AloDecision::releaseExecutor(const Dag& dag) {
+  if (m_fhe_manager != nullptr) m_fhe_manager->releaseExecutor(dag);
+}
+
 }  // namespace iyfc
\ No newline at end of file
@@ -67,6 +67,11 @@ class AloDecision {
    */
   int encryptInput(const Valuation &inputs, bool replace = false);
 
+  /**
+   * @brief Encrypt caller-owned input views
+   */
+  int encryptInputSpans(const InputSpans &inputs, bool replace = false);
+
   /**
    * @brief Execute
    */
@@ -77,11 +82,52 @@ class AloDecision {
    */
   int getDecryptOutput(Valuation &output);
 
+  /**
+   * @brief Decrypt the named results, keeping only the selected slots
+   */
+  int getPartialDecryptOutput(const std::vector<std::string> &names,
+                              const SlotSelection &slots, Valuation &output);
+
   /**
    * @brief Generate all keys
    */
   int genKeys(Dag &dag);
 
+  /**
+   * @brief Select public-key or symmetric encryption
+   */
+  int setEncryptMode(ENCRYPT_MODE mode);
+
+  /**
+   * @brief Configure the offline/online encryption pool
+   */
+  int setEncryptPool(const EncryptPoolConfig &config);
+
+  /**
+   * @brief Metrics of the offline/online encryption pool
+   */
+  int getEncryptPoolMetrics(EncryptPoolMetrics &metrics);
+
+  /**
+   * @brief Slots of one ciphertext, 0 if the library does not replicate
+   */
+  uint32_t getSlotCount();
+
+  /**
+   * @brief Static noise and precision estimate of the compiled DAG
+   */
+  int estimateNoise(Dag &dag, uint32_t precision_bits, NoiseReport &report);
+
+  /**
+   * @brief Noise measured by the last execution with the noise check on
+   */
+  int getNoiseMeasurements(std::vector<NoiseMeasurement> &measurements);
+
+  /**
+   * @brief Drop the values kept for incremental execution of the DAG
+   */
+  void releaseExecutor(const Dag &dag);
+
   /**
    * @brief Serialization is uniformly defined in the proto directory
    */
@@ -65,6 +65,11 @@ int FheManager::encryptInput(const string &alo_name, const Valuation &inputs,boo
   return m_alo_adapter->encrypt(inputs,replace);
 }
 
+int FheManager::encryptInputSpans(const string &alo_name,
+                                  const InputSpans &inputs, bool replace) {
+  return m_alo_adapter->encryptSpans(inputs, replace);
+}
+
 int FheManager::executor(const string &alo_name, Dag& dag) {
   // todo
   return m_alo_adapter->execute(dag);
@@ -77,7 +82,22 @@ int FheManager::getDecryptOutput(const string &alo_name, Valuation &valuation) {
   if (m_alo_adapter->m_output_de == nullptr) {
     throw std::logic_error("m_output_de null !");
   }
-  valuation = *(m_alo_adapter->m_output_de);
+  valuation = std::move(*(m_alo_adapter->m_output_de));
+  m_alo_adapter->m_output_de = nullptr;
+  return 0;
+}
+
+int FheManager::getPartialDecryptOutput(const string &alo_name,
+                                        const std::vector<std::string> &names,
+                                        const SlotSelection &slots,
+                                        Valuation &valuation) {
+  int de_ret = m_alo_adapter->decryptPartial(names, slots);
+  THROW_ON_ERROR(de_ret, "ptr decryptPartial ");
+  if (m_alo_adapter->m_output_de == nullptr) {
+    throw std::logic_error("m_output_de null !");
+  }
+  valuation = std::move(*(m_alo_adapter->m_output_de));
+  m_alo_adapter->m_output_de = nullptr;
   return 0;
 }
 
@@ -122,4 +142,41 @@ int FheManager::saveBootstrappingKey(std::ostream &stream) {
   return m_alo_adapter->serializeBootstrappingKey(stream);
 }
 
+int FheManager::setEncryptMode(ENCRYPT_MODE mode) {
+  checkAdapter();
+  return m_alo_adapter->setEncryptMode(mode);
+}
+
+int FheManager::setEncryptPool(const EncryptPoolConfig &config) {
+  checkAdapter();
+  return m_alo_adapter->setEncryptPool(config);
+}
+
+int FheManager::getEncryptPoolMetrics(EncryptPoolMetrics &metrics) {
+  checkAdapter();
+  return m_alo_adapter->getEncryptPoolMetrics(metrics);
+}
+
+uint32_t FheManager::getSlotCount() {
+  checkAdapter();
+  return m_alo_adapter->getSlotCount();
+}
+
+int FheManager::estimateNoise(Dag &dag, uint32_t precision_bits,
+                              NoiseReport &report) {
+  checkAdapter();
+  return m_alo_adapter->estimateNoise(dag, precision_bits, report);
+}
+
+int FheManager::getNoiseMeasurements(
+    std::vector<NoiseMeasurement> &measurements) {
+  checkAdapter();
+  return m_alo_adapter->getNoiseMeasurements(measurements);
+}
+
+void FheManager::releaseExecutor(const Dag &dag) {
+  // Called from the Dag destructor, must not throw
+  if (m_alo_adapter != nullptr) m_alo_adapter->releaseExecutor(dag);
+}
+
 }  // namespace iyfc
@@ -58,7 +58,13 @@ class FheManager {
   int generateKeys(const string& alo_name, Dag& dag);
   int encryptInput(const string& alo_name, const Valuation& inputs,
                    bool replace = false);
+  int encryptInputSpans(const string& alo_name, const InputSpans& inputs,
+                        bool replace = false);
   int getDecryptOutput(const string& alo_name, Valuation& valuation);
+  int getPartialDecryptOutput(const string& alo_name,
+                              const std::vector<std::string>& names,
+                              const SlotSelection& slots,
+                              Valuation& valuation);
 
   // Serialization related
   int aloInfoSerialize(const DagSerializePara& serialize_para,
@@ -71,6 +77,15 @@ class FheManager {
   int loadOutputFromMsg(const string& alo_info);
   int loadBootstrappingKey(std::istream& stream);
   int saveBootstrappingKey(std::ostream& stream);
+
+  int setEncryptMode(ENCRYPT_MODE mode);
+  // Offline/online encryption
+  int setEncryptPool(const EncryptPoolConfig& config);
+  int getEncryptPoolMetrics(EncryptPoolMetrics& metrics);
+  uint32_t getSlotCount();
+  int estimateNoise(Dag& dag, uint32_t precision_bits, NoiseReport& report);
+  int getNoiseMeasurements(std::vector<NoiseMeasurement>& measurements);
+  void releaseExecutor(const Dag& dag);
 };
 
 }  // namespace iyfc
\ No newline at end of file
@@ -36,6 +36,21 @@ int OpenFheAdapterBase::mergeInput(
   return 0;
 }
 
+/*ckks*/
+// Outputs come out at scale 2^(m_scale - 1) on top of a first prime of
+// m_scale bits, every further tower adds m_scale - 1 bits of range
+static std::unordered_map<std::string, uint32_t> outputTowers(const Dag& dag) {
+  std::unordered_map<std::string, uint32_t> towers;
+  uint32_t tower_bits = dag.m_scale - 1;
+  for (auto& entry : dag.getOutputs()) {
+    uint32_t range = entry.second->has<RangeAttr>()
+                         ? entry.second->get<RangeAttr>()
+                         : dag.m_scale;
+    towers[entry.first] = 1 + (range + tower_bits - 1) / tower_bits;
+  }
+  return towers;
+}
+
 /*ckks*/
 int OpenFheCkksAdapter::setParaAndSig(
     std::shared_ptr<ParametersInterface> ptr_parameters) {
@@ -52,15 +67,29 @@ int OpenFheCkksAdapter::genKeys(const string& alo_name, const Dag& dag) {
   if (m_en_params == nullptr) {
     throw std::logic_error("genKeys ckks_en_params null !");
   }
+  m_ckks_executors.clear();
+  m_bfv_executors.clear();
   m_openfhe_ctx = generateKeys(*(m_en_params));
   return 0;
 }
 
+void OpenFheAdapterBase::applyEncryptMode() {
+  auto& secret_ctx = std::get<1>(m_openfhe_ctx);
+  if (m_encrypt_mode == SYMMETRIC_MODE && secret_ctx == nullptr) {
+    throw std::logic_error("symmetric encrypt openfhe secret_ctx null !");
+  }
+  std::get<0>(m_openfhe_ctx)
+      ->setSymmetricKey(m_encrypt_mode == SYMMETRIC_MODE
+                            ? secret_ctx->getSecretKey()
+                            : OpenFhePrivateKey());
+}
+
 int OpenFheCkksAdapter::encrypt(const Valuation& inputs,bool replace) {
   auto& public_ctx = std::get<0>(m_openfhe_ctx);
   if (public_ctx == nullptr || m_signature == nullptr) {
     throw std::logic_error("encrypt public_ctx / ckks_signaturenull !");
   }
+  applyEncryptMode();
   // Possible multiple encryption results
   Valuation new_inputs = inputs;
   for (auto& in : inputs) {
@@ -80,6 +109,7 @@ int OpenFheCkksAdapter::encrypt(const Valuation& inputs,bool replace) {
   if (p_valuation->isEmpty()) {
     return OPENFHE_ENCRYPT_EMPTY_RESULT;
   }
+  touchInputs(*p_valuation);
   if(replace)
     m_valution = std::move(p_valuation);
   else
@@ -101,13 +131,36 @@ int OpenFheCkksAdapter::decrypt() {
   return 0;
 }
 
+int OpenFheCkksAdapter::decryptPartial(const std::vector<std::string>& names,
+                                       const SlotSelection& slots) {
+  auto& secret_ctx = std::get<1>(m_openfhe_ctx);
+  if (secret_ctx == nullptr) {
+    throw std::logic_error("decrypt openfhe secret_ctx null !");
+  }
+  m_output_de = std::make_shared<Valuation>(secret_ctx->decryptPartial<double>(
+      *m_output_en, *m_signature, names, slots));
+  if (m_output_de->empty()) {
+    return OPENFHE_DECRYPT_RESULT_EMPTY;
+  }
+  return 0;
+}
+
 int OpenFheCkksAdapter::execute(Dag& dag) {
   auto& public_ctx = std::get<0>(m_openfhe_ctx);
   if (public_ctx == nullptr) {
     throw std::logic_error("execute public_ctx null !");
   }
-  m_output_en = std::make_shared<OpenFheValuation>(
-      public_ctx->execute<CkksOpenFheExecutor>(dag, *m_valution));
+  if (dag.isIncrementalExe()) {
+    m_output_en =
+        std::make_shared<OpenFheValuation>(public_ctx->executeIncremental(
+            dag, *m_valution, m_input_versions, m_ckks_executors[&dag]));
+  } else {
+    m_output_en = std::make_shared<OpenFheValuation>(
+        public_ctx->execute<CkksOpenFheExecutor>(dag, *m_valution));
+  }
+  if (dag.m_output_mod_switch) {
+    public_ctx->compressOutputs(*m_output_en, outputTowers(dag));
+  }
   return 0;
 }
 
@@ -126,6 +179,8 @@ int OpenFheBfvAdapter::genKeys(const string& alo_name, const Dag& dag) {
   if (m_en_params == nullptr) {
     throw std::logic_error("genKeys ckks_en_params null !");
   }
+  m_ckks_executors.clear();
+  m_bfv_executors.clear();
   m_openfhe_ctx = generateKeys(*(m_en_params));
   return 0;
 }
@@ -135,6 +190,7 @@ int OpenFheBfvAdapter::encrypt(const Valuation& inputs, bool replace) {
   if (public_ctx == nullptr || m_signature == nullptr) {
     throw std::logic_error("encrypt public_ctx / signature null !");
   }
+  applyEncryptMode();
   // Possible multiple encryption results
   Valuation new_inputs = inputs;
   for (auto& in : inputs) {
@@ -154,6 +210,7 @@ int OpenFheBfvAdapter::encrypt(const Valuation& inputs, bool replace) {
   if (p_valuation->isEmpty()) {
     return OPENFHE_ENCRYPT_EMPTY_RESULT;
   }
+  touchInputs(*p_valuation);
   if(replace)
     m_valution = std::move(p_valuation);
   else
@@ -174,11 +231,31 @@ int OpenFheBfvAdapter::decrypt() {
   return 0;
 }
 
+int OpenFheBfvAdapter::decryptPartial(const std::vector<std::string>& names,
+                                      const SlotSelection& slots) {
+  auto& secret_ctx = std::get<1>(m_openfhe_ctx);
+  if (secret_ctx == nullptr) {
+    throw std::logic_error("decrypt openfhe secret_ctx null !");
+  }
+  m_output_de = std::make_shared<Valuation>(secret_ctx->decryptPartial<int64_t>(
+      *m_output_en, *m_signature, names, slots));
+  if (m_output_de->empty()) {
+    return OPENFHE_DECRYPT_RESULT_EMPTY;
+  }
+  return 0;
+}
+
 int OpenFheBfvAdapter::execute(Dag& dag) {
   auto& public_ctx = std::get<0>(m_openfhe_ctx);
   if (public_ctx == nullptr) {
     throw std::logic_error("execute public_ctx null !");
   }
+  if (dag.isIncrementalExe()) {
+    m_output_en =
+        std::make_shared<OpenFheValuation>(public_ctx->executeIncremental(
+            dag, *m_valution, m_input_versions, m_bfv_executors[&dag]));
+    return 0;
+  }
   m_output_en = std::make_shared<OpenFheValuation>(
       public_ctx->execute<BfvOpenfheExecutor>(dag, *m_valution));
   return 0;
@@ -72,7 +72,21 @@ class OpenFheAdapterBase : public AdapterInterface {
 
   int mergeInput(std::unique_ptr<OpenFheValuation> &p_valuation);
 
+  virtual int setEncryptMode(ENCRYPT_MODE mode) {
+    m_encrypt_mode = mode;
+    return 0;
+  }
+
+  virtual void releaseExecutor(const Dag &dag) {
+    m_ckks_executors.erase(&dag);
+    m_bfv_executors.erase(&dag);
+  }
+
  protected:
+  /**
+   * @brief Hand the secret key to the public context in SYMMETRIC_MODE
+   */
+  void applyEncryptMode();
   
   int serializeCommInfo(const DagSerializePara &serialize_para,msg::OpenFheAloInfo& tmp_info);
   int deserializeCommInfo(const msg::OpenFheAloInfo tmp_info);
@@ -82,6 +96,11 @@ class OpenFheAdapterBase : public AdapterInterface {
   std::shared_ptr<OpenFheValuation> m_output_en = nullptr;
   std::tuple<std::unique_ptr<OpenFhePublic>, std::unique_ptr<OpenFheSecret>>
       m_openfhe_ctx;
+  // Executors keeping their values for incremental execution, per DAG
+  std::unordered_map<const Dag *, std::unique_ptr<CkksOpenFheExecutor>>
+      m_ckks_executors;
+  std::unordered_map<const Dag *, std::unique_ptr<BfvOpenfheExecutor>>
+      m_bfv_executors;
 };
 
 /**
@@ -99,6 +118,8 @@ class OpenFheCkksAdapter : public OpenFheAdapterBase {
 
   virtual int encrypt(const Valuation &inputs,bool replace);
   virtual int decrypt();
+  virtual int decryptPartial(const std::vector<std::string> &names,
+                             const SlotSelection &slots);
   virtual int execute(Dag &dag);
 
   /*Serialization-related, defined in proto*/
@@ -130,6 +151,8 @@ class OpenFheBfvAdapter : public OpenFheAdapterBase {
 
   virtual int encrypt(const Valuation &inputs, bool replace);
   virtual int decrypt();
+  virtual int decryptPartial(const std::vector<std::string> &names,
+                             const SlotSelection &slots);
   virtual int execute(Dag &dag);
 
   /*Serialization-related, defined in proto*/
@@ -27,6 +27,47 @@
 
 namespace iyfc {
 
+/**
+ * @brief Probe measuring every ciphertext on the secret key next to the
+ * static estimate of its node, for DAGs with the noise check on
+ */
+static CipherProbe makeNoiseProbe(
+    std::tuple<std::unique_ptr<SEALPublic>, std::unique_ptr<SEALSecret>>&
+        seal_ctx,
+    std::shared_ptr<NoiseEstimator> estimator, bool bfv,
+    std::vector<NoiseMeasurement>& measurements) {
+  auto* secret_ctx = std::get<1>(seal_ctx).get();
+  if (secret_ctx == nullptr) {
+    throw std::logic_error("noise check needs the seal secret_ctx !");
+  }
+  measurements.clear();
+  return [=, &measurements](const NodePtr& node,
+                            const seal::Ciphertext& cipher) {
+    NoiseMeasurement measurement;
+    measurement.node_index = node->m_index;
+    measurement.op = getOpName(node->m_op_type);
+    measurement.estimated_bits = estimator->getNodeBits(node);
+    measurement.measured_bits = bfv ? secret_ctx->noiseBudget(cipher)
+                                    : secret_ctx->imagErrorBits(cipher);
+    measurements.push_back(std::move(measurement));
+  };
+}
+
+/**
+ * @brief Hand the secret key to the public context in SYMMETRIC_MODE
+ */
+static void applySealEncryptMode(
+    std::tuple<std::unique_ptr<SEALPublic>, std::unique_ptr<SEALSecret>>&
+        seal_ctx,
+    ENCRYPT_MODE mode) {
+  auto& secret_ctx = std::get<1>(seal_ctx);
+  if (mode == SYMMETRIC_MODE && secret_ctx == nullptr) {
+    throw std::logic_error("symmetric encrypt seal secret_ctx null !");
+  }
+  std::get<0>(seal_ctx)->setSymmetricKey(
+      mode == SYMMETRIC_MODE ? &secret_ctx->getSecretKey() : nullptr);
+}
+
 int SealCkksAdapter::setParaAndSig(
     std::shared_ptr<ParametersInterface> ptr_parameters) {
   // Cast to subclass pointer
@@ -42,39 +83,34 @@ int SealCkksAdapter::genKeys(const string& alo_name, const Dag& dag) {
   if (m_ckks_en_params == nullptr) {
     throw std::logic_error("genKeys ckks_en_params null !");
   }
+  m_executors.clear();
   m_seal_ctx = generateKeys(*(m_ckks_en_params));
   return 0;
 }
 
 int SealCkksAdapter::encrypt(const Valuation& inputs, bool replace) {
+  return encryptInputs(inputs, replace);
+}
+
+int SealCkksAdapter::encryptSpans(const InputSpans& inputs, bool replace) {
+  return encryptInputs(inputs, replace);
+}
+
+template <typename Inputs>
+int SealCkksAdapter::encryptInputs(const Inputs& inputs, bool replace) {
   auto& public_ctx = std::get<0>(m_seal_ctx);
   if (public_ctx == nullptr || m_ckks_signature == nullptr) {
     throw std::logic_error("encrypt public_ctx / ckks_signaturenull !");
   }
-  /*
-  Encrypting multiple results
-  There might be cases where input data types are int64, etc., which are not compatible.
-  Here, they are uniformly switched to double for copying.
-  */
-  Valuation new_inputs = inputs;
-  for (auto& in : inputs) {
-    if (std::holds_alternative<std::vector<int64_t>>(in.second)) {
-      auto v = std::get<std::vector<int64_t>>(in.second);
-      vector<double> vec_double_inputs(v.size());
-      std::transform(v.begin(), v.end(), vec_double_inputs.begin(),
-                     [](const int64_t int_value) {
-                       return static_cast<double>(int_value);
-                     });
-
-      new_inputs[in.first] = vec_double_inputs;
-    }
-  }
+  applySealEncryptMode(m_seal_ctx, m_encrypt_mode);
+  // int64 inputs are converted to double while encoding, no copy here
   unique_ptr<SEALValuation> p_valuation = std::make_unique<SEALValuation>(
-      public_ctx->encrypt<double>(new_inputs, *m_ckks_signature));
+      public_ctx->encrypt<double>(inputs, *m_ckks_signature));
 
   if (p_valuation->isEmpty()) {
     return SEAL_ENCRYPT_EMPTY_RESULT;
   }
+  touchInputs(*p_valuation);
   // Decide whether to replace or merge the input valuation
   if (replace)
     m_ckks_valution = std::move(p_valuation);
@@ -96,15 +132,55 @@ int SealCkksAdapter::decrypt() {
   return 0;
 }
 
+int SealCkksAdapter::decryptPartial(const std::vector<std::string>& names,
+                                    const SlotSelection& slots) {
+  auto& secret_ctx = std::get<1>(m_seal_ctx);
+  if (secret_ctx == nullptr) {
+    throw std::logic_error("decrypt seal secret_ctx null !");
+  }
+  m_output_de = std::make_shared<Valuation>(secret_ctx->decryptPartial<double>(
+      *m_ckks_output_en, *m_ckks_signature, names, slots));
+  if (m_output_de->empty()) {
+    return SEAL_DECRYPT_RESULT_EMPTY;
+  }
+  return 0;
+}
+
 int SealCkksAdapter::execute(Dag& dag) {
   auto& public_ctx = std::get<0>(m_seal_ctx);
   if (public_ctx == nullptr) {
     throw std::logic_error("execute public_ctx null !");
   }
+  CipherProbe probe;
+  if (dag.isNoiseCheck()) {
+    if (dag.m_has_complex) {
+      throw std::logic_error("noise check of complex slots is not supported !");
+    }
+    auto estimator = std::make_shared<NoiseEstimator>(dag);
+    NoiseReport report;
+    estimator->estimateCkks(*m_ckks_en_params, DEFAULT_CKKS_PRECISION_BITS,
+                            report);
+    probe = makeNoiseProbe(m_seal_ctx, estimator, false, m_noise_measurements);
+  }
   // m_ckks_output_en.reset();
-
+  if (dag.isIncrementalExe()) {
+    m_ckks_output_en =
+        std::make_shared<SEALValuation>(public_ctx->executeIncremental(
+            dag, *m_ckks_valution, m_input_versions, m_executors[&dag],
+            probe));
+    return 0;
+  }
   m_ckks_output_en = std::make_shared<SEALValuation>(
-      public_ctx->execute<CkksSealExecutor>(dag, *m_ckks_valution));
+      public_ctx->execute<CkksSealExecutor>(dag, *m_ckks_valution, probe));
+  return 0;
+}
+
+int SealCkksAdapter::estimateNoise(Dag& dag, uint32_t precision_bits,
+                                   NoiseReport& report) {
+  if (m_ckks_en_params == nullptr) {
+    throw std::logic_error("estimateNoise ckks_en_params null !");
+  }
+  NoiseEstimator(dag).estimateCkks(*m_ckks_en_params, precision_bits, report);
   return 0;
 }
 
@@ -117,6 +193,31 @@ int SealCkksAdapter::mergeInput(std::unique_ptr<SEALValuation>& p_valuation) {
   return 0;
 }
 
+int SealCkksAdapter::setEncryptPool(const EncryptPoolConfig& config) {
+  auto& public_ctx = std::get<0>(m_seal_ctx);
+  if (public_ctx == nullptr || m_ckks_signature == nullptr) {
+    throw std::logic_error("setEncryptPool public_ctx / ckks_signature null !");
+  }
+  public_ctx->setZeroPool(config, *m_ckks_signature);
+  return 0;
+}
+
+int SealCkksAdapter::getEncryptPoolMetrics(EncryptPoolMetrics& metrics) {
+  auto& public_ctx = std::get<0>(m_seal_ctx);
+  if (public_ctx == nullptr) {
+    throw std::logic_error("getEncryptPoolMetrics public_ctx null !");
+  }
+  metrics = public_ctx->getZeroPoolMetrics();
+  return 0;
+}
+
+uint32_t SealCkksAdapter::getSlotCount() const {
+  if (m_ckks_en_params == nullptr) {
+    throw std::logic_error("getSlotCount ckks_en_params null !");
+  }
+  return m_ckks_en_params->poly_modulus_degree / 2;
+}
+
 int SealBfvAdapter::setParaAndSig(
     std::shared_ptr<ParametersInterface> ptr_parameters) {
   // Cast to subclass pointer
@@ -132,39 +233,33 @@ int SealBfvAdapter::genKeys(const string& alo_name, const Dag& dag) {
   if (m_en_params == nullptr) {
     throw std::logic_error("genKeys bfv_en_params null !");
   }
+  m_executors.clear();
   m_seal_ctx = generateKeys(*(m_en_params));
   return 0;
 }
 
 int SealBfvAdapter::encrypt(const Valuation& inputs, bool replace) {
+  return encryptInputs(inputs, replace);
+}
+
+int SealBfvAdapter::encryptSpans(const InputSpans& inputs, bool replace) {
+  return encryptInputs(inputs, replace);
+}
+
+template <typename Inputs>
+int SealBfvAdapter::encryptInputs(const Inputs& inputs, bool replace) {
   auto& public_ctx = std::get<0>(m_seal_ctx);
   if (public_ctx == nullptr || m_signature == nullptr) {
     throw std::logic_error("encrypt public_ctx / ckks_signaturenull !");
   }
-  /*
-  Encrypting multiple results
-  There might be cases where input data types are int64, etc., which are not compatible.
-  Here, they are uniformly switched to double for copying.
-  */
-  Valuation new_inputs = inputs;
-  for (auto& in : inputs) {
-    if (std::holds_alternative<std::vector<double>>(in.second)) {
-      auto v = std::get<std::vector<double>>(in.second);
-      vector<int64_t> vec_double_inputs(v.size());
-      std::transform(v.begin(), v.end(), vec_double_inputs.begin(),
-                     [](const double int_value) {
-                       return static_cast<int64_t>(int_value);
-                     });
-
-      new_inputs[in.first] = vec_double_inputs;
-    }
-  }
-
+  applySealEncryptMode(m_seal_ctx, m_encrypt_mode);
+  // double inputs are truncated to int64 while encoding, no copy here
   unique_ptr<SEALValuation> p_valuation = std::make_unique<SEALValuation>(
-      public_ctx->encrypt<int64_t>(new_inputs, *m_signature));
+      public_ctx->encrypt<int64_t>(inputs, *m_signature));
   if (p_valuation->isEmpty()) {
     return SEAL_ENCRYPT_EMPTY_RESULT;
   }
+  touchInputs(*p_valuation);
   if (replace)
     m_valution = std::move(p_valuation);
   else
@@ -185,13 +280,48 @@ int SealBfvAdapter::decrypt() {
   return 0;
 }
 
+int SealBfvAdapter::decryptPartial(const std::vector<std::string>& names,
+                                   const SlotSelection& slots) {
+  auto& secret_ctx = std::get<1>(m_seal_ctx);
+  if (secret_ctx == nullptr) {
+    throw std::logic_error("decrypt seal secret_ctx null !");
+  }
+  m_output_de = std::make_shared<Valuation>(secret_ctx->decryptPartial<int64_t>(
+      *m_output_en, *m_signature, names, slots));
+  if (m_output_de->empty()) {
+    return SEAL_DECRYPT_RESULT_EMPTY;
+  }
+  return 0;
+}
+
 int SealBfvAdapter::execute(Dag& dag) {
   auto& public_ctx = std::get<0>(m_seal_ctx);
   if (public_ctx == nullptr) {
     throw std::logic_error("execute public_ctx null !");
   }
+  CipherProbe probe;
+  if (dag.isNoiseCheck()) {
+    auto estimator = std::make_shared<NoiseEstimator>(dag);
+    NoiseReport report;
+    estimator->estimateBfv(*m_en_params, report);
+    probe = makeNoiseProbe(m_seal_ctx, estimator, true, m_noise_measurements);
+  }
+  if (dag.isIncrementalExe()) {
+    m_output_en = std::make_shared<SEALValuation>(public_ctx->executeIncremental(
+        dag, *m_valution, m_input_versions, m_executors[&dag], probe));
+    return 0;
+  }
   m_output_en = std::make_shared<SEALValuation>(
-      public_ctx->execute<BfvSealExecutor>(dag, *m_valution));
+      public_ctx->execute<BfvSealExecutor>(dag, *m_valution, probe));
+  return 0;
+}
+
+int SealBfvAdapter::estimateNoise(Dag& dag, uint32_t precision_bits,
+                                  NoiseReport& report) {
+  if (m_en_params == nullptr) {
+    throw std::logic_error("estimateNoise bfv en_params null !");
+  }
+  NoiseEstimator(dag).estimateBfv(*m_en_params, report);
   return 0;
 }
 
@@ -204,4 +334,30 @@ int SealBfvAdapter::mergeInput(std::unique_ptr<SEALValuation>& p_valuation) {
   return 0;
 }
 
+int SealBfvAdapter::setEncryptPool(const EncryptPoolConfig& config) {
+  auto& public_ctx = std::get<0>(m_seal_ctx);
+  if (public_ctx == nullptr || m_signature == nullptr) {
+    throw std::logic_error("setEncryptPool public_ctx / signature null !");
+  }
+  public_ctx->setZeroPool(config, *m_signature);
+  return 0;
+}
+
+int SealBfvAdapter::getEncryptPoolMetrics(EncryptPoolMetrics& metrics) {
+  auto& public_ctx = std::get<0>(m_seal_ctx);
+  if (public_ctx == nullptr) {
+    throw std::logic_error("getEncryptPoolMetrics public_ctx null !");
+  }
+  metrics = public_ctx->getZeroPoolMetrics();
+  return 0;
+}
+
+uint32_t SealBfvAdapter::getSlotCount() const {
+  if (m_en_params == nullptr) {
+    throw std::logic_error("getSlotCount bfv_en_params null !");
+  }
+  // Both rows of the batching matrix
+  return m_en_params->poly_modulus_degree;
+}
+
 }  // namespace iyfc
\ No newline at end of file
@@ -38,6 +38,7 @@
 #include "alo_register.h"
 #include "err_code.h"
 #include "proto/iyfc.pb.h"
+#include "seal/alo/noise_estimator.h"
 #include "seal/alo/seal_ckks_handler.h"
 
 
@@ -54,7 +55,10 @@ class SealCkksAdapter : public AdapterInterface {
   SealCkksAdapter() {}
   virtual ~SealCkksAdapter() {}
   virtual int encrypt(const Valuation &inputs, bool replace);
+  virtual int encryptSpans(const InputSpans &inputs, bool replace);
   virtual int decrypt();
+  virtual int decryptPartial(const std::vector<std::string> &names,
+                             const SlotSelection &slots);
   virtual int execute(Dag &dag);
   virtual int setParaAndSig(
       std::shared_ptr<ParametersInterface> ptr_parameters);
@@ -70,9 +74,28 @@ class SealCkksAdapter : public AdapterInterface {
   virtual int serializeOutputInfo(string &str_info);
   virtual int deserializeOutputInfo(const string &str_info);
 
+  virtual int setEncryptMode(ENCRYPT_MODE mode) {
+    m_encrypt_mode = mode;
+    return 0;
+  }
+  virtual int setEncryptPool(const EncryptPoolConfig &config);
+  virtual int getEncryptPoolMetrics(EncryptPoolMetrics &metrics);
+  virtual uint32_t getSlotCount() const;
+  virtual void releaseExecutor(const Dag &dag) { m_executors.erase(&dag); }
+  virtual int estimateNoise(Dag &dag, uint32_t precision_bits,
+                            NoiseReport &report);
+  virtual int getNoiseMeasurements(
+      std::vector<NoiseMeasurement> &measurements) {
+    measurements = m_noise_measurements;
+    return 0;
+  }
+
   int mergeInput(std::unique_ptr<SEALValuation>& p_valuation);
 
  private:
+  template <typename Inputs>
+  int encryptInputs(const Inputs &inputs, bool replace);
+
   std::shared_ptr<SealSignature> m_ckks_signature = nullptr;
   std::shared_ptr<CKKSParameters> m_ckks_en_params = nullptr;
 
@@ -81,6 +104,11 @@ class SealCkksAdapter : public AdapterInterface {
 
   std::tuple<std::unique_ptr<SEALPublic>, std::unique_ptr<SEALSecret>>
       m_seal_ctx;
+  // Filled by execute when the DAG has the noise check on
+  std::vector<NoiseMeasurement> m_noise_measurements;
+  // Executors keeping their values for incremental execution, per DAG
+  std::unordered_map<const Dag *, std::unique_ptr<CkksSealExecutor>>
+      m_executors;
 };
 
 
@@ -95,7 +123,10 @@ class SealBfvAdapter : public AdapterInterface {
   SealBfvAdapter() {}
   virtual ~SealBfvAdapter() {}
   virtual int encrypt(const Valuation &inputs, bool replace);
+  virtual int encryptSpans(const InputSpans &inputs, bool replace);
   virtual int decrypt();
+  virtual int decryptPartial(const std::vector<std::string> &names,
+                             const SlotSelection &slots);
   virtual int execute(Dag &dag);
   virtual int setParaAndSig(
       std::shared_ptr<ParametersInterface> ptr_parameters);
@@ -111,9 +142,28 @@ class SealBfvAdapter : public AdapterInterface {
   virtual int serializeOutputInfo(string &str_info);
   virtual int deserializeOutputInfo(const string &str_info);
 
+  virtual int setEncryptMode(ENCRYPT_MODE mode) {
+    m_encrypt_mode = mode;
+    return 0;
+  }
+  virtual int setEncryptPool(const EncryptPoolConfig &config);
+  virtual int getEncryptPoolMetrics(EncryptPoolMetrics &metrics);
+  virtual uint32_t getSlotCount() const;
+  virtual void releaseExecutor(const Dag &dag) { m_executors.erase(&dag); }
+  virtual int estimateNoise(Dag &dag, uint32_t precision_bits,
+                            NoiseReport &report);
+  virtual int getNoiseMeasurements(
+      std::vector<NoiseMeasurement> &measurements) {
+    measurements = m_noise_measurements;
+    return 0;
+  }
+
   int mergeInput(std::unique_ptr<SEALValuation>& p_valuation);
 
  private:
+  template <typename Inputs>
+  int encryptInputs(const Inputs &inputs, bool replace);
+
   std::shared_ptr<SealSignature> m_signature = nullptr;
   std::shared_ptr<BfvParameters> m_en_params = nullptr;
 
@@ -122,6 +172,11 @@ class SealBfvAdapter : public AdapterInterface {
 
   std::tuple<std::unique_ptr<SEALPublic>, std::unique_ptr<SEALSecret>>
       m_seal_ctx;
+  // Filled by execute when the DAG has the noise check on
+  std::vector<NoiseMeasurement> m_noise_measurements;
+  // Executors keeping their values for incremental execution, per DAG
+  std::unordered_map<const Dag *, std::unique_ptr<BfvSealExecutor>>
+      m_executors;
 };
 
 
@@ -97,7 +97,8 @@ inline void printValuation(const Valuation &val, size_t max_print_size = 100) {
             [&](const std::vector<int64_t> &v) { print_vector(v,max_print_size); },
             [&](const double &v) { std::cout << "double value: " << v << "\n"; },
             [&](const int64_t &v) { std::cout << "int64_t value: " << v << "\n"; },
-            [&](const uint8_t &v) { std::cout << " uint8_t value: " << v << "\n"; }},
+            [&](const uint8_t &v) { std::cout << " uint8_t value: " << v << "\n"; },
+            [&](const std::vector<std::complex<double>> &v) { print_vector(v, max_print_size); }},
         obj);
   }
 }
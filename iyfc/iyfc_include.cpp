@@ -29,6 +29,7 @@
 #include "proto/save_load.h"
 #include "util/clean_util.h"
 #include "util/math_util.h"
+#include "util/thread_util.h"
 
 using namespace std;
 namespace iyfc {
@@ -58,6 +59,14 @@ Expr IYFC_SO_EXPORT setInputName(DagPtr dag_ptr, const std::string& name) {
   return dag_ptr->setInput(name);
 }
 
+Expr IYFC_SO_EXPORT setComplexInputName(DagPtr dag_ptr,
+                                        const std::string& name) {
+  Expr input = dag_ptr->setInput(name);
+  input.m_nodeptr->set<ComplexAttr>(1);
+  dag_ptr->m_has_complex = true;
+  return input;
+}
+
 int IYFC_SO_EXPORT setOutput(DagPtr dag_ptr, const string& name,
                              const Expr& epxr) {
   dag_ptr->setOutput(name, epxr);
@@ -84,13 +93,19 @@ int IYFC_SO_EXPORT encryptInput(DagPtr dag_ptr, const Valuation& inputs,
     if (std::holds_alternative<std::vector<double>>(item.second)) {
       // vector
       const auto& v = std::get<std::vector<double>>(item.second);
-      if (v.size() != dag_ptr->getVecSize()) {
+      if (v.size() != dag_ptr->getLogicalVecSize()) {
         throw std::logic_error("input size not match ");
       }
     } else if (std::holds_alternative<std::vector<int64_t>>(item.second)) {
       // vector
       const auto& v = std::get<std::vector<int64_t>>(item.second);
-      if (v.size() != dag_ptr->getVecSize()) {
+      if (v.size() != dag_ptr->getLogicalVecSize()) {
+        throw std::logic_error("input size not match ");
+      }
+    } else if (std::holds_alternative<std::vector<std::complex<double>>>(
+                   item.second)) {
+      const auto& v = std::get<std::vector<std::complex<double>>>(item.second);
+      if (v.size() != dag_ptr->getLogicalVecSize()) {
         throw std::logic_error("input size not match ");
       }
     } else if (std::holds_alternative<double>(item.second)) {
@@ -103,11 +118,43 @@ int IYFC_SO_EXPORT encryptInput(DagPtr dag_ptr, const Valuation& inputs,
   return 0;
 }
 
+int IYFC_SO_EXPORT encryptInputSpans(DagPtr dag_ptr, const InputSpans& inputs,
+                                     bool replace) {
+  for (const auto& item : inputs) {
+    if (item.second.size != 1 &&
+        item.second.size != dag_ptr->getLogicalVecSize()) {
+      throw std::logic_error("input size not match ");
+    }
+  }
+  dag_ptr->encryptInputSpans(inputs, replace);
+  return 0;
+}
+
+int IYFC_SO_EXPORT setEncryptMode(DagPtr dag_ptr, ENCRYPT_MODE mode) {
+  return dag_ptr->setEncryptMode(mode);
+}
+
+int IYFC_SO_EXPORT setEncryptPool(DagPtr dag_ptr,
+                                  const EncryptPoolConfig& config) {
+  return dag_ptr->setEncryptPool(config);
+}
+
+int IYFC_SO_EXPORT getEncryptPoolMetrics(DagPtr dag_ptr,
+                                         EncryptPoolMetrics& metrics) {
+  return dag_ptr->getEncryptPoolMetrics(metrics);
+}
+
 // exedag
 
 int IYFC_SO_EXPORT exeDag(DagPtr dag_ptr,
                           const std::unordered_set<std::string>& set_inputs) {
-  dag_ptr->executor();
+  dag_ptr->executor(set_inputs);
+  return 0;
+}
+
+int IYFC_SO_EXPORT exeDagOutputs(DagPtr dag_ptr,
+                                 const std::vector<std::string>& output_names) {
+  dag_ptr->executorForOutputs(output_names);
   return 0;
 }
 
@@ -117,6 +164,20 @@ int IYFC_SO_EXPORT decryptOutput(DagPtr dag_ptr, Valuation& outputs) {
   return 0;
 }
 
+int IYFC_SO_EXPORT decryptPartialOutput(DagPtr dag_ptr,
+                                        const std::vector<std::string>& names,
+                                        Valuation& outputs,
+                                        const SlotSelection& slots) {
+  dag_ptr->getPartialDecryptOutput(names, slots, outputs);
+  return 0;
+}
+
+int IYFC_SO_EXPORT decryptOutputTo(DagPtr dag_ptr, OutputBuffers& outputs,
+                                   const SlotSelection& slots) {
+  dag_ptr->getDecryptOutputTo(outputs, slots);
+  return 0;
+}
+
 //
 int IYFC_SO_EXPORT setDagSerializePara(DagPtr dag_ptr, bool need_node_info,
                                        bool need_genkey_info,
@@ -215,38 +276,48 @@ int IYFC_SO_EXPORT encodeOrgInputforCmp(const std::vector<uint32_t>& vec_org,
   uint32_t composemod = (p - 1) / 2 + 1;
   // The polynomial dimension is currently fixed at 16384
 
-  vector<double> compose_vec_x;
+  vector<double> compose_vec_x(CMP_DAG_SIZE, 0.0);
   uint32_t bits = CMP_BIT_LEN;
+  bulkDecimalConvert(vec_org.data(), num_cnt, composemod, bits,
+                     compose_vec_x.data());
 
-  for (const auto& item : vec_org) {
-    vector<uint32_t> tmp_vec = decimalConvert(item, composemod, bits);
-    compose_vec_x.insert(compose_vec_x.end(), tmp_vec.begin(), tmp_vec.end());
-  }
-
-  compose_vec_x.resize(CMP_DAG_SIZE);
-  inputs[input_name] = compose_vec_x;
+  inputs[input_name] = std::move(compose_vec_x);
   return 0;
 }
 
+uint32_t IYFC_SO_EXPORT encodeOrgInputforCmpTiles(
+    const std::vector<uint32_t>& vec_org, const string& input_name,
+    Valuation& inputs) {
+  uint32_t p = CMP_P;
+  uint32_t composemod = (p - 1) / 2 + 1;
+  std::vector<std::vector<double>> tiles;
+  bulkDecimalConvertTiles(vec_org, composemod, CMP_BIT_LEN, CMP_DAG_SIZE,
+                          tiles);
+  for (size_t t = 0; t < tiles.size(); t++) {
+    inputs[input_name + "_" + std::to_string(t)] = std::move(tiles[t]);
+  }
+  return tiles.size();
+}
+
 int IYFC_SO_EXPORT getCmpOutputs(DagPtr dag_ptr, uint32_t num_cnt,
                                  const std::string& result_name,
                                  std::vector<uint32_t>& vec_results) {
   uint32_t p = CMP_P;           // Fixed decomposition base of 3
   uint32_t bits = CMP_BIT_LEN;  // Fixed to 32 bits
   Valuation outputs;
-  dag_ptr->getDecryptOutput(outputs);
+  // Only the first bit of every number carries the result
+  SlotSelection slots;
+  slots.stride = bits;
+  slots.count = num_cnt;
+  dag_ptr->getPartialDecryptOutput({result_name}, slots, outputs);
 
   if (outputs.find(result_name) != outputs.end()) {
     const auto& v = std::get<std::vector<double>>(outputs[result_name]);
-    uint32_t len = bits * num_cnt;
-    for (uint32_t i = 0; i < len; i++) {
-      // Take the first bit of the result
-      if (i % CMP_BIT_LEN == 0) {
-        // Take the result modulo p   get the final matrix %p
-        uint32_t tmp_one = uint32_t(round(v[i])) % p;
-        // =1 indicates x < y, =0 (3) indicates x >= y
-        vec_results.emplace_back(tmp_one);
-      }
+    for (auto value : v) {
+      // Take the result modulo p   get the final matrix %p
+      uint32_t tmp_one = uint32_t(round(value)) % p;
+      // =1 indicates x < y, =0 (3) indicates x >= y
+      vec_results.emplace_back(tmp_one);
     }
 
   } else {
@@ -286,32 +357,27 @@ int IYFC_SO_EXPORT encodeOrgInputforSort(const std::vector<uint32_t>& vec_org,
   uint32_t p = CMP_P;
   uint32_t composemod = (p - 1) / 2 + 1;
 
-  uint32_t d = 2, l_first = 2, l_second = 2, l_third = 2, l_fourth = 2;
-
-  // Input after base decomposition
-  vector<uint32_t> vec_x;
-  vector<uint32_t> vec_y;
-  encodeSortUpInput(vec_org, vec_x);
-  encodeSortDownInput(vec_org, vec_y);
-
-  // Data preprocessing
-  vector<double> compose_vec_x;
-  vector<double> compose_vec_y;
+  // Decompose each value once, x and y only repeat the digit blocks
+  // x = [1,1,1,1,2,2,2,2,...], y = [1,2,3,4,1,2,3,4,...], see encodeSortUpInput
+  uint32_t input_size = vec_org.size();
   uint32_t bits = CMP_BIT_LEN;
-  for (const auto& item : vec_x) {
-    vector<uint32_t> tmp_vec = decimalConvert(item, composemod, bits);
-    compose_vec_x.insert(compose_vec_x.end(), tmp_vec.begin(), tmp_vec.end());
-  }
-
-  for (const auto& item : vec_y) {
-    vector<uint32_t> tmp_vec = decimalConvert(item, composemod, bits);
-    compose_vec_y.insert(compose_vec_y.end(), tmp_vec.begin(), tmp_vec.end());
+  vector<double> digits(size_t(input_size) * bits);
+  bulkDecimalConvert(vec_org.data(), input_size, composemod, bits,
+                     digits.data());
+
+  vector<double> compose_vec_x(CMP_DAG_SIZE, 0.0);
+  vector<double> compose_vec_y(CMP_DAG_SIZE, 0.0);
+  for (uint32_t i = 0; i < input_size; i++) {
+    for (uint32_t j = 0; j < input_size; j++) {
+      size_t dst = (size_t(i) * input_size + j) * bits;
+      std::copy_n(digits.begin() + size_t(i) * bits, bits,
+                  compose_vec_x.begin() + dst);
+      std::copy_n(digits.begin() + size_t(j) * bits, bits,
+                  compose_vec_y.begin() + dst);
+    }
   }
-
-  compose_vec_x.resize(CMP_DAG_SIZE);
-  compose_vec_y.resize(CMP_DAG_SIZE);
-  inputs["x"] = compose_vec_x;
-  inputs["y"] = compose_vec_y;
+  inputs["x"] = std::move(compose_vec_x);
+  inputs["y"] = std::move(compose_vec_y);
   return 0;
 }
 
@@ -342,29 +408,29 @@ int IYFC_SO_EXPORT
 getSortOutputs(DagPtr dag_ptr, uint32_t num_cnt,
                std::vector<vector<uint32_t>>& matrix_result) {
   Valuation outputs;
-  dag_ptr->getDecryptOutput(outputs);
   // Matrix result
   uint32_t bits = CMP_BIT_LEN;
   uint32_t p = CMP_P;
+  // Take the first bit of every result
+  SlotSelection slots;
+  slots.stride = bits;
+  slots.count = num_cnt * num_cnt;
+  dag_ptr->getPartialDecryptOutput({"result_out_less"}, slots, outputs);
 
   if (outputs.find("result_out_less") != outputs.end()) {
     const auto& v = std::get<std::vector<double>>(outputs["result_out_less"]);
-    uint32_t len = bits * num_cnt * num_cnt;
     uint32_t tmp_cout = 0;
 
     vector<uint32_t> vec_one;
-    for (uint32_t i = 0; i < len; i++) {
-      // Take the first bit of the result
-      if (i % bits == 0) {
-        // Take the result modulo p   get the final matrix %p
-        uint32_t tmp_one = uint32_t(round(v[i])) % p;
-        vec_one.emplace_back(tmp_one);
-        tmp_cout++;
-        // cout << v[i] << " ";
-        if (tmp_cout == num_cnt) {
-          tmp_cout = 0;
-          matrix_result.emplace_back(std::move(vec_one));
-        }
+    for (auto value : v) {
+      // Take the result modulo p   get the final matrix %p
+      uint32_t tmp_one = uint32_t(round(value)) % p;
+      vec_one.emplace_back(tmp_one);
+      tmp_cout++;
+      if (tmp_cout == num_cnt) {
+        tmp_cout = 0;
+        matrix_result.emplace_back(std::move(vec_one));
+        vec_one.clear();
       }
     }
 
@@ -378,36 +444,74 @@ void IYFC_SO_EXPORT setScale(DagPtr dag_ptr, uint32_t u_scale) {
   dag_ptr->m_scale = u_scale;
 }
 
-// void IYFC_SO_EXPORT setOutputRange(DagPtr dag_ptr, uint32_t u_rangle) {
-//   dag_ptr->configOutputRange(u_rangle);
-// }
+void IYFC_SO_EXPORT setOutputModSwitch(DagPtr dag_ptr, bool enable) {
+  dag_ptr->setOutputModSwitch(enable);
+}
+
+void IYFC_SO_EXPORT setOutputRange(DagPtr dag_ptr, const std::string& name,
+                                   uint32_t range) {
+  dag_ptr->setOutputRange(name, range);
+}
+
+void IYFC_SO_EXPORT setInputRange(DagPtr dag_ptr, const std::string& name,
+                                  uint32_t range) {
+  dag_ptr->setInputRange(name, range);
+}
+
+void IYFC_SO_EXPORT setTileSize(DagPtr dag_ptr, uint32_t tile_size) {
+  dag_ptr->setTileSize(tile_size);
+}
+
+void IYFC_SO_EXPORT setIncrementalExe(DagPtr dag_ptr, bool enable) {
+  dag_ptr->setIncrementalExe(enable);
+}
+
+size_t IYFC_SO_EXPORT getRecomputedCnt(DagPtr dag_ptr) {
+  return dag_ptr->getRecomputedCnt();
+}
+
+int IYFC_SO_EXPORT estimateNoise(DagPtr dag_ptr, NoiseReport& report,
+                                 uint32_t precision_bits) {
+  return dag_ptr->estimateNoise(precision_bits, report);
+}
+
+void IYFC_SO_EXPORT setNoiseCheck(DagPtr dag_ptr, bool enable) {
+  dag_ptr->setNoiseCheck(enable);
+}
+
+int IYFC_SO_EXPORT getNoiseMeasurements(
+    DagPtr dag_ptr, std::vector<NoiseMeasurement>& measurements) {
+  return dag_ptr->getNoiseMeasurements(measurements);
+}
+
+void IYFC_SO_EXPORT setRescaleStrategy(DagPtr dag_ptr,
+                                       RESCALE_STRATEGY strategy) {
+  dag_ptr->setRescaleStrategy(strategy);
+}
+
+void IYFC_SO_EXPORT getRescaleReport(DagPtr dag_ptr, RescaleReport& report) {
+  report = dag_ptr->getRescaleReport();
+}
+
+void IYFC_SO_EXPORT getRelinReport(DagPtr dag_ptr, RelinReport& report) {
+  report = dag_ptr->getRelinReport();
+}
 
 int IYFC_SO_EXPORT encodeOrgInputFFT(const std::vector<uint32_t>& vec_org,
                                      const std::string& input_name_real,
                                      const std::string& input_name_imag,
                                      Valuation& inputs) {
-  std::vector<double> vec_real;
-  std::vector<double> vec_imag;
-
-  FastFourierTransform fft_helper(FFT_N, FFTW_FORWARD);
-
-  for (const auto& item : vec_org) {
-    std::vector<int> vec_num;
-    getNumReVec(item, vec_num);
-    for (int i = 0; i < FFT_N; i++) {
-      fft_helper.m_in[i][0] = double(vec_num[i]);
-      fft_helper.m_in[i][1] = 0;
-    }
-    // fft
-    fft_helper.fft();
-    for (int i = 0; i < FFT_N; i++) {
-      vec_real.push_back(fft_helper.m_out[i][0]);
-      vec_imag.push_back(fft_helper.m_out[i][1]);
-    }
+  // fft over all records at once
+  std::vector<ComplexDouble> vec_spectrum;
+  batchFFTEncode(vec_org, FFT_N, vec_spectrum);
+
+  std::vector<double> vec_real(CMP_DAG_SIZE);
+  std::vector<double> vec_imag(CMP_DAG_SIZE);
+  size_t copy_cnt = std::min(vec_spectrum.size(), size_t(CMP_DAG_SIZE));
+  for (size_t i = 0; i < copy_cnt; i++) {
+    vec_real[i] = vec_spectrum[i].real();
+    vec_imag[i] = vec_spectrum[i].imag();
   }
-
-  vec_real.resize(CMP_DAG_SIZE);
-  vec_imag.resize(CMP_DAG_SIZE);
   inputs[input_name_real] = vec_real;
   inputs[input_name_imag] = vec_imag;
   return 0;
@@ -416,7 +520,9 @@ int IYFC_SO_EXPORT encodeOrgInputFFT(const std::vector<uint32_t>& vec_org,
 int IYFC_SO_EXPORT getCntOutput(DagPtr dag_ptr, const string& cnt_name,
                                 uint32_t& ul_result) {
   Valuation outputs;
-  dag_ptr->getDecryptOutput(outputs);
+  SlotSelection slots;
+  slots.count = 1;
+  dag_ptr->getPartialDecryptOutput({cnt_name}, slots, outputs);
 
   // Process the real part
   std::vector<double> vec_cnt;
@@ -430,7 +536,9 @@ int IYFC_SO_EXPORT getCntOutput(DagPtr dag_ptr, const string& cnt_name,
 int IYFC_SO_EXPORT getCntRandomOutput(DagPtr dag_ptr, const string& cnt_name,
                                       double& f_result) {
   Valuation outputs;
-  dag_ptr->getDecryptOutput(outputs);
+  SlotSelection slots;
+  slots.count = 1;
+  dag_ptr->getPartialDecryptOutput({cnt_name}, slots, outputs);
 
   // Process the real part
   std::vector<double> vec_cnt;
@@ -460,7 +568,11 @@ int IYFC_SO_EXPORT getFFTDoubleOutputs(DagPtr dag_ptr, uint32_t num_cnt,
                                        const string& output_imag_name,
                                        std::vector<double>& vec_results) {
   Valuation outputs;
-  dag_ptr->getDecryptOutput(outputs);
+  int total_cnt = num_cnt * FFT_N;
+  SlotSelection slots;
+  slots.count = total_cnt;
+  dag_ptr->getPartialDecryptOutput({output_real_name, output_imag_name}, slots,
+                                   outputs);
 
   // Process the real part
   std::vector<double> vec_real;
@@ -477,29 +589,18 @@ int IYFC_SO_EXPORT getFFTDoubleOutputs(DagPtr dag_ptr, uint32_t num_cnt,
   } else {
     throw std::logic_error("err real outputs");
   }
-  int total_cnt = num_cnt * FFT_N;
   if (vec_real.size() < total_cnt || vec_imag.size() < total_cnt) {
     throw std::logic_error("err complex outputs size");
   }
 
-  vec_real.resize(total_cnt);
-  vec_imag.resize(total_cnt);
+  std::vector<ComplexDouble> vec_spectrum(total_cnt);
+  for (int i = 0; i < total_cnt; i++) {
+    vec_spectrum[i] = ComplexDouble(vec_real[i], vec_imag[i]);
+  }
 
   // 32 bits represent one number
   // If the data is in the form [n,n,n....], performing ifft does not affect the final result - [n,0,0...]
-  FastFourierTransform fft_helper(FFT_N, FFTW_BACKWARD);
-  int cur_index = 0;
-  for (int i = 0; i < total_cnt; i++) {
-    fft_helper.m_in[cur_index][0] = vec_real[i];
-    fft_helper.m_in[cur_index][1] = vec_imag[i];
-    cur_index++;
-
-    if (cur_index == FFT_N) {
-      fft_helper.fft();
-      vec_results.emplace_back(getComplexNum(fft_helper.m_out, FFT_N));
-      cur_index = 0;
-    }
-  }
+  batchFFTDecode(vec_spectrum, num_cnt, FFT_N, vec_results);
   return 0;
 }
 
@@ -517,6 +618,64 @@ int IYFC_SO_EXPORT getFFTSumOutputs(DagPtr dag_ptr, uint32_t num_cnt,
   return 0;
 }
 
+int IYFC_SO_EXPORT encodeOrgInputFFTComplex(const std::vector<uint32_t>& vec_org,
+                                            const std::string& input_name,
+                                            Valuation& inputs) {
+  std::vector<std::complex<double>> vec_spectrum;
+  batchFFTEncode(vec_org, FFT_N, vec_spectrum);
+
+  vec_spectrum.resize(CMP_DAG_SIZE);
+  inputs[input_name] = std::move(vec_spectrum);
+  return 0;
+}
+
+int IYFC_SO_EXPORT getFFTComplexOutputs(DagPtr dag_ptr, uint32_t num_cnt,
+                                        const std::string& output_name,
+                                        std::vector<uint32_t>& vec_results) {
+  Valuation outputs;
+  SlotSelection slots;
+  slots.count = num_cnt * FFT_N;
+  dag_ptr->getPartialDecryptOutput({output_name}, slots, outputs);
+
+  auto iter = outputs.find(output_name);
+  if (iter == outputs.end() ||
+      !std::holds_alternative<std::vector<std::complex<double>>>(
+          iter->second)) {
+    throw std::logic_error("err complex outputs");
+  }
+  const auto& vec_spectrum =
+      std::get<std::vector<std::complex<double>>>(iter->second);
+  std::vector<double> tmp_vec;
+  batchFFTDecode(vec_spectrum, num_cnt, FFT_N, tmp_vec);
+
+  std::for_each(tmp_vec.begin(), tmp_vec.end(),
+                [&](double tmp) { vec_results.emplace_back(std::round(tmp)); });
+  return 0;
+}
+
+int IYFC_SO_EXPORT getFFTComplexSumOutputs(DagPtr dag_ptr, uint32_t num_cnt,
+                                           const std::string& output_name,
+                                           uint32_t& sum_result) {
+  std::vector<uint32_t> vec_results;
+  THROW_ON_ERROR(
+      getFFTComplexOutputs(dag_ptr, num_cnt, output_name, vec_results),
+      "getFFTComplexSumOutputs");
+
+  if (vec_results.size() > 0) sum_result = vec_results[0];
+
+  return 0;
+}
+
+void IYFC_SO_EXPORT setFFTWisdomFile(const std::string& path) {
+  FFTPlanCache::getInstance().setWisdomFile(path);
+}
+
+void IYFC_SO_EXPORT releaseFFTPlans() { FFTPlanCache::getInstance().clear(); }
+
+void IYFC_SO_EXPORT setThreadNum(uint32_t thread_num) {
+  setWorkerThreadNum(thread_num);
+}
+
 bool IYFC_SO_EXPORT checkIsBootstrapping(DagPtr dag_ptr) {
   return dag_ptr->m_enable_bootstrap;
 }
@@ -534,7 +693,7 @@ int IYFC_SO_EXPORT deserializeByType(DagPtr dag_ptr, SERIALIZE_DATA_TYPE type,
 }
 
 uint32_t IYFC_SO_EXPORT getVecSize(DagPtr dag_ptr) {
-  return dag_ptr->getVecSize();
+  return dag_ptr->getLogicalVecSize();
 }
 
 void IYFC_SO_EXPORT setCmpNumSize(DagPtr dag_ptr, uint32_t num_cnt) {
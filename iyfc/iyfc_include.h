@@ -76,6 +76,20 @@ void addDag(DagPtr group, DagPtr child);
  */
 Expr setInputName(DagPtr dag_ptr, const std::string& name);
 
+/**
+ * @brief      Set the name of an input node holding complex slots.
+ * @details    The input takes a std::vector<std::complex<double>> value, both
+ *  parts are packed into the same CKKS slots so one ciphertext replaces a
+ *  real/imaginary pair. Outputs depending on it are decrypted as complex
+ *  vectors. Only supported by seal ckks.
+ *
+ * @param[in]  dag_ptr The target Dag where the input name is to be set.
+ * @param[in]  name    Custom input node name.
+ *
+ * @return     Expr    Expression object.
+ */
+Expr setComplexInputName(DagPtr dag_ptr, const std::string& name);
+
 /*
             Step 3: Build your own expressions
             e1: Support real number vectors + - *
@@ -138,18 +152,84 @@ int genKeys(DagPtr dag_ptr);
  */
 int encryptInput(DagPtr dag_ptr, const Valuation& inputs, bool replace = false);
 
+/**
+ * @brief      Encrypt inputs straight from caller-owned memory.
+ * @details    Same as encryptInput without building a Valuation: each span
+ *  (vec_size values, or one value for every slot) is converted to the scheme
+ *  element type while it is encoded. SEAL reads the spans directly, the other
+ *  libraries copy them first.
+ *
+ * @param[in]  dag_ptr  The target DagPtr.
+ * @param[in]  inputs   Input name to data pointer and length.
+ * @param[in]  replace  Whether to replace the input data.
+ *
+ * @return     int  Error code.
+ */
+int encryptInputSpans(DagPtr dag_ptr, const InputSpans& inputs,
+                      bool replace = false);
+
+/**
+ * @brief      Select public-key or symmetric encryption of cipher inputs.
+ * @details    For clients that hold the secret key. With SEAL the symmetric
+ *  ciphertexts are serialized seeded by savaInputTostr, about half the size,
+ *  and expanded by loadInputFromStr. OpenFHE encrypts with the secret key but
+ *  keeps the full ciphertext size.
+ *
+ * @param[in]  dag_ptr  The target DagPtr.
+ * @param[in]  mode     PUBLIC_KEY_MODE (default) or SYMMETRIC_MODE.
+ *
+ * @return     int  Error code.
+ */
+int setEncryptMode(DagPtr dag_ptr, ENCRYPT_MODE mode);
+
+/**
+ * @brief      Configure offline/online encryption (SEAL only).
+ * @details    Public-key encryptions of zero are precomputed for the levels of
+ *  the cipher inputs, encryptInput then only encodes and adds. Call after
+ *  genKeys or after loading the public context. A size_per_level of 0 stops
+ *  the pool and saves the remaining entries to persist_path if set.
+ *
+ * @param[in]  dag_ptr  The target DagPtr.
+ * @param[in]  config   Pool size, refill thread and persistence options.
+ *
+ * @return     int  Error code.
+ */
+int setEncryptPool(DagPtr dag_ptr, const EncryptPoolConfig& config);
+
+/**
+ * @brief      Get hit/miss/generated counters of the encryption pool.
+ *
+ * @param[in]  dag_ptr  The target DagPtr.
+ * @param[out] metrics  Pool metrics.
+ *
+ * @return     int  Error code.
+ */
+int getEncryptPoolMetrics(DagPtr dag_ptr, EncryptPoolMetrics& metrics);
+
 /**
  * @brief      Step 8: Execute Computation.
  * @details    With the presence of the public_ctx node, it is possible to execute computational logic and generate ciphertext results.
  * In the concrete implementation, this capability is specific to the server with the public_ctx.
  * @param[in]  dag_ptr     The target Dag, for which computation needs to be executed.
- * @param[in]  set_inputs  Optional parameter. If provided, it indicates that only the program logic associated with the input set should be executed.
+ * @param[in]  set_inputs  Optional parameter. With setIncrementalExe, only the program logic associated with the input set is executed again; without it the set is ignored. Empty to detect the changed inputs from the encryptions.
  *
  * @return     int  Error code.
  */
 int exeDag(DagPtr dag_ptr,
            const std::unordered_set<std::string>& set_inputs = {});
 
+/**
+ * @brief      Execute only what the given outputs depend on.
+ * @details    Nodes outside the backward cone of the outputs are skipped, e.g.
+ *  the comparison polynomial of an unused output. Cones are cached per
+ *  output subset. Only the given outputs can be decrypted afterwards.
+ * @param[in]  dag_ptr       The target Dag.
+ * @param[in]  output_names  Outputs to compute.
+ *
+ * @return     int  Error code.
+ */
+int exeDagOutputs(DagPtr dag_ptr, const std::vector<std::string>& output_names);
+
 /**
  * @brief      Step 9: Decrypt Output.
  * @details    With the presence of the secret_ctx node, it is possible to execute decryption logic and generate plaintext results.
@@ -161,6 +241,39 @@ int exeDag(DagPtr dag_ptr,
  */
 int decryptOutput(DagPtr dag_ptr, Valuation& outputs);
 
+/**
+ * @brief      Decrypt only some outputs and keep only some of their slots.
+ * @details    Outputs not named are not decrypted. Each decrypted vector
+ *  holds the selected slots only, in order. SEAL BFV evaluates just those
+ *  slots when there are few of them instead of decoding the whole vector.
+ *
+ * @param[in]  dag_ptr   The target Dag.
+ * @param[in]  names     Names of the outputs to decrypt.
+ * @param[out] outputs   The decrypted plaintext results.
+ * @param[in]  slots     Slots to keep (default: all).
+ *
+ * @return     int  Error code.
+ */
+int decryptPartialOutput(DagPtr dag_ptr, const std::vector<std::string>& names,
+                         Valuation& outputs,
+                         const SlotSelection& slots = SlotSelection());
+
+/**
+ * @brief      Decrypt outputs into caller-owned buffers.
+ * @details    Only the outputs with a buffer are decrypted. At most capacity
+ *  selected slots are written, converted to the buffer element type (CKKS
+ *  values are rounded when written to int64 buffers), and size is set to the
+ *  number written.
+ *
+ * @param[in]  dag_ptr   The target Dag.
+ * @param[in,out] outputs  Output name to buffer.
+ * @param[in]  slots     Slots to write (default: all).
+ *
+ * @return     int  Error code.
+ */
+int decryptOutputTo(DagPtr dag_ptr, OutputBuffers& outputs,
+                    const SlotSelection& slots = SlotSelection());
+
 /**
  * @brief      Step 10: Release Dag.
  * @details    Call the delete function to destruct and release the Dag.
@@ -320,6 +433,22 @@ int loadOutputFromStr(DagPtr dag_ptr, const std::string& str_output);
 int encodeOrgInputforCmp(const std::vector<uint32_t>& vec_org,
                          const std::string& input_name, Valuation& inputs);
 
+/**
+ * @brief      Preprocesses any number of rows for comparison into ciphertext-sized tiles.
+ * @details    Every tile holds MAX_CMP_NUM rows in CMP_DAG_SIZE slots, tile t is
+ *  stored as input "<input_name>_<t>". Digits are written straight into the
+ *  tiles by the multithreaded bulk encoder.
+ *
+ * @param[in]  vec_org           The original data as a vector of unsigned integers.
+ * @param[in]  input_name        The name prefix of the tiles.
+ * @param[out] inputs            A Valuation reference to store the tiles.
+ *
+ * @return     uint32_t          Number of tiles.
+ */
+uint32_t encodeOrgInputforCmpTiles(const std::vector<uint32_t>& vec_org,
+                                   const std::string& input_name,
+                                   Valuation& inputs);
+
 /**
  * @brief      Retrieves the comparison results from a DAG.
  *
@@ -405,7 +534,148 @@ int getSortOutputs(DagPtr dag_ptr, uint32_t num_cnt,
  */
 void setScale(DagPtr dag_ptr, uint32_t u_scale);
 
-// void setOutputRange(DagPtr dag_ptr, uint32_t u_rangle);
+/**
+ * @brief      Mod-switch outputs to their lowest level before serialization.
+ * @details    Call before compiling. Each CKKS output keeps only the primes
+ *  its scale and output range need, which shrinks the serialized results and
+ *  the decryption work of the client. BFV outputs are left unchanged.
+ *
+ * @param[in]   dag_ptr               The target DagPtr.
+ * @param[in]   enable                Whether to drop the spare primes.
+ */
+void setOutputModSwitch(DagPtr dag_ptr, bool enable);
+
+/**
+ * @brief      Declare the range in bits of one output (default: the scale).
+ * @details    With setOutputModSwitch, an output with a smaller range is
+ *  switched down further before serialization.
+ *
+ * @param[in]   dag_ptr               The target DagPtr.
+ * @param[in]   name                  Output name.
+ * @param[in]   range                 Range of the output values in bits.
+ */
+void setOutputRange(DagPtr dag_ptr, const std::string& name, uint32_t range);
+
+/**
+ * @brief      Declare the range in bits of one input, call after
+ *  setInputName.
+ * @details    |value| < 2^range for every slot. When all inputs of a BFV DAG
+ *  are declared, the plaintext modulus is sized to the outputs instead of
+ *  the default 20 bits, which often allows a smaller polynomial degree.
+ *  Values outside the range wrap around.
+ *
+ * @param[in]   dag_ptr               The target DagPtr.
+ * @param[in]   name                  Input name.
+ * @param[in]   range                 Range of the input values in bits.
+ */
+void setInputRange(DagPtr dag_ptr, const std::string& name, uint32_t range);
+
+/**
+ * @brief      Set the tile size of long vectors, call before compileDag.
+ * @details    A DAG whose vec_size is larger than tile_size (default
+ *  MAX_TILE_SIZE) is split into vec_size / tile_size ciphertexts per value.
+ *  Slot-wise operations run per tile, rotations combine two tiles with
+ *  masks (one extra plaintext multiplication) and full slot sums are reduced
+ *  within and then across tiles. Inputs and outputs keep their whole length
+ *  in encryptInput and decryptOutput.
+ *
+ * @param[in]   dag_ptr               The target DagPtr.
+ * @param[in]   tile_size             Power of two, 0 disables tiling.
+ */
+void setTileSize(DagPtr dag_ptr, uint32_t tile_size);
+
+/**
+ * @brief      Re-execute only what depends on changed inputs.
+ * @details    The executor keeps every intermediate ciphertext of the last
+ *  exeDag. The next exeDag reloads the inputs encrypted or loaded since then
+ *  (encryptInput, encryptInputSpans, loadInputFromStr) and recomputes only
+ *  the nodes downstream of them, or of the set_inputs given to exeDag. Costs
+ *  the memory of all intermediate values. On a DagGroup it applies to the
+ *  children too.
+ *
+ * @param[in]   dag_ptr               The target DagPtr.
+ * @param[in]   enable                Keep values between executions.
+ */
+void setIncrementalExe(DagPtr dag_ptr, bool enable);
+
+/**
+ * @brief      Get the number of nodes the last incremental exeDag recomputed.
+ * @details    Changed inputs included, every node of the DAG after a full
+ *  run. 0 before the first incremental execution.
+ *
+ * @param[in]   dag_ptr               The target DagPtr.
+ */
+size_t getRecomputedCnt(DagPtr dag_ptr);
+
+/**
+ * @brief      Estimate the noise and precision of a compiled DAG statically.
+ *
+ *  CKKS bounds the error of every output and recommends the smallest scale
+ *  per input and output meeting precision_bits, BFV estimates the noise
+ *  budget left and recommends the plaintext modulus. Both report the data
+ *  primes of the chain and the primes the outputs need. SEAL only.
+ *
+ * @param[in]   dag_ptr               The compiled DagPtr.
+ * @param[out]  report                Estimates and recommendations.
+ * @param[in]   precision_bits        CKKS output precision in bits.
+ * @return     int  Error code.
+ */
+int estimateNoise(DagPtr dag_ptr, NoiseReport& report,
+                  uint32_t precision_bits = DEFAULT_CKKS_PRECISION_BITS);
+
+/**
+ * @brief      Measure the noise of every ciphertext during exeDag.
+ *
+ *  Runtime verification of estimateNoise on a debug key: each node is
+ *  decrypted with the secret key, BFV reports its invariant noise budget
+ *  and CKKS the error found in the imaginary part of its slots. Costs a
+ *  decryption per node, needs the secret key. SEAL only.
+ *
+ * @param[in]   dag_ptr               The target DagPtr.
+ * @param[in]   enable                Measure the next executions.
+ */
+void setNoiseCheck(DagPtr dag_ptr, bool enable);
+
+/**
+ * @brief      Get the noise measured by the last exeDag, see setNoiseCheck.
+ *
+ * @param[in]   dag_ptr               The target DagPtr.
+ * @param[out]  measurements          Measured and estimated bits per node.
+ * @return     int  Error code.
+ */
+int getNoiseMeasurements(DagPtr dag_ptr,
+                         std::vector<NoiseMeasurement>& measurements);
+
+/**
+ * @brief      Select where seal ckks inserts rescales.
+ *
+ *  EAGER_RESCALE rescales each product as soon as it passes the waterline,
+ *  LAZY_RESCALE defers the rescale past additions and rotations to the next
+ *  product or output, so a sum of products pays one rescale. AUTO_RESCALE
+ *  (default) predicts the cost of both at compile time and takes the lower.
+ *
+ * @param[in]   dag_ptr               The target DagPtr.
+ * @param[in]   strategy              Rescale strategy of the next compile.
+ */
+void setRescaleStrategy(DagPtr dag_ptr, RESCALE_STRATEGY strategy);
+
+/**
+ * @brief      Get the rescale placement of the last seal ckks compile.
+ *
+ * @param[in]   dag_ptr               The target DagPtr.
+ * @param[out]  report                Strategy, rescales, chain length and
+ *                                    predicted costs.
+ */
+void getRescaleReport(DagPtr dag_ptr, RescaleReport& report);
+
+/**
+ * @brief      Get the relinearization placement of the last seal compile.
+ *
+ * @param[in]   dag_ptr               The target DagPtr.
+ * @param[out]  report                Relinearizations inserted and the
+ *                                    number the greedy placement needs.
+ */
+void getRelinReport(DagPtr dag_ptr, RelinReport& report);
 
 /**
  * @brief      Retrieve the result of a specified counter output in the sorting DAG.
@@ -492,6 +762,77 @@ int getFFTSumOutputs(DagPtr dag_ptr, uint32_t num_cnt,
                      const std::string& output_real_name,
                      const std::string& output_imag_name, uint32_t& sum_result);
 
+/**
+ * @brief      Preprocesses data using FFT into a single complex input.
+ * @details    Same as encodeOrgInputFFT, but the spectrum is kept complex for
+ *  an input set by setComplexInputName. QuerySum/QueryRow then run once
+ *  instead of once per part.
+ *
+ * @param[in]   vec_org               The original data.
+ * @param[in]   input_name            Complex input name.
+ * @param[out]  inputs                Valuation containing the complex spectrum.
+ *
+ * @return     int                    Error code.
+ */
+int encodeOrgInputFFTComplex(const std::vector<uint32_t>& vec_org,
+                             const std::string& input_name, Valuation& inputs);
+
+/**
+ * @brief      Retrieve the output results of a complex FFT output.
+ *
+ * @param[in]   dag_ptr              The DAG from which to retrieve the FFT results.
+ * @param[in]   num_cnt              The total amount of data.
+ * @param[in]   output_name          The name of the complex FFT output.
+ * @param[out]  vec_results          The vector storing the rounded results.
+ *
+ * @return     int                   Error code.
+ */
+int getFFTComplexOutputs(DagPtr dag_ptr, uint32_t num_cnt,
+                         const std::string& output_name,
+                         std::vector<uint32_t>& vec_results);
+
+/**
+ * @brief      Retrieve the sum of a complex FFT output computed by QuerySum.
+ *
+ * @param[in]  dag_ptr                The DAG from which to retrieve the FFT results.
+ * @param[in]  num_cnt                The total amount of data.
+ * @param[in]  output_name            The name of the complex FFT output.
+ * @param[out] sum_result             The variable to store the sum.
+ *
+ * @return     int                    Error code.
+ */
+int getFFTComplexSumOutputs(DagPtr dag_ptr, uint32_t num_cnt,
+                            const std::string& output_name,
+                            uint32_t& sum_result);
+
+/**
+ * @brief      Set the file used to persist FFTW wisdom for the FFT encoders.
+ * @details    Plans are cached for the whole process, the wisdom file lets
+ *  later processes skip FFTW_MEASURE planning. Defaults to the
+ *  IYFC_FFTW_WISDOM environment variable, empty disables persistence.
+ *
+ * @param[in]   path                  Wisdom file path.
+ */
+void setFFTWisdomFile(const std::string& path);
+
+/**
+ * @brief      Release the cached FFT plans and FFTW's global state.
+ * @details    Plans are rebuilt by the next FFT encode or decode. Call only
+ *  while no FFT encode or decode runs, e.g. before unloading the library or
+ *  to reclaim memory after a batch of queries.
+ */
+void releaseFFTPlans();
+
+/**
+ * @brief      Set the number of threads used to encrypt and decrypt.
+ * @details    Inputs and outputs of one valuation (including the tiles of a
+ *  long input) are encoded and encrypted concurrently on SEAL, OpenFHE and
+ *  Concrete. 0 uses the OpenMP default, 1 runs serially.
+ *
+ * @param[in]   thread_num            Number of threads.
+ */
+void setThreadNum(uint32_t thread_num);
+
 /**
  * @brief       Check if the computation logic includes bootstrapping.
  *              If bootstrapping is included, separate serialization of bootstrapping keys is required.
@@ -536,6 +877,8 @@ void setAvgGroup(DagPtr group, const Expr expr);
 
 /**
  * @brief      Retrieve the slot size of the DAG.
+ * @details    For a tiled DAG this is the whole vector length, not the tile
+ *  size.
  *
  * @param[in]  dag_ptr       The DAG for which to retrieve the slot size.
  *
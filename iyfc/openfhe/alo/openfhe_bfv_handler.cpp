@@ -36,11 +36,12 @@ void OpenFheBfvHandler::transform(Dag &dag, NodeMap<DataType> &types,
                                   NodeMapOptional<std::uint32_t> &scales) {
   auto dag_rewrite = DagTraversal(dag);
 
-  dag_rewrite.forwardPass(TypeHandler(dag, types));
+  TypeInference inference(dag, types);
+  inference.update();
   dag_rewrite.forwardPass(ConstantInt64Handler(dag, scales));
-  dag_rewrite.forwardPass(TypeHandler(dag, types));
+  inference.update();
   dag_rewrite.forwardPass(PlaintextInserter(dag, types, scales));
-  dag_rewrite.forwardPass(TypeHandler(dag, types));
+  inference.update();
 }
 
 void OpenFheBfvHandler::extractSignature(const Dag &dag) {
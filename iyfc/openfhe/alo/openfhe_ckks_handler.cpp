@@ -34,17 +34,19 @@ int OpenFheCkksHandler::dagTranspile(Dag &input_dag) {
 
 void OpenFheCkksHandler::transform(Dag &dag, NodeMap<DataType> &types,
                                    NodeMapOptional<std::uint32_t> &scales) {
+  PassScope scope(dag, "OpenFheCkksHandler::transform");
   auto dag_rewrite = DagTraversal(dag);
   // Deduce types
-  dag_rewrite.forwardPass(TypeHandler(dag, types));
+  TypeInference inference(dag, types);
+  inference.update();
 
   // Pre-calculate constant data nodes
   dag_rewrite.forwardPass(ConstantDoubleHandler(dag, scales));
   // Add encode nodes
-  dag_rewrite.forwardPass(TypeHandler(dag, types));
+  inference.update();
   dag_rewrite.forwardPass(PlaintextInserter(dag, types, scales));
   // Deduce types
-  dag_rewrite.forwardPass(TypeHandler(dag, types));
+  inference.update();
 
 }
 
@@ -32,6 +32,7 @@
 #include "dag/constant_value.h"
 #include "dag/iyfc_dag.h"
 #include "dag/node_map.h"
+#include "daghandler/incremental_handler.h"
 #include "err_code.h"
 #include "openfhe.h"
 #include "openfhe_valuation.h"
@@ -78,6 +79,8 @@ class OpenfheExecutor {
 
   NodeMapOptional<RuntimeValue> m_objects;
   bool m_has_err{false};
+  // Set when values are kept between runs, see enableIncremental
+  std::unique_ptr<IncrementalExe> m_incremental;
   uint32_t m_final_depth;  // Multiplication depth
   std::vector<T> temp_vec;
 
@@ -357,6 +360,21 @@ class OpenfheExecutor {
 
   bool IsErr() { return m_has_err; }
 
+  /**
+   * @brief Keep every value after a run so that the next run only recomputes
+   * the nodes downstream of changed inputs
+   */
+  void enableIncremental() {
+    m_incremental = std::make_unique<IncrementalExe>();
+  }
+
+  /**
+   * @brief Whether setInputs has to load the input for this run
+   */
+  bool needInput(const std::string &name) const {
+    return !m_incremental || m_incremental->isInputDirty(name);
+  }
+
   /**
    * @brief encodeRaw need to be encoded first
    */
@@ -405,6 +423,12 @@ class OpenfheExecutor {
     if (m_has_err) {
       throw std::logic_error("exe err");
     }
+    // Outside the requested outputs, or value of the previous run still valid
+    bool in_cone = dag.inExeCone(*node);
+    if (m_incremental ? !m_incremental->needCompute(*node, in_cone)
+                      : !in_cone) {
+      return;
+    }
 
     if (node->m_op_type == OpType::Input) return;
     auto args = node->getOperands();
@@ -545,6 +569,7 @@ class OpenfheExecutor {
 
   void getOutputs(OpenFheValuation &enc_outputs) {
     for (auto &out : dag.getOutputs()) {
+      if (!dag.inExeCone(*out.second)) continue;
       std::visit(Overloaded{[&](const OpenFheCiphertext &output) {
                               enc_outputs[out.first] = output;
                             },
@@ -580,6 +605,7 @@ class CkksOpenFheExecutor : public OpenfheExecutor<double> {
 
   virtual void setInputs(const OpenFheValuation &inputs) {
     for (auto &in : inputs) {
+      if (!needInput(in.first)) continue;
       auto node = dag.getInput(in.first);
       std::visit(
           Overloaded{
@@ -624,6 +650,7 @@ class BfvOpenfheExecutor : public OpenfheExecutor<int64_t> {
 
   virtual void setInputs(const OpenFheValuation &inputs) {
     for (auto &in : inputs) {
+      if (!needInput(in.first)) continue;
       auto node = dag.getInput(in.first);
       std::visit(
           Overloaded{
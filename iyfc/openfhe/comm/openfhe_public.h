@@ -21,12 +21,20 @@
  * SOFTWARE.
  */
 #pragma once
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <unordered_map>
+
 #include "comm_include.h"
+#include "daghandler/ckks_rotation_keys_handler.h"
+#include "daghandler/incremental_handler.h"
 #include "daghandler/traversal_handler.h"
 #include "openfhe.h"
 #include "openfhe/alo/openfhe_signature.h"
 #include "openfhe_util.h"
 #include "openfhe_valuation.h"
+#include "util/thread_util.h"
 
 using namespace lbcrypto;
 using namespace std;
@@ -56,66 +64,29 @@ class OpenFhePublic {
   OpenFheValuation encrypt(const Valuation &variant_inputs,
                            const OpenFheSignature &signature) {
     OpenFheValuation inputs;
-
-    for (auto &in : variant_inputs) {
-      auto name = in.first;  // Input name
-      std::vector<T> v;
-      if (std::holds_alternative<std::vector<T>>(in.second)) {
-        v = get<std::vector<T>>(in.second);
-      } else if (std::holds_alternative<double>(in.second)) {
-        v.insert(v.end(), signature.batch_size, T(get<double>(in.second)));
-      } else if (std::holds_alternative<int64_t>(in.second)) {
-        v.insert(v.end(), signature.batch_size, T(get<int64_t>(in.second)));
-      }
-
-      auto v_size = v.size();
-      // TODO remove this check
-      if (v_size != signature.batch_size) {
-        v.resize(signature.batch_size);
-        LOG(LOGLEVEL::Info,
-            "Input size does not match dag vector size, resize");
-      }
-      auto info = signature.inputs.at(name);
-
-      if (info.input_type == DataType::Cipher ||
-          info.input_type == DataType::Plain) {
-        // MakePackedPlaintext
-        uint32_t level = 0;
-        if (m_use_bootstrapping) {
-          // level = m_final_depth - 15;
-          // LOG(LOGLEVEL::Info, "Input  MakePlaintext level %u", level);
-        }
-        // TODO: Confirm whether it needs to be moved to the specified level in advance
-        OpenFhePlaintext plain = MakePlaintext(m_context, v, level);
-
-        /*
-        if (std::is_same<typename std::decay<T>::type, double>::value) {
-          plain = m_context->MakeCKKSPackedPlaintext(v);
-        } else if (std::is_same<typename std::decay<T>::type,
-                                int64_t>::value) {
-          plain = m_context->MakePackedPlaintext(v);
-        } else {
-          throw std::logic_error("Unsupported input data type");
-        }
-
-        */
-
-        if (info.input_type == DataType::Cipher) {
-          OpenFheCiphertext cipher = m_context->Encrypt(m_public_key, plain);
-          inputs[name] = move(cipher);
-
-        } else if (info.input_type == DataType::Plain) {
-          inputs[name] = move(plain);
-        }
-      } else {
-        inputs[name] = std::shared_ptr<ConstantValue<T>>(
-            new DenseConstantValue<T>(signature.batch_size, v));
-      }
+    // Inputs are independent, encrypt them concurrently and insert serially
+    std::vector<const Valuation::value_type *> items;
+    for (auto &in : variant_inputs) items.push_back(&in);
+    std::vector<OpenFheSchemeValue> values(items.size());
+    parallelFor(items.size(), [&](size_t idx, size_t) {
+      values[idx] =
+          encryptOne<T>(items[idx]->first, items[idx]->second, signature);
+    });
+    for (size_t i = 0; i < items.size(); ++i) {
+      inputs[items[i]->first] = std::move(values[i]);
     }
 
     return inputs;
   }
 
+  /**
+   * @brief Encrypt with the secret key instead of the public key.
+   * @param [in] sk Secret key, empty for public-key encryption.
+   * @details OpenFHE has no seeded ciphertext serialization, so this only
+   * saves the public-key encryption work, not upload size.
+   */
+  void setSymmetricKey(const OpenFhePrivateKey &sk) { m_symmetric_key = sk; }
+
   /**
    * @brief Execution function for OpenFhe.
    * @param [in] dag The computation DAG.
@@ -124,6 +95,7 @@ class OpenFhePublic {
    */
   template <typename T_EXE>
   OpenFheValuation execute(Dag &dag, const OpenFheValuation &inputs) {
+    auto keys_lock = lockKeys(dag);
     DagTraversal dag_traverse(dag);
 
     // Need to handle
@@ -139,12 +111,171 @@ class OpenFhePublic {
     return enc_outputs;
   }
 
+  /**
+   * @brief Execute reusing the values of the executor's previous run, only
+   * the nodes downstream of changed inputs are recomputed.
+   * @param [in] dag The DAG to be executed.
+   * @param [in] inputs Encrypted inputs.
+   * @param [in] versions Encryption versions of the inputs.
+   * @param [in,out] executor Executor of the previous run, created when null
+   * and dropped after an error.
+   * @return OpenFheValuation containing the encrypted results of the execution.
+   */
+  template <typename T_EXE>
+  OpenFheValuation executeIncremental(Dag &dag, const OpenFheValuation &inputs,
+                                      const InputVersions &versions,
+                                      std::unique_ptr<T_EXE> &executor) {
+    auto keys_lock = lockKeys(dag);
+    if (executor == nullptr) {
+      executor = std::make_unique<T_EXE>(dag, m_context, m_final_depth);
+      executor->enableIncremental();
+    }
+    executor->m_incremental->beginRun(dag, versions, dag.getExeInputs());
+    executor->setInputs(inputs);
+
+    OpenFheValuation enc_outputs;
+    DagTraversal dag_traverse(dag);
+    try {
+      dag_traverse.forwardPass(*executor);
+    } catch (...) {
+      // Values of a partial run cannot be reused
+      executor.reset();
+      throw;
+    }
+    if (executor->IsErr()) {
+      executor.reset();
+      return enc_outputs;
+    }
+    executor->m_incremental->endRun();
+    dag.setRecomputedCnt(executor->m_incremental->recomputedCnt());
+    LOG(LOGLEVEL::Debug, "incremental execute recomputed %zu nodes",
+        dag.getRecomputedCnt());
+    executor->getOutputs(enc_outputs);
+    return enc_outputs;
+  }
+
+  /**
+   * @brief Drop the spare RNS towers of cipher outputs before serialization.
+   * @param [in,out] outputs Execution results.
+   * @param [in] towers Output name to the number of towers to keep.
+   */
+  void compressOutputs(
+      OpenFheValuation &outputs,
+      const std::unordered_map<std::string, uint32_t> &towers) {
+    for (auto &item : outputs) {
+      auto it = towers.find(item.first);
+      if (it == towers.end()) continue;
+      auto *cipher = std::get_if<OpenFheCiphertext>(&item.second);
+      if (cipher == nullptr) continue;
+      if ((*cipher)->GetElements()[0].GetNumOfElements() > it->second) {
+        *cipher = m_context->Compress(*cipher, it->second);
+      }
+    }
+  }
+
   void setUseBootstrapping(bool use_boot) { m_use_bootstrapping = use_boot; }
+
+  /**
+   * @brief Keep serialized rotation keys until a DAG with rotations runs
+   * @details Not to be called while executes run.
+   */
+  void setPendingRotationKeys(std::string data) {
+    std::unique_lock<std::shared_mutex> lock(m_keys_mutex);
+    m_pending_rotation_keys = std::move(data);
+  }
+
+  /**
+   * @brief Load the pending rotation keys into the context, waits for the
+   * running executes and blocks new ones
+   */
+  void loadPendingRotationKeys() {
+    std::unique_lock<std::shared_mutex> lock(m_keys_mutex);
+    // Another execute may have loaded them while this one waited
+    if (m_pending_rotation_keys.empty()) return;
+    std::stringstream ss_rot;
+    ss_rot.str(m_pending_rotation_keys);
+    if (!m_context->DeserializeEvalAutomorphismKey(ss_rot, SerType::BINARY)) {
+      throw std::logic_error("Error DeserializeEvalAutomorphismKey");
+    }
+    m_pending_rotation_keys.clear();
+  }
+
+  /**
+   * @brief Load the rotation keys the dag needs and hold the keys for
+   * reading
+   * @return Shared lock, no load changes the keys until it is released
+   */
+  std::shared_lock<std::shared_mutex> lockKeys(Dag &dag) {
+    std::shared_lock<std::shared_mutex> lock(m_keys_mutex);
+    if (!m_pending_rotation_keys.empty() &&
+        !collectRotationSteps(dag).empty()) {
+      lock.unlock();
+      loadPendingRotationKeys();
+      lock.lock();
+    }
+    return lock;
+  }
+
   void setFinalDepth(uint32_t depth) { m_final_depth = depth; }
 
  private:
+  /**
+   * @brief Encrypt one input, safe to call concurrently.
+   */
+  template <typename T>
+  OpenFheSchemeValue encryptOne(const std::string &name,
+                                const ValuationType &value,
+                                const OpenFheSignature &signature) {
+    std::vector<T> v;
+    if (std::holds_alternative<std::vector<T>>(value)) {
+      v = get<std::vector<T>>(value);
+    } else if (std::holds_alternative<double>(value)) {
+      v.insert(v.end(), signature.batch_size, T(get<double>(value)));
+    } else if (std::holds_alternative<int64_t>(value)) {
+      v.insert(v.end(), signature.batch_size, T(get<int64_t>(value)));
+    } else if (std::holds_alternative<std::vector<std::complex<double>>>(
+                   value)) {
+      throw std::logic_error("complex input " + name + " needs seal_ckks");
+    }
+
+    auto v_size = v.size();
+    // TODO remove this check
+    if (v_size != signature.batch_size) {
+      v.resize(signature.batch_size);
+      LOG(LOGLEVEL::Info, "Input size does not match dag vector size, resize");
+    }
+    auto info = signature.inputs.at(name);
+
+    if (info.input_type != DataType::Cipher &&
+        info.input_type != DataType::Plain) {
+      return std::shared_ptr<ConstantValue<T>>(
+          new DenseConstantValue<T>(signature.batch_size, v));
+    }
+    // MakePackedPlaintext
+    uint32_t level = 0;
+    if (m_use_bootstrapping) {
+      // level = m_final_depth - 15;
+      // LOG(LOGLEVEL::Info, "Input  MakePlaintext level %u", level);
+    }
+    // TODO: Confirm whether it needs to be moved to the specified level in
+    // advance
+    OpenFhePlaintext plain = MakePlaintext(m_context, v, level);
+    if (info.input_type == DataType::Cipher) {
+      if (m_symmetric_key) {
+        return m_context->Encrypt(m_symmetric_key, plain);
+      }
+      return m_context->Encrypt(m_public_key, plain);
+    }
+    return plain;
+  }
+
   OpenFheContext m_context;
   OpenFhePublickKey m_public_key;
+  OpenFhePrivateKey m_symmetric_key;
+  // Serialized automorphism keys not yet loaded into the context
+  std::string m_pending_rotation_keys;
+  // Executes read the keys under a shared lock, loading takes it alone
+  mutable std::shared_mutex m_keys_mutex;
   bool m_use_bootstrapping{false};
   uint32_t m_final_depth{0};  // Default is 0, use bootstrapping to encrypt to the specified level
 
@@ -21,11 +21,14 @@
  * SOFTWARE.
  */
 #pragma once
+#include <unordered_set>
+
 #include "comm_include.h"
 #include "openfhe.h"
 #include "openfhe/alo/openfhe_signature.h"
 #include "openfhe_valuation.h"
 #include "util/overloaded.h"
+#include "util/thread_util.h"
 
 using namespace lbcrypto;
 
@@ -55,44 +58,100 @@ class OpenFheSecret {
   Valuation decrypt(const OpenFheValuation &enc_outputs,
                     const OpenFheSignature &signature) {
     Valuation outputs;
+    // Outputs are independent, decrypt them concurrently and insert serially
+    std::vector<const std::pair<const std::string, OpenFheSchemeValue> *>
+        items;
+    for (auto &out : enc_outputs) items.push_back(&out);
+    std::vector<ValuationType> values(items.size());
+    parallelFor(items.size(), [&](size_t idx, size_t) {
+      values[idx] =
+          decryptOne<T>(items[idx]->first, items[idx]->second, signature);
+    });
+    for (size_t i = 0; i < items.size(); ++i) {
+      outputs[items[i]->first] = std::move(values[i]);
+    }
+    return outputs;
+  }
 
+  /**
+   * @brief Decrypt only some outputs and keep only some of their slots.
+   * @details OpenFHE decodes inside Decrypt, so only skipped outputs save
+   * work.
+   * @param [in] enc_outputs Encrypted output.
+   * @param [in] signature OpenFheSignature.
+   * @param [in] names Outputs to decrypt, others are skipped.
+   * @param [in] slots Slots to keep.
+   * @return Valuation Decrypted outputs holding the selected slots.
+   */
+  template <typename T>
+  Valuation decryptPartial(const OpenFheValuation &enc_outputs,
+                           const OpenFheSignature &signature,
+                           const std::vector<std::string> &names,
+                           const SlotSelection &slots) {
+    Valuation outputs;
+    std::unordered_set<std::string> wanted(names.begin(), names.end());
+    std::vector<const std::pair<const std::string, OpenFheSchemeValue> *>
+        items;
     for (auto &out : enc_outputs) {
-      auto name = out.first;
-      visit(Overloaded{[&](const OpenFheCiphertext &cipher) {
-                         OpenFhePlaintext plain;
-                         m_context->Decrypt(m_secret_key, cipher, &plain);
-                         // Decryption includes decoding logic
-                         // cout << "plain decrypt " << plain << endl;
-                         LOG(LOGLEVEL::Debug, "in decrypt cipher name %s",
-                             name.c_str());
-                         // bfv encoding
-                         if (plain->GetEncodingType() == PACKED_ENCODING)
-                           outputs[name] = plain->GetPackedValue();
-                         else  // ckks -encoding
-                           outputs[name] = plain->GetRealPackedValue();
-                       },
-                       [&](const OpenFhePlaintext &plain) {
-                         // todo
-                         outputs[name] = plain->GetRealPackedValue();
-                       },
-                       [&](const std::shared_ptr<ConstantValue<double>> &raw) {
-                         std::vector<double> temp_vec;
-                         outputs[name] =
-                             raw->expand(temp_vec, signature.batch_size);
-                       },
-                       [&](const std::shared_ptr<ConstantValue<int64_t>> &raw) {
-                         std::vector<int64_t> temp_vec;
-                         outputs[name] =
-                             raw->expand(temp_vec, signature.batch_size);
-                       }},
-            out.second);
-      auto &v = std::get<vector<T>>(outputs.at(name));
-      v.resize(signature.batch_size);
+      if (wanted.count(out.first)) items.push_back(&out);
+    }
+    auto indices = slots.indices(signature.batch_size);
+    std::vector<ValuationType> values(items.size());
+    parallelFor(items.size(), [&](size_t idx, size_t) {
+      values[idx] =
+          decryptOne<T>(items[idx]->first, items[idx]->second, signature);
+      pickSlots(values[idx], indices);
+    });
+    for (size_t i = 0; i < items.size(); ++i) {
+      outputs[items[i]->first] = std::move(values[i]);
     }
     return outputs;
   }
 
+  /**
+   * @brief Secret key, for clients encrypting in SYMMETRIC_MODE
+   */
+  const OpenFhePrivateKey &getSecretKey() const { return m_secret_key; }
+
  private:
+  /**
+   * @brief Decrypt one output, safe to call concurrently.
+   */
+  template <typename T>
+  ValuationType decryptOne(const std::string &name,
+                           const OpenFheSchemeValue &value,
+                           const OpenFheSignature &signature) {
+    ValuationType result;
+    visit(Overloaded{[&](const OpenFheCiphertext &cipher) {
+                       OpenFhePlaintext plain;
+                       m_context->Decrypt(m_secret_key, cipher, &plain);
+                       // Decryption includes decoding logic
+                       LOG(LOGLEVEL::Debug, "in decrypt cipher name %s",
+                           name.c_str());
+                       // bfv encoding
+                       if (plain->GetEncodingType() == PACKED_ENCODING)
+                         result = plain->GetPackedValue();
+                       else  // ckks -encoding
+                         result = plain->GetRealPackedValue();
+                     },
+                     [&](const OpenFhePlaintext &plain) {
+                       // todo
+                       result = plain->GetRealPackedValue();
+                     },
+                     [&](const std::shared_ptr<ConstantValue<double>> &raw) {
+                       std::vector<double> temp_vec;
+                       result = raw->expand(temp_vec, signature.batch_size);
+                     },
+                     [&](const std::shared_ptr<ConstantValue<int64_t>> &raw) {
+                       std::vector<int64_t> temp_vec;
+                       result = raw->expand(temp_vec, signature.batch_size);
+                     }},
+          value);
+    auto &v = std::get<vector<T>>(result);
+    v.resize(signature.batch_size);
+    return result;
+  }
+
   OpenFheContext m_context;
   OpenFhePrivateKey m_secret_key;
 
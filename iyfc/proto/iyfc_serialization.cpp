@@ -463,6 +463,11 @@ void dagCommInfoSerialize(const Dag &obj, msg::DagCommInfo *msg) {
   // boot
   msg->set_enable_bootstrap(obj.m_enable_bootstrap);
   msg->set_after_reduction_depth(obj.m_after_reduction_depth);
+  msg->set_output_mod_switch(obj.m_output_mod_switch);
+  msg->set_tile_cnt(obj.m_tile_cnt);
+  msg->set_logical_vec_size(obj.m_logical_vec_size);
+  for (auto &name : obj.m_tiled_inputs) msg->add_tiled_inputs(name);
+  for (auto &name : obj.m_tiled_outputs) msg->add_tiled_outputs(name);
 }
 
 void dagCommInfoDeSerialize(const msg::DagCommInfo &msg, Dag *obj) {
@@ -482,6 +487,13 @@ void dagCommInfoDeSerialize(const msg::DagCommInfo &msg, Dag *obj) {
   obj->m_enable_bootstrap = msg.enable_bootstrap();
   obj->m_after_reduction_depth = msg.after_reduction_depth();
   obj->m_scale = msg.scale();
+  obj->m_output_mod_switch = msg.output_mod_switch();
+  obj->m_tile_cnt = std::max(msg.tile_cnt(), 1u);
+  obj->m_logical_vec_size = msg.logical_vec_size();
+  obj->m_tiled_inputs.assign(msg.tiled_inputs().begin(),
+                             msg.tiled_inputs().end());
+  obj->m_tiled_outputs.assign(msg.tiled_outputs().begin(),
+                              msg.tiled_outputs().end());
 }
 
 unique_ptr<msg::Dag> serialize(const Dag &obj) {
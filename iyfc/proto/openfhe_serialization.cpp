@@ -183,7 +183,11 @@ unique_ptr<msg::OpenFhePublic> serialize(const OpenFhePublic &obj) {
   msg->set_final_depth(obj.m_final_depth);
   msg->set_use_bootstrapping(obj.m_use_bootstrapping);
   // rot_key  ,bootstrapping key Handle separately
-  if (!obj.m_use_bootstrapping) {
+  std::shared_lock<std::shared_mutex> keys_lock(obj.m_keys_mutex);
+  if (!obj.m_use_bootstrapping && !obj.m_pending_rotation_keys.empty()) {
+    // Never loaded here, pass the serialized keys on unchanged
+    msg->mutable_automorphism_key()->set_data(obj.m_pending_rotation_keys);
+  } else if (!obj.m_use_bootstrapping) {
     std::stringstream ss_rot;
     serializeAutomorphismKey(obj, ss_rot);
     msg->mutable_automorphism_key()->set_data(ss_rot.str());
@@ -205,15 +209,14 @@ unique_ptr<OpenFhePublic> deserialize(const msg::OpenFhePublic &msg) {
   ss_mult.str(msg.mult_key().data());
   cc->DeserializeEvalMultKey(ss_mult, SerType::BINARY);
 
+  auto ptr = std::make_unique<OpenFhePublic>(cc, pk);
   //  only rot_key, bootstrapping key Handle separately
   if (!msg.use_bootstrapping()) {
     if (msg.automorphism_key().data().size() != 0) {
-      std::stringstream ss_rot;
-      ss_rot.str(msg.automorphism_key().data());
-      cc->DeserializeEvalAutomorphismKey(ss_rot, SerType::BINARY);
+      // Loaded by the first execute of a DAG with rotations
+      ptr->setPendingRotationKeys(msg.automorphism_key().data());
     }
   }
-  auto ptr = std::make_unique<OpenFhePublic>(cc, pk);
   ptr->m_use_bootstrapping = msg.use_bootstrapping();
   ptr->m_final_depth = msg.final_depth();
   return ptr;
@@ -344,6 +347,7 @@ int OpenFheAdapterBase::deserializeInputInfo(const string &str_info,
   msg::OpenFheValuation tmp_info;
   if (tmp_info.ParseFromString(str_info)) {
     unique_ptr<OpenFheValuation> p_valuation = deserialize(tmp_info);
+    touchInputs(*p_valuation);
     if (replace)
       m_valution = std::move(p_valuation);
     else
@@ -432,7 +436,9 @@ int OpenFheAdapterBase::deserializeCommInfo(
     p_public = deserialize(tmp_info.openfhe_public());
   if (tmp_info.has_openfhe_secret())
     p_secret = deserialize(tmp_info.openfhe_secret());
-  // unique move
+  // unique move, cached executors belong to the old context
+  m_ckks_executors.clear();
+  m_bfv_executors.clear();
   m_openfhe_ctx = make_tuple(std::move(p_public), std::move(p_secret));
 
   if (tmp_info.has_sig()) {
@@ -150,6 +150,16 @@ unique_ptr<SEALValuation> deserialize(const msg::SEALValuation &msg) {
                                        entry.second);
         break;
       }
+      case FheObject::SEEDED_CIPHERTEXT: {
+        // load expands the seed into the full ciphertext
+        value = seal::Ciphertext();
+        get<seal::Ciphertext>(value).load(
+            context,
+            reinterpret_cast<const seal::seal_byte *>(
+                entry.second.data().c_str()),
+            entry.second.data().size());
+        break;
+      }
       default:
         warn("Not a ciphertext or plaintext");
         return {};
@@ -169,6 +179,13 @@ unique_ptr<msg::SEALValuation> serialize(const SEALValuation &obj) {
   auto &values_msg = *msg->mutable_values();
   auto &raw_msg = *msg->mutable_raw_values();
   for (const auto &entry : obj) {
+    auto seeded = obj.m_seeded.find(entry.first);
+    if (seeded != obj.m_seeded.end()) {
+      auto &value_msg = values_msg[entry.first];
+      value_msg.set_data(seeded->second);
+      value_msg.set_object_type(FheObject::SEEDED_CIPHERTEXT);
+      continue;
+    }
     visit(Overloaded{[&](const seal::Ciphertext &cipher) {
                        serializeSEALType(cipher, &values_msg[entry.first]);
                      },
@@ -201,6 +218,18 @@ unique_ptr<msg::SEALPublic> serialize(const SEALPublic &obj) {
 
   // printf("after serializeSEALType pk \n%zu",msg->public_key().data().size());
 
+  if (!obj.m_seeded_relin.empty() || !obj.m_seeded_galois.empty()) {
+    // Seeded keys, about half the size; the loader expands them per step
+    auto &galois_msg = *msg->mutable_seeded_galois_keys();
+    for (auto &item : obj.m_seeded_galois) {
+      galois_msg[item.first].set_data(item.second);
+      galois_msg[item.first].set_object_type(FheObject::GALOIS_KEYS);
+    }
+    msg->mutable_seeded_relin_keys()->set_data(obj.m_seeded_relin);
+    msg->mutable_seeded_relin_keys()->set_object_type(FheObject::RELIN_KEYS);
+    return msg;
+  }
+
   // to do As the number of rotations increases, gk will exceed the maximum limit of 2g PB.
   serializeSEALType(obj.galoisKeys, msg->mutable_galois_keys());
 
@@ -226,20 +255,32 @@ unique_ptr<SEALPublic> deserialize(const msg::SEALPublic &msg) {
   seal::PublicKey pk;
   deserializeSEALTypeWithContext(context, pk, msg.public_key());
   seal::GaloisKeys gk;
-  deserializeSEALTypeWithContext(context, gk, msg.galois_keys());
   seal::RelinKeys rk;
-  deserializeSEALTypeWithContext(context, rk, msg.relin_keys());
+  bool seeded = msg.has_seeded_relin_keys() || msg.seeded_galois_keys_size();
+  if (!seeded) {
+    deserializeSEALTypeWithContext(context, gk, msg.galois_keys());
+    deserializeSEALTypeWithContext(context, rk, msg.relin_keys());
+  }
 
+  std::shared_ptr<SealEncoderBase> p_en;
   if (enc_params.scheme() == seal::scheme_type::ckks) {
-    std::shared_ptr<SealEncoderBase> p_en =
-        std::make_shared<CkksEncoder>(context);
-    return std::make_unique<SEALPublic>(context, pk, gk, rk, p_en);
+    p_en = std::make_shared<CkksEncoder>(context);
   } else if (enc_params.scheme() == seal::scheme_type::bfv) {
-    std::shared_ptr<SealEncoderBase> p_en =
-        std::make_shared<BfvEncoder>(context);
-    return std::make_unique<SEALPublic>(context, pk, gk, rk, p_en);
+    p_en = std::make_shared<BfvEncoder>(context);
+  } else {
+    return {};
+  }
+  auto obj = std::make_unique<SEALPublic>(context, pk, gk, rk, p_en);
+  if (seeded) {
+    // Kept seeded, execute expands the keys of the steps a DAG uses
+    std::map<int, std::string> seeded_galois;
+    for (auto &item : msg.seeded_galois_keys()) {
+      seeded_galois[item.first] = item.second.data();
+    }
+    obj->setSeededKeys(std::move(seeded_galois),
+                       msg.seeded_relin_keys().data());
   }
-  return {};
+  return obj;
 }
 
 unique_ptr<msg::SEALSecret> serialize(const SEALSecret &obj) {
@@ -356,6 +397,12 @@ unique_ptr<msg::SealSignature> serialize(const SealSignature &obj) {
     info_msg.set_input_type(static_cast<int32_t>(info.input_type));
     info_msg.set_scale(info.scale);
     info_msg.set_level(info.level);
+    info_msg.set_is_complex(info.is_complex);
+  }
+
+  // Save the complex outputs
+  for (auto &name : obj.complex_outputs) {
+    msg->add_complex_outputs(name);
   }
 
   return msg;
@@ -367,11 +414,15 @@ unique_ptr<SealSignature> deserialize(const msg::SealSignature &msg) {
   for (auto &[key, info_msg] : msg.inputs()) {
     inputs.emplace(
         key, SealEncodingInfo(static_cast<DataType>(info_msg.input_type()),
-                              info_msg.scale(), info_msg.level()));
+                              info_msg.scale(), info_msg.level(),
+                              info_msg.is_complex()));
   }
+  unordered_set<string> complex_outputs(msg.complex_outputs().begin(),
+                                        msg.complex_outputs().end());
 
   // Return a new SealSignature object
-  return std::make_unique<SealSignature>(msg.vec_size(), move(inputs));
+  return std::make_unique<SealSignature>(msg.vec_size(), move(inputs),
+                                         move(complex_outputs));
 }
 
 int SealCkksAdapter::serializeAloInfo(const DagSerializePara &serialize_para,
@@ -439,7 +490,8 @@ int SealCkksAdapter::deserializeAloInfo(const string &str_info) {
       p_public = deserialize(tmp_info.seal_public());
     if (tmp_info.has_seal_secret())
       p_secret = deserialize(tmp_info.seal_secret());
-    // unique move
+    // unique move, cached executors reference the old context
+    curr->m_executors.clear();
     curr->m_seal_ctx = make_tuple(std::move(p_public), std::move(p_secret));
 
     if (tmp_info.has_ckks_parameters()) {
@@ -488,6 +540,7 @@ int SealCkksAdapter::deserializeInputInfo(const string &str_info,
     //   printf("input name %s , size %lu \n", item.first.c_str(),
     // item.second.data().size());
     // }
+    curr->touchInputs(*p_valuation);
     if (repalce)
       m_ckks_valution = std::move(p_valuation);
     else
@@ -596,7 +649,8 @@ int SealBfvAdapter::deserializeAloInfo(const string &str_info) {
       p_public = deserialize(tmp_info.seal_public());
     if (tmp_info.has_seal_secret())
       p_secret = deserialize(tmp_info.seal_secret());
-    // unique move
+    // unique move, cached executors reference the old context
+    curr->m_executors.clear();
     curr->m_seal_ctx = make_tuple(std::move(p_public), std::move(p_secret));
 
     if (tmp_info.has_bfv_parameters()) {
@@ -638,6 +692,7 @@ int SealBfvAdapter::deserializeInputInfo(const string &str_info, bool replace) {
   msg::SEALValuation tmp_info;
   if (tmp_info.ParseFromString(str_info)) {
     unique_ptr<SEALValuation> p_valuation = deserialize(tmp_info);
+    curr->touchInputs(*p_valuation);
     if (replace)
       m_valution = std::move(p_valuation);
     else
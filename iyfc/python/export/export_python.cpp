@@ -13,6 +13,7 @@
 #include <ostream>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/complex.h>
 #include <pybind11/operators.h>
 
 namespace py = pybind11;
@@ -162,6 +163,7 @@ PYBIND11_MODULE(pyiyfc, m) {
     m.def("encodeOrgInputforCmpForPython", &iyfc::encodeOrgInputforCmpForPython);
     m.def("encodeOrgInputFFTForPython", &iyfc::encodeOrgInputFFTForPython);
     m.def("getFFTOutputsForPython", &iyfc::getFFTOutputsForPython);
+    m.def("setThreadNum", &iyfc::setThreadNum);
 
     m.def("saveToFile", &iyfc::saveToFile<iyfc::Dag>);
     // m.def("loadFromFile", &iyfc::loadFromFileForPython<std::unique_ptr<iyfc::CKKSParameters>>, py::return_value_policy::reference, py::keep_alive<0, 1>());
@@ -191,6 +193,13 @@ PYBIND11_MODULE(pyiyfc, m) {
         .def_readwrite("need_encrpt_ctx", &iyfc::DagSerializePara::need_encrpt_ctx)
         .def_readwrite("need_decrypt_ctx", &iyfc::DagSerializePara::need_decrypt_ctx);
 
+    py::class_<iyfc::SlotSelection>(m, "SlotSelection")
+        .def(py::init<>())
+        .def_readwrite("offset", &iyfc::SlotSelection::offset)
+        .def_readwrite("stride", &iyfc::SlotSelection::stride)
+        .def_readwrite("count", &iyfc::SlotSelection::count)
+        .def_readwrite("replicas", &iyfc::SlotSelection::replicas);
+
 // TODO: Two methods with unique_ptr inputs
     py::class_<iyfc::Dag, std::shared_ptr<iyfc::Dag>>(m, "Dag")
         .def(py::init<std::string, std::uint64_t>())
@@ -212,6 +221,11 @@ PYBIND11_MODULE(pyiyfc, m) {
         .def("collectExprNode", &iyfc::Dag::collectExprNode)
         .def("freeNode", &iyfc::Dag::freeNode)
         .def("setSecLevel", &iyfc::Dag::setSecLevel)
+        .def("setOutputModSwitch", &iyfc::Dag::setOutputModSwitch)
+        .def("setOutputRange", &iyfc::Dag::setOutputRange)
+        .def("setInputRange", &iyfc::Dag::setInputRange)
+        .def("setTileSize", &iyfc::Dag::setTileSize)
+        .def("getLogicalVecSize", &iyfc::Dag::getLogicalVecSize)
         .def("setMulticore", &iyfc::Dag::setMulticore)
         .def("getInputs", &iyfc::Dag::getInputs, py::return_value_policy::reference)
         .def("getOutputs", &iyfc::Dag::getOutputs, py::return_value_policy::reference)
@@ -227,8 +241,13 @@ PYBIND11_MODULE(pyiyfc, m) {
         .def("doTranspile", &iyfc::Dag::doTranspile)
         .def("genKey", &iyfc::Dag::genKey)
         .def("encryptInput", &iyfc::Dag::encryptInput)
-        .def("executor", &iyfc::Dag::executor)
+        .def("executor", &iyfc::Dag::executor,
+             py::arg("set_inputs") = std::unordered_set<std::string>())
+        .def("executorForOutputs", &iyfc::Dag::executorForOutputs)
+        .def("setIncrementalExe", &iyfc::Dag::setIncrementalExe)
+        .def("setNoiseCheck", &iyfc::Dag::setNoiseCheck)
         .def("getDecryptOutput", &iyfc::Dag::getDecryptOutput)
+        .def("getPartialDecryptOutput", &iyfc::Dag::getPartialDecryptOutput)
         .def("getDecryptOutputForPython", &iyfc::Dag::getDecryptOutputForPython)
         .def("saveAloInfoToFile", &iyfc::Dag::saveAloInfoToFile)
         .def("loadAloInfoFromFile", &iyfc::Dag::loadAloInfoFromFile)
@@ -21,14 +21,41 @@
  * SOFTWARE.
  */
 #include "bfv_handler.h"
+#include <seal/modulus.h>
 #include <seal/util/hestdparms.h>
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <stdexcept>
+#include <string>
 #include "daghandler/ckks_rotation_keys_handler.h"
 #include "daghandler/mult_depth_cnt.h"
 #include "err_code.h"
 #include "util/logging.h"
 
 namespace iyfc {
+
+/**
+ * @brief Fewest plaintext bits from plain_bits up that have a batching prime
+ * t = 1 mod 2 * degree, which not every size has: the only 14 bit candidate
+ * for degree 4096 is 8193 = 3 * 2731
+ */
+static std::uint32_t batchingPlainBits(std::size_t degree,
+                                       std::uint32_t plain_bits) {
+  for (; plain_bits <= MAX_BFV_PLAIN_BITS; plain_bits++) {
+    try {
+      seal::PlainModulus::Batching(degree, static_cast<int>(plain_bits));
+      return plain_bits;
+    } catch (const std::logic_error &) {
+      // No prime of this size, try one bit more
+    }
+  }
+  throw std::logic_error("no batching plaintext prime of at most " +
+                         std::to_string(MAX_BFV_PLAIN_BITS) +
+                         " bits for poly modulus degree " +
+                         std::to_string(degree));
+}
+
 int BfvParametersHandler::dagTranspile(Dag &input_dag) {
   return transpile(input_dag);
 };
@@ -38,22 +65,30 @@ void BfvParametersHandler::transform(Dag &dag, NodeMap<DataType> &types,
   auto dag_rewrite = DagTraversal(dag);
 
   // Type checking for 'constant' and 'raw' nodes
-  dag_rewrite.forwardPass(TypeHandler(dag, types));
+  TypeInference inference(dag, types);
+  inference.update();
   // Expand the size of constant vectors and align them
   dag_rewrite.forwardPass(ConstantInt64Handler(dag, scales));
-  dag_rewrite.forwardPass(TypeHandler(dag, types));
+  inference.update();
   dag_rewrite.forwardPass(EncodeInserter(dag, types, scales));
-  dag_rewrite.forwardPass(TypeHandler(dag, types));
+  inference.update();
 
   // Consider Relinearization and ModSwitch for BFV
 
-  dag_rewrite.forwardPass(LazyRelinearizer(dag, types, scales));
+  // Relinearization pass, fewest relinearizations by a min cut
+  OptimalRelinearizer relinearizer(dag, types, scales);
+  auto relin_cnt = relinearizer();
+  LOG(LOGLEVEL::Debug,
+      "OptimalRelinearizer inserted %u relinearize nodes, %u fewer than "
+      "LazyRelinearizer",
+      relin_cnt, relinearizer.getSavedCnt());
+  dag.setRelinReport(RelinReport{relin_cnt, relinearizer.getLazyCnt()});
 
-  dag_rewrite.forwardPass(TypeHandler(dag, types));
-  // Align level parameters for ModSwitching (not actually adding ModSwitch nodes)
-  // BFV currently does not include ModSwitch operations
+  inference.update();
+  // Align level parameters, the noise driven ModSwitch nodes are inserted
+  // once the primes are known
   dag_rewrite.backwardPass(ModSwitcher(dag, types, scales));
-  dag_rewrite.forwardPass(TypeHandler(dag, types));
+  inference.update();
   dag_rewrite.forwardPass(SEALLowering(dag, types));
 }
 
@@ -62,38 +97,22 @@ void BfvParametersHandler::validate(Dag &dag, NodeMap<DataType> &types,
   auto dag_traverse = DagTraversal(dag);
   // Create a DAG traversal object for validation
   LevelsChecker lc(dag, types);
-  dag_traverse.forwardPass(lc);
-  try {
-    ParameterChecker pc(dag, types);
-    dag_traverse.forwardPass(pc);
-  } catch (const InconsistentParameters &e) {
-  }
+  ParameterChecker pc(dag, types);
+  bool params_consistent = true;
+  dag_traverse.forwardPass([&](const NodePtr &node) {
+    lc(node);
+    if (!params_consistent) return;
+    try {
+      pc(node);
+    } catch (const InconsistentParameters &e) {
+      params_consistent = false;
+    }
+  });
   // BFV does not have the concept of scales
   // ScalesChecker sc(dag, scales, types);
   // dag_traverse.forwardPass(sc);
 }
 
-std::size_t BfvParametersHandler::getMinDegreeForBitCount(
-    int (*MaxBitsFun)(std::size_t), int bit_cnt) {
-  std::size_t degree = 1024;
-  int max_bits_seen = 0;
-  while (true) {
-    auto max_bits_for_degree = MaxBitsFun(degree);
-    max_bits_seen = std::max(max_bits_seen, max_bits_for_degree);
-    if (max_bits_for_degree == 0) {
-      warn(
-          "Dag requires a %u bit modulus, but parameters are available for a "
-          "maximum of %u ",
-          bit_cnt, max_bits_seen);
-      throw std::logic_error(" in seal bfv ,err bit modulus!");
-    }
-    if (max_bits_for_degree >= bit_cnt) {
-      return degree;
-    }
-    degree *= 2;
-  }
-}
-
 void BfvParametersHandler::extractSignature(const Dag &dag) {
   std::unordered_map<std::string, SealEncodingInfo> inputs;
 
@@ -114,42 +133,31 @@ void BfvParametersHandler::extractSignature(const Dag &dag) {
 int BfvParametersHandler::determineEncryptionParameters(
     Dag &dag, NodeMapOptional<std::uint32_t> &scales, NodeMap<DataType> types) {
   auto dag_traverse = DagTraversal(dag);
-  EncryptionParametersSelectorForBfv eps(dag, scales, types);
-  dag_traverse.forwardPass(eps);
   // Rotation key selector
   RotationKeys rks(dag, types);
-  dag_traverse.forwardPass(rks);
+  // Value ranges for the plaintext modulus, noise for the coefficient modulus
+  BfvNoiseModel model(dag, types);
+  dag_traverse.forwardPass([&](const NodePtr &node) {
+    rks(node);
+    model(node);
+  });
 
   m_enc_params = std::make_shared<BfvParameters>();
   m_enc_params->rotations = rks.getRotationKeys();
-  // Use bits to determine poly_modulus_degree
-  m_enc_params->prime_bits = eps.getEncryptionParameters();
-
-  int bit_cnt = 0;
-
-  for (auto &logQ : m_enc_params->prime_bits) bit_cnt += logQ;
 
+  int (*max_bits_fun)(std::size_t) = nullptr;
   if (m_config.m_security_level <= 128) {
-    if (m_config.m_quantum_safe)
-      m_enc_params->poly_modulus_degree = getMinDegreeForBitCount(
-          &seal::util::seal_he_std_parms_128_tq, bit_cnt);
-    else
-      m_enc_params->poly_modulus_degree = getMinDegreeForBitCount(
-          &seal::util::seal_he_std_parms_128_tc, bit_cnt);
+    max_bits_fun = m_config.m_quantum_safe
+                       ? &seal::util::seal_he_std_parms_128_tq
+                       : &seal::util::seal_he_std_parms_128_tc;
   } else if (m_config.m_security_level <= 192) {
-    if (m_config.m_quantum_safe)
-      m_enc_params->poly_modulus_degree = getMinDegreeForBitCount(
-          &seal::util::seal_he_std_parms_192_tq, bit_cnt);
-    else
-      m_enc_params->poly_modulus_degree = getMinDegreeForBitCount(
-          &seal::util::seal_he_std_parms_192_tc, bit_cnt);
+    max_bits_fun = m_config.m_quantum_safe
+                       ? &seal::util::seal_he_std_parms_192_tq
+                       : &seal::util::seal_he_std_parms_192_tc;
   } else if (m_config.m_security_level <= 256) {
-    if (m_config.m_quantum_safe)
-      m_enc_params->poly_modulus_degree = getMinDegreeForBitCount(
-          &seal::util::seal_he_std_parms_256_tq, bit_cnt);
-    else
-      m_enc_params->poly_modulus_degree = getMinDegreeForBitCount(
-          &seal::util::seal_he_std_parms_256_tc, bit_cnt);
+    max_bits_fun = m_config.m_quantum_safe
+                       ? &seal::util::seal_he_std_parms_256_tq
+                       : &seal::util::seal_he_std_parms_256_tc;
   } else {
     warn(
         "iyfc has support for up to 256 bit security, but %d bit security was "
@@ -159,12 +167,73 @@ int BfvParametersHandler::determineEncryptionParameters(
     return SEAL_SECUITY_LEVEL_BITS_NOT_MATCH;
   }
 
-  LOG(LOGLEVEL::Debug, "bit_cnt %d, poly_modulus_degree %u", bit_cnt,
-      m_enc_params->poly_modulus_degree);
+  // 0 when an output depends on an input without a declared range
+  std::uint32_t value_bits = model.getPlainBits(dag.getOutputRanges());
+  if (value_bits > MAX_BFV_PLAIN_BITS) {
+    warn("Outputs need a %u bit plaintext modulus, values beyond %u bits "
+         "wrap around.",
+         value_bits, MAX_BFV_PLAIN_BITS);
+  }
 
-  // bfv poly_modulus_degree = slot;
-  auto slots = m_enc_params->poly_modulus_degree;
+  // Smallest secure degree whose data primes hold the noise of the DAG
+  int bit_cnt = 0;
+  int max_bits_seen = 0;
+  for (std::size_t degree = 1024;; degree *= 2) {
+    int max_bits = max_bits_fun(degree);
+    max_bits_seen = std::max(max_bits_seen, max_bits);
+    if (max_bits == 0) {
+      warn(
+          "Dag requires a %u bit modulus, but parameters are available for a "
+          "maximum of %u ",
+          bit_cnt, max_bits_seen);
+      throw std::logic_error(" in seal bfv ,err bit modulus!");
+    }
+    // bfv poly_modulus_degree = slot;
+    if (degree < dag.getVecSize()) continue;
 
+    std::uint32_t log_n = 0;
+    while ((std::size_t(1) << log_n) < degree) ++log_n;
+    // Batching needs a prime t = 1 mod 2N, so above 2N
+    std::uint32_t plain_bits =
+        value_bits != 0 ? value_bits : DEFAULT_BFV_PLAIN_BITS;
+    plain_bits = batchingPlainBits(
+        degree, std::min(std::max(plain_bits, log_n + 2), MAX_BFV_PLAIN_BITS));
+
+    auto data_bits = static_cast<std::uint32_t>(
+        std::ceil(model.getNoiseBits(degree, plain_bits)) +
+        BFV_NOISE_MARGIN_BITS + BFV_MOD_SWITCH_SLACK_BITS);
+    // Fewest primes of at most 60 bits, the special prime as large as the
+    // largest of them
+    std::uint32_t prime_cnt = (data_bits + 59) / 60;
+    std::vector<std::uint32_t> primes;
+    for (std::uint32_t i = 0; i < prime_cnt; i++) {
+      primes.push_back(data_bits / prime_cnt +
+                       (i < data_bits % prime_cnt ? 1 : 0));
+    }
+    primes.push_back(primes.front());
+    bit_cnt = 0;
+    for (auto &log_q : primes) bit_cnt += log_q;
+
+    if (bit_cnt <= max_bits) {
+      m_enc_params->poly_modulus_degree = degree;
+      m_enc_params->plain_modulus = plain_bits;
+      m_enc_params->prime_bits = std::move(primes);
+      break;
+    }
+  }
+
+  LOG(LOGLEVEL::Debug,
+      "bit_cnt %d, poly_modulus_degree %u, plain_modulus %u bits", bit_cnt,
+      m_enc_params->poly_modulus_degree, m_enc_params->plain_modulus);
+
+  // Run the tail of the circuit over fewer primes
+  BfvModSwitcher switcher(dag, types, scales);
+  auto switched =
+      switcher(model, m_enc_params->poly_modulus_degree,
+               m_enc_params->plain_modulus, m_enc_params->prime_bits);
+  LOG(LOGLEVEL::Debug, "bfv inserted %u mod_switch nodes", switched);
+
+  auto slots = m_enc_params->poly_modulus_degree;
   if (m_config.m_warn_vecsize && slots > dag.getVecSize()) {
     LOG(LOGLEVEL::Debug,
         "Dag specifies vector size %i while at least %i slots are "
@@ -175,21 +244,6 @@ int BfvParametersHandler::determineEncryptionParameters(
         "cost.",
         dag.getVecSize(), slots, slots);
   }
-  if (slots < dag.getVecSize()) {
-    if (m_config.m_warn_vecsize) {
-      LOG(LOGLEVEL::Debug,
-          "Dag uses vector size %i while only %i slots are required for "
-          "security. "
-          "This does not affect correctness, but higher performance may be "
-          "available "
-          "with a smaller vector size.",
-          dag.getVecSize(), slots);
-    }
-    m_enc_params->poly_modulus_degree = 2 * dag.getVecSize();
-  }
-  int n = m_enc_params->poly_modulus_degree;
-  int nexp = 0;
-  while (n >>= 1) ++nexp;
 
   return 0;
 }
@@ -27,6 +27,7 @@
 #include <cstdint>
 
 #include "bfv_config.h"
+#include "bfv_noise_model.h"
 #include "bfv_parameters.h"
 #include "daghandler/clean_node_handler.h"
 #include "daghandler/constant_handler.h"
@@ -36,10 +37,9 @@
 #include "daghandler/u32toconst_handler.h"
 #include "decision/parameters_interface.h"
 #include "encode_inserter.h"
-#include "encryption_parameter_selector.h"
-#include "lazy_relinearizer.h"
 #include "levels_checker.h"
 #include "mod_switcher.h"
+#include "optimal_relinearizer.h"
 #include "parameter_checker.h"
 #include "scales_checker.h"
 #include "seal_lowering.h"
@@ -74,14 +74,6 @@ class BfvParametersHandler : public ParametersInterface {
   void validate(Dag &dag, NodeMap<DataType> &types,
                 NodeMapOptional<std::uint32_t> &scales);
 
-  /**
-   * @brief Decision degree parameter
-   * @param [in] MaxBitsFun Function related to security strength
-   * @param [in] bit_count Total bit count required for DAG execution
-   */
-  std::size_t getMinDegreeForBitCount(int (*MaxBitsFun)(std::size_t),
-                                      int bit_count);
-
   /**
    * @brief Determine encryption parameters
    * @param [in] dag DAG
@@ -0,0 +1,166 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "bfv_noise_model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace iyfc {
+
+const double BFV_UNKNOWN_RANGE = std::numeric_limits<double>::infinity();
+
+double addLog2(double a, double b) {
+  double hi = std::max(a, b);
+  double lo = std::min(a, b);
+  if (std::isinf(hi) || std::isinf(lo)) return hi;
+  return hi + std::log2(1.0 + std::exp2(lo - hi));
+}
+
+template <typename T>
+static double maxAbsBits(const ConstantValue<T> &value, std::size_t slots) {
+  std::vector<T> scratch;
+  double max_abs = 1;
+  for (auto &item : value.expand(scratch, slots)) {
+    max_abs = std::max(max_abs, std::abs(static_cast<double>(item)));
+  }
+  return std::log2(max_abs);
+}
+
+BfvNoiseModel::BfvNoiseModel(Dag &g, NodeMap<DataType> &types,
+                             double unknown_bits)
+    : m_dag(g), m_types(types), m_unknown_bits(unknown_bits),
+      m_value_bits(g) {}
+
+void BfvNoiseModel::operator()(const NodePtr &node) {
+  auto &operands = node->getOperands();
+  double bits = BFV_UNKNOWN_RANGE;
+  switch (node->m_op_type) {
+    case OpType::Input:
+      bits = node->has<RangeAttr>() ? node->get<RangeAttr>() : m_unknown_bits;
+      break;
+    case OpType::Constant:
+      if (node->has<ConstValueInt64Attr>()) {
+        bits = maxAbsBits(*node->get<ConstValueInt64Attr>(),
+                          m_dag.getVecSize());
+      } else if (node->has<ConstValueAttr>()) {
+        bits = maxAbsBits(*node->get<ConstValueAttr>(), m_dag.getVecSize());
+      }
+      break;
+    case OpType::U32Constant:
+      bits = std::log2(1.0 + node->get<Uint32ConstAttr>());
+      break;
+    case OpType::Add:
+    case OpType::Sub:
+      bits = addLog2(m_value_bits[operands[0]], m_value_bits[operands[1]]);
+      break;
+    case OpType::Mul:
+      bits = m_value_bits[operands[0]] + m_value_bits[operands[1]];
+      break;
+    case OpType::Output:
+    case OpType::Negate:
+    case OpType::RotateLeftConst:
+    case OpType::RotateRightConst:
+    case OpType::Relinearize:
+    case OpType::ModSwitch:
+    case OpType::Rescale:
+    case OpType::Encode:
+      bits = m_value_bits[operands[0]];
+      break;
+    default:
+      break;
+  }
+  m_value_bits[node] = bits;
+  if (m_types[node] == DataType::Cipher) m_order.push_back(node);
+}
+
+std::uint32_t BfvNoiseModel::getPlainBits(
+    const std::unordered_map<std::string, std::uint32_t> &output_ranges) {
+  std::uint32_t plain_bits = 0;
+  for (auto &entry : m_dag.getOutputs()) {
+    double bits = m_value_bits[entry.second];
+    auto declared = output_ranges.find(entry.first);
+    if (declared != output_ranges.end()) {
+      bits = std::min(bits, static_cast<double>(declared->second));
+    }
+    if (std::isinf(bits)) return 0;
+    // |value| < t / 2 decodes to the right sign
+    plain_bits = std::max(
+        plain_bits, static_cast<std::uint32_t>(std::ceil(bits)) + 2);
+  }
+  return plain_bits;
+}
+
+double BfvNoiseModel::getNoiseBits(std::size_t degree,
+                                   std::uint32_t plain_bits) {
+  NodeMap<double> noise(m_dag);
+  getNodeNoiseBits(degree, plain_bits, noise);
+  double max_noise = plain_bits + std::log2(static_cast<double>(degree)) +
+                     FRESH_ERROR_BITS;
+  for (auto &node : m_order) {
+    if (node->m_op_type == OpType::Output) {
+      max_noise = std::max(max_noise, noise[node]);
+    }
+  }
+  return max_noise;
+}
+
+void BfvNoiseModel::getNodeNoiseBits(std::size_t degree,
+                                     std::uint32_t plain_bits,
+                                     NodeMap<double> &noise) {
+  double log_n = std::log2(static_cast<double>(degree));
+  double log_t = plain_bits;
+  double fresh = log_t + log_n + FRESH_ERROR_BITS;
+  double key_switch = log_n + FRESH_ERROR_BITS;
+  for (auto &node : m_order) {
+    // Noise of the ciphertext operands, plaintexts add none
+    double sum = -BFV_UNKNOWN_RANGE;
+    std::size_t cipher_cnt = 0;
+    for (auto &operand : node->getOperands()) {
+      if (m_types[operand] != DataType::Cipher) continue;
+      sum = addLog2(sum, noise[operand]);
+      ++cipher_cnt;
+    }
+    double bits = fresh;
+    switch (node->m_op_type) {
+      case OpType::Input:
+        break;
+      case OpType::Mul:
+        bits = cipher_cnt > 1 ? sum + log_t + log_n + 1
+                              : sum + log_t + log_n - 1;
+        break;
+      case OpType::Relinearize:
+      case OpType::RotateLeftConst:
+      case OpType::RotateRightConst:
+        bits = addLog2(sum, key_switch);
+        break;
+      default:
+        if (cipher_cnt > 0) bits = sum;
+        break;
+    }
+    noise[node] = bits;
+  }
+}
+
+}  // namespace iyfc
@@ -0,0 +1,117 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "dag/iyfc_dag.h"
+#include "dag/node_map.h"
+
+namespace iyfc {
+
+// log2 of the fresh error bound 2 * N * 6 sigma, without the log2(N)
+const double FRESH_ERROR_BITS = 5.3;
+
+/**
+ * @brief log2(2^a + 2^b), -inf stands for 0
+ */
+double addLog2(double a, double b);
+
+/**
+ * @class BfvNoiseModel
+ * @brief Value ranges and noise growth of a compiled SEAL BFV DAG
+ * @details The traversal bounds every value from the declared input ranges
+ * and the constants, in log2. Noise is evaluated afterwards for a degree and
+ * plaintext modulus, as log2 of the invariant noise times q: fresh
+ * ciphertexts start at log2(t * N) plus the error bound, a ciphertext
+ * product multiplies the noise of its operands by about 2 * t * N, a
+ * plaintext product by t * N / 2, additions add the noise of both operands
+ * and key switching adds fresh-sized noise. Decryption is correct while the
+ * data primes have more bits than the noise.
+ */
+class BfvNoiseModel {
+ public:
+  /**
+   * @brief BfvNoiseModel constructor
+   * @param [in] g DAG
+   * @param [in] types Node data types
+   * @param [in] unknown_bits Bound of inputs without a declared range
+   */
+  BfvNoiseModel(Dag &g, NodeMap<DataType> &types,
+                double unknown_bits = std::numeric_limits<double>::infinity());
+
+  /**
+   * @brief Overloaded () function, bounds the value of one node
+   */
+  void operator()(const NodePtr &node);
+
+  /**
+   * @brief log2 bound of the value of a node
+   */
+  double getValueBits(const NodePtr &node) const {
+    return m_value_bits[*node];
+  }
+
+  /**
+   * @brief Plaintext modulus bits holding every output as a signed value
+   * @param [in] output_ranges Declared output ranges, they cap the bound
+   * @return 0 if an output depends on an input without a declared range
+   */
+  std::uint32_t getPlainBits(
+      const std::unordered_map<std::string, std::uint32_t> &output_ranges);
+
+  /**
+   * @brief Largest noise in bits at the outputs
+   * @param [in] degree Polynomial modulus degree
+   * @param [in] plain_bits Plaintext modulus bits
+   */
+  double getNoiseBits(std::size_t degree, std::uint32_t plain_bits);
+
+  /**
+   * @brief Noise in bits of every ciphertext node at the full modulus
+   * @param [in] degree Polynomial modulus degree
+   * @param [in] plain_bits Plaintext modulus bits
+   * @param [out] noise Node noise bits
+   */
+  void getNodeNoiseBits(std::size_t degree, std::uint32_t plain_bits,
+                        NodeMap<double> &noise);
+
+  /**
+   * @brief Ciphertext nodes in forward order
+   */
+  const std::vector<NodePtr> &getCipherNodes() const { return m_order; }
+
+ private:
+  Dag &m_dag;
+  NodeMap<DataType> &m_types;
+  double m_unknown_bits;
+  NodeMap<double> m_value_bits;  // log2 of the value bound, inf if unknown
+  std::vector<NodePtr> m_order;  // forward order of the ciphertext nodes
+};
+
+}  // namespace iyfc
@@ -38,15 +38,8 @@ namespace iyfc {
 struct BfvParameters {
   std::set<int> rotations;
   std::uint32_t poly_modulus_degree;
-  std::uint32_t plain_modulus;
-  std::vector<std::uint32_t> prime_bits;
-  
-  //  parms.set_plain_modulus(PlainModulus::Batching(poly_modulus_degree, 32));
-  //  1024 
-
-  // Default:
-  // set_coeff_modulus(CoeffModulus::BFVDefault(poly_modulus_degree));
-
+  std::uint32_t plain_modulus;  // bits of the batching prime
+  std::vector<std::uint32_t> prime_bits;  // in LOG-scale, special prime last
 };
 
 std::unique_ptr<msg::BfvParameters> serialize(const BfvParameters &);
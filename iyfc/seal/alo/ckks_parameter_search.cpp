@@ -0,0 +1,223 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ckks_parameter_search.h"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <tuple>
+
+namespace iyfc {
+
+// Output primes are split into primes of this many bits at most and least
+const std::uint32_t MIN_PRIME_BITS = 20;
+const std::uint32_t MAX_PRIME_BITS = 60;
+
+std::uint32_t CkksChain::totalBits() const {
+  std::uint32_t bits = special_prime;
+  for (auto &prime : output_primes) bits += prime;
+  for (auto &prime : rescale_primes) bits += prime;
+  return bits;
+}
+
+std::vector<std::uint32_t> CkksChain::primeBits() const {
+  std::vector<std::uint32_t> primes(output_primes);
+  primes.insert(primes.end(), rescale_primes.begin(), rescale_primes.end());
+  primes.push_back(special_prime);
+  return primes;
+}
+
+CkksParameterSearch::CkksParameterSearch(Dag &g, NodeMap<DataType> &types)
+    : m_dag(g), m_types(types), m_dropped(g) {}
+
+int CkksParameterSearch::getOpCost(OpType op, bool plain_operand) {
+  switch (op) {
+    case OpType::Negate:
+    case OpType::Add:
+    case OpType::Sub:
+      return ADD_COST;
+    case OpType::Mul:
+      return plain_operand ? MUL_PLAIN_COST : MUL_COST;
+    case OpType::Relinearize:
+    case OpType::RotateLeftConst:
+    case OpType::RotateRightConst:
+      return KEY_SWITCH_COST;
+    case OpType::Rescale:
+      return RESCALE_COST;
+    case OpType::ModSwitch:
+      return MOD_SWITCH_COST;
+    case OpType::Encode:
+      return ENCODE_COST;
+    default:
+      return -1;
+  }
+}
+
+int CkksParameterSearch::getOpCost(const NodePtr &node) {
+  if (node->m_op_type == OpType::Encode) return ENCODE_COST;
+  if (m_types[node] != DataType::Cipher) return -1;
+  bool plain_operand = false;
+  for (auto &operand : node->getOperands()) {
+    if (m_types[operand] != DataType::Cipher) plain_operand = true;
+  }
+  return getOpCost(node->m_op_type, plain_operand);
+}
+
+void CkksParameterSearch::countOp(OpType op, bool plain_operand,
+                                  std::uint32_t dropped) {
+  int op_cost = getOpCost(op, plain_operand);
+  if (op_cost < 0) return;
+  if (m_op_cnt.size() <= dropped) m_op_cnt.resize(dropped + 1);
+  m_op_cnt[dropped][op_cost]++;
+}
+
+void CkksParameterSearch::operator()(const NodePtr &node) {
+  std::uint32_t dropped = 0;
+  for (auto &operand : node->getOperands()) {
+    dropped = std::max(dropped, m_dropped[operand]);
+  }
+  // Rescales and mod switches run before their prime is dropped
+  int op_cost = getOpCost(node);
+  if (op_cost >= 0) {
+    if (m_op_cnt.size() <= dropped) m_op_cnt.resize(dropped + 1);
+    m_op_cnt[dropped][op_cost]++;
+  }
+  if (node->m_op_type == OpType::Rescale ||
+      node->m_op_type == OpType::ModSwitch) {
+    ++dropped;
+  }
+  m_dropped[node] = dropped;
+}
+
+double CkksParameterSearch::cost(std::size_t degree,
+                                 const CkksChain &chain) const {
+  double n = static_cast<double>(degree);
+  double log_n = std::log2(n);
+  std::int64_t data_primes =
+      chain.output_primes.size() + chain.rescale_primes.size();
+  double total = 0;
+  for (std::size_t dropped = 0; dropped < m_op_cnt.size(); dropped++) {
+    double l = static_cast<double>(
+        std::max<std::int64_t>(1, data_primes - dropped));
+    auto &cnt = m_op_cnt[dropped];
+    // Two polynomials per ciphertext, all in NTT form
+    total += cnt[ADD_COST] * 2 * n * l;
+    total += cnt[MUL_PLAIN_COST] * 2 * n * l;
+    total += cnt[MUL_COST] * 4 * n * l;
+    total += cnt[MOD_SWITCH_COST] * 2 * n * l;
+    // Inverse NTT of the last prime, NTT into the others, for both parts
+    total += cnt[RESCALE_COST] * 2 * n * log_n * l;
+    // Every prime is decomposed and lifted to all data primes and the
+    // special prime, then multiplied with both key parts
+    total += cnt[KEY_SWITCH_COST] * n * (log_n + 2) * l * (l + 1);
+    total += cnt[ENCODE_COST] * n * log_n * (l + 1);
+  }
+  return total;
+}
+
+std::size_t CkksParameterSearch::getMinDegree(int (*max_bits_fun)(std::size_t),
+                                              std::uint32_t bit_cnt) {
+  for (std::size_t degree = 1024;; degree *= 2) {
+    auto max_bits = max_bits_fun(degree);
+    if (max_bits == 0) return 0;
+    if (max_bits >= static_cast<int>(bit_cnt)) return degree;
+  }
+}
+
+CkksChain CkksParameterSearch::search(int (*max_bits_fun)(std::size_t),
+                                      std::size_t min_degree,
+                                      const CkksChain &baseline,
+                                      std::vector<std::uint32_t> output_bits,
+                                      bool keep_output_bounds) {
+  // Prime boundaries the output primes have to reach
+  std::sort(output_bits.begin(), output_bits.end());
+  output_bits.erase(std::unique(output_bits.begin(), output_bits.end()),
+                    output_bits.end());
+  if (!keep_output_bounds && !output_bits.empty()) {
+    output_bits.erase(output_bits.begin(), output_bits.end() - 1);
+  }
+
+  std::set<std::vector<std::uint32_t>> output_splits;
+  for (std::uint32_t cap = MIN_PRIME_BITS; cap <= MAX_PRIME_BITS; cap++) {
+    std::vector<std::uint32_t> split;
+    std::uint32_t covered = 0;
+    for (auto bits : output_bits) {
+      if (bits <= covered) continue;
+      std::uint32_t need = bits - covered;
+      std::uint32_t cnt = (need + cap - 1) / cap;
+      for (std::uint32_t i = 0; i < cnt; i++) {
+        std::uint32_t prime = need / cnt + (i < need % cnt ? 1 : 0);
+        prime = std::max(prime, MIN_PRIME_BITS);
+        split.push_back(prime);
+        covered += prime;
+      }
+    }
+    if (!split.empty()) output_splits.insert(std::move(split));
+  }
+
+  std::uint32_t max_rescale = 0;
+  for (auto &prime : baseline.rescale_primes) {
+    max_rescale = std::max(max_rescale, prime);
+  }
+
+  std::vector<CkksChain> candidates{baseline};
+  for (auto &split : output_splits) {
+    CkksChain chain;
+    chain.output_primes = split;
+    chain.rescale_primes = baseline.rescale_primes;
+    // The special prime has to be at least as large as any other prime
+    std::uint32_t max_prime =
+        std::max(max_rescale, *std::max_element(split.begin(), split.end()));
+    chain.special_prime = max_prime;
+    candidates.push_back(chain);
+    if (max_prime < MAX_PRIME_BITS) {
+      chain.special_prime = MAX_PRIME_BITS;
+      candidates.push_back(chain);
+    }
+  }
+
+  CkksChain best;
+  m_candidate_cnt = 0;
+  for (auto &chain : candidates) {
+    std::size_t degree = getMinDegree(max_bits_fun, chain.totalBits());
+    if (degree == 0) continue;
+    // Fewer slots than the vector size cannot run, more are emulated
+    chain.poly_modulus_degree = std::max(degree, min_degree);
+    chain.cost = cost(chain.poly_modulus_degree, chain);
+    ++m_candidate_cnt;
+    // Ties go to the larger special prime, which adds less key switch noise
+    if (best.poly_modulus_degree == 0 ||
+        std::make_tuple(chain.cost, -static_cast<std::int64_t>(
+                                        chain.special_prime),
+                        chain.totalBits()) <
+            std::make_tuple(best.cost, -static_cast<std::int64_t>(
+                                           best.special_prime),
+                            best.totalBits())) {
+      best = chain;
+    }
+  }
+  return best;
+}
+
+}  // namespace iyfc
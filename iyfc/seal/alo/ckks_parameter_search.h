@@ -0,0 +1,143 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "dag/iyfc_dag.h"
+#include "dag/node_map.h"
+
+namespace iyfc {
+
+/**
+ * @struct CkksChain
+ * @brief One SEAL CKKS parameter set: output primes, the primes the rescales
+ * divide by, the special (key) prime and the polynomial degree.
+ */
+struct CkksChain {
+  std::vector<std::uint32_t> output_primes;
+  std::vector<std::uint32_t> rescale_primes;
+  std::uint32_t special_prime = 0;
+  std::size_t poly_modulus_degree = 0;  // 0 when no degree is secure
+  double cost = 0;
+
+  std::uint32_t totalBits() const;
+  /**
+   * @brief Prime bit sizes in SEAL order, special prime last
+   */
+  std::vector<std::uint32_t> primeBits() const;
+};
+
+/**
+ * @class CkksParameterSearch
+ * @brief Searches SEAL CKKS parameters for the lowest estimated latency
+ * @details The traversal counts the ciphertext operations of the DAG by the
+ * number of primes already dropped before them. The search then splits the
+ * output primes in every way from 20 to 60 bits per prime, tries the largest
+ * prime and 60 bits as special prime, takes the smallest secure degree for
+ * each and scores it with a per-op latency model. The rescale primes are
+ * fixed by the scales of the DAG and are never changed.
+ */
+class CkksParameterSearch {
+ public:
+  /**
+   * @brief CkksParameterSearch constructor
+   * @param [in] g DAG
+   * @param [in] types Node data types
+   */
+  CkksParameterSearch(Dag &g, NodeMap<DataType> &types);
+
+  /**
+   * @brief Overloaded () function, counts the op of one node
+   */
+  void operator()(const NodePtr &node);
+
+  /**
+   * @brief Counts a ciphertext op by its type instead of a node
+   * @details For rewrites that are only planned, see RescalePlanner.
+   * @param [in] op Op type
+   * @param [in] plain_operand Whether a multiplication has a plain operand
+   * @param [in] dropped Primes dropped before the op
+   */
+  void countOp(OpType op, bool plain_operand, std::uint32_t dropped);
+
+  /**
+   * @brief Estimated latency of the DAG with a chain at a degree
+   * @details In units of one multiplication modulo a prime. Key switching
+   * (relinearize and rotate) is quadratic in the number of primes, so it
+   * dominates deep chains.
+   */
+  double cost(std::size_t degree, const CkksChain &chain) const;
+
+  /**
+   * @brief Find the cheapest secure chain
+   * @param [in] max_bits_fun Max modulus bits per degree for the security
+   * level, 0 for unsupported degrees
+   * @param [in] min_degree Smallest degree with enough slots for the DAG
+   * @param [in] baseline Chain of EncryptionParametersSelector, always a
+   * candidate
+   * @param [in] output_bits Bits each output needs
+   * @param [in] keep_output_bounds Keep a prime boundary at every output
+   * size, so smaller outputs can be switched down
+   * @return The cheapest chain, poly_modulus_degree 0 if none is secure
+   */
+  CkksChain search(int (*max_bits_fun)(std::size_t), std::size_t min_degree,
+                   const CkksChain &baseline,
+                   std::vector<std::uint32_t> output_bits,
+                   bool keep_output_bounds);
+
+  /**
+   * @brief Smallest degree from 1024 up whose bound covers bit_cnt, 0 if
+   * none does
+   */
+  static std::size_t getMinDegree(int (*max_bits_fun)(std::size_t),
+                                  std::uint32_t bit_cnt);
+
+  std::size_t getCandidateCnt() const { return m_candidate_cnt; }
+
+ private:
+  enum OpCost {
+    ADD_COST,
+    MUL_PLAIN_COST,
+    MUL_COST,
+    KEY_SWITCH_COST,
+    RESCALE_COST,
+    MOD_SWITCH_COST,
+    ENCODE_COST,
+    OP_COST_CNT
+  };
+  static int getOpCost(OpType op, bool plain_operand);
+  int getOpCost(const NodePtr &node);
+
+  Dag &m_dag;
+  NodeMap<DataType> &m_types;
+  NodeMap<std::uint32_t> m_dropped;  // primes dropped on the way to a node
+  // Op counts by the primes dropped before the op
+  std::vector<std::array<std::uint64_t, OP_COST_CNT>> m_op_cnt;
+  std::size_t m_candidate_cnt = 0;
+};
+
+}  // namespace iyfc
@@ -51,33 +51,7 @@ void EagerWaterlineRescaler::operator()(
     scale[node] = scale[node->operandAt(0)];
     if (isAdditionOp(node->m_op_type)) {
       // Addition logic
-      auto max_scale = scale[node];
-      for (auto &operand : node->getOperands()) {
-        if (scale[operand] > max_scale) max_scale = scale[operand];
-      }
-
-      // Add 1* c to ensure scale correctness constraint + - ==
-      for (auto &operand : node->getOperands()) {
-        if (scale[operand] < max_scale && type[operand] != DataType::Raw) {
-          LOG(LOGLEVEL::Trace,
-              "Scaling up t%i from scale %i to match other addition operands "
-              "at scale %i",
-              operand->m_index, scale[operand], max_scale);
-
-          auto scale_constant = node->m_dag->makeUniformConstant(1);
-          dag.updateGroupIndex();
-          scale[scale_constant] = max_scale - scale[operand];
-          scale_constant->set<EncodeAtScaleAttr>(scale[scale_constant]);
-
-          auto mul_node = dag.makeNode(OpType::Mul, {operand, scale_constant});
-          scale[mul_node] = max_scale;
-          node->replaceOperand(operand, mul_node);
-        }
-      }
-      for (auto &operand : node->getOperands()) {
-        assert(max_scale == scale[operand] || type[operand] == DataType::Raw);
-      }
-      scale[node] = max_scale;
+      matchAdditionScales(node);
     }
     return;
   }
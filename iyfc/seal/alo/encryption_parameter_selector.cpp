@@ -76,10 +76,9 @@ void EncryptionParametersSelector::operator()(
 
     // CKKS only processes rescale nodes, ignoring modulus switches,
     // because there always exists a longest path that does not include modulus switches.
-    if (isNeedCheckOp(node->m_op_type)) {
+    if (node->m_op_type == OpType::Rescale) {
       auto new_size = parms.size() + 1;
-      // auto divisor = node->get<RescaleDivisorAttr>();
-      auto divisor = getNodeParms(node);
+      auto divisor = node->get<RescaleDivisorAttr>();
       assert(divisor != 0);
       parms.push_back(divisor);
       // LOG(LOGLEVEL::Debug,
@@ -149,6 +148,7 @@ EncryptionParametersSelector::getEncryptionParameters() {
     if (max_output_size > max_parm) max_parm = max_output_size;
     parms.push_back(max_parm);
   }
+  m_output_primes = parms;
 
   // Add the middle longest parms
   for (auto &entry : m_dag.getOutputs()) {
@@ -156,6 +156,7 @@ EncryptionParametersSelector::getEncryptionParameters() {
     auto &op_parms = m_nodes[output];
 
     if (max_len == op_parms.size()) {
+      m_rescale_primes.assign(op_parms.rbegin(), op_parms.rend());
       parms.insert(parms.end(), op_parms.rbegin(), op_parms.rend());
       break;
     }
@@ -167,21 +168,35 @@ EncryptionParametersSelector::getEncryptionParameters() {
   return parms;
 }
 
-bool EncryptionParametersSelector::isNeedCheckOp(const OpType &op_code) {
-  return op_code == OpType::Rescale;
-}
-
-uint32_t EncryptionParametersSelector::getNodeParms(const NodePtr &node) {
-  return node->get<RescaleDivisorAttr>();
-}
-
-bool EncryptionParametersSelectorForBfv::isNeedCheckOp(const OpType &op_code) {
-  return op_code == OpType::Mul;
+std::vector<std::uint32_t> EncryptionParametersSelector::getOutputBits() {
+  std::vector<std::uint32_t> bits;
+  for (const auto &entry : m_dag.getOutputs()) {
+    auto &output = entry.second;
+    bits.push_back(output->get<RangeAttr>() + m_scales[output]);
+  }
+  return bits;
 }
 
-// This is just an estimate of the longest multiplication path. More detailed bit calculations are needed later.
-uint32_t EncryptionParametersSelectorForBfv::getNodeParms(const NodePtr &node) {
-  return m_dag.m_scale/2;
+std::unordered_map<std::string, std::uint32_t>
+EncryptionParametersSelector::getOutputDropLevels() {
+  std::unordered_map<std::string, std::uint32_t> drop_levels;
+  for (const auto &entry : m_dag.getOutputs()) {
+    auto &output = entry.second;
+    if (types[output] != DataType::Cipher) continue;
+    auto size = output->get<RangeAttr>() + m_scales[output];
+
+    // Keep the first prime even if the output needs no bits at all
+    std::uint32_t keep = 1;
+    std::uint32_t bits = m_output_primes.empty() ? 0 : m_output_primes[0];
+    while (keep < m_output_primes.size() && bits < size) {
+      bits += m_output_primes[keep];
+      ++keep;
+    }
+    if (keep < m_output_primes.size()) {
+      drop_levels[entry.first] = m_output_primes.size() - keep;
+    }
+  }
+  return drop_levels;
 }
 
 }  // namespace iyfc
@@ -24,6 +24,8 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "dag/iyfc_dag.h"
@@ -55,9 +57,42 @@ class EncryptionParametersSelector {
 
   std::vector<std::uint32_t> getEncryptionParameters();
 
-  virtual bool isNeedCheckOp(const OpType &op_code);
+  /**
+   * @brief Levels each output can still drop after the computation
+   * @details Call after getEncryptionParameters. All outputs end on the
+   * output primes, an output only needs the shortest prefix of them covering
+   * its scale plus range. CKKS only.
+   * @return Output name to the number of mod switches
+   */
+  std::unordered_map<std::string, std::uint32_t> getOutputDropLevels();
+
+  /**
+   * @brief Primes taken by the rescales of the longest chain, in the order
+   * they follow the output primes. Call after getEncryptionParameters.
+   */
+  const std::vector<std::uint32_t> &getRescalePrimes() const {
+    return m_rescale_primes;
+  }
+
+  /**
+   * @brief Primes reserved for the outputs, first in the chain
+   */
+  const std::vector<std::uint32_t> &getOutputPrimes() const {
+    return m_output_primes;
+  }
+
+  /**
+   * @brief Replace the output primes, e.g. by a split chosen by a parameter
+   * search. They must still cover the largest output.
+   */
+  void setOutputPrimes(const std::vector<std::uint32_t> &primes) {
+    m_output_primes = primes;
+  }
 
-  virtual uint32_t getNodeParms(const NodePtr &node);
+  /**
+   * @brief Bits (range plus scale) each output needs at the end
+   */
+  std::vector<std::uint32_t> getOutputBits();
 
   Dag &m_dag;
 
@@ -65,26 +100,8 @@ class EncryptionParametersSelector {
   NodeMapOptional<std::uint32_t> &m_scales;
   NodeMap<std::vector<std::uint32_t>> m_nodes;
   NodeMap<DataType> &types;
+  std::vector<std::uint32_t> m_output_primes;  // primes left at the outputs
+  std::vector<std::uint32_t> m_rescale_primes;
 };
 
-/**
- * @class EncryptionParametersSelectorForBfv Inherits from EncryptionParametersSelector
- * @brief BFV does not include rescale operations. Overrides isRescaleOp
- */
-class EncryptionParametersSelectorForBfv : public EncryptionParametersSelector {
- public:
-  /**
-   * @brief EncryptionParametersSelector Constructor
-   * @param [in] g DAG
-   * @param [in] scales Node scales
-   * @param [in] types Node data types
-   */
-  EncryptionParametersSelectorForBfv(Dag &g,
-                                     NodeMapOptional<std::uint32_t> &scales,
-                                     NodeMap<DataType> &types)
-      : EncryptionParametersSelector(g, scales, types) {}
-
-  virtual bool isNeedCheckOp(const OpType &op_code);
-  virtual uint32_t getNodeParms(const NodePtr &node);
-};
 }  // namespace iyfc
@@ -0,0 +1,96 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "lazy_waterline_rescaler.h"
+
+#include <vector>
+
+#include "util/logging.h"
+
+namespace iyfc {
+
+LazyWaterlineRescaler::LazyWaterlineRescaler(
+    Dag &g, NodeMap<DataType> &type, NodeMapOptional<std::uint32_t> &scale)
+    : Rescaler(g, type, scale), m_rescaled(g) {
+  m_min_scale = 0;
+  for (auto &source : dag.getSources()) {
+    if (scale[source] > m_min_scale) m_min_scale = scale[source];
+  }
+  m_fixed_rescale = dag.m_scale;
+  assert(m_min_scale != 0);
+}
+
+NodePtr LazyWaterlineRescaler::rescaleDown(const NodePtr &node) {
+  if (type[node] == DataType::Raw ||
+      scale[node] < m_fixed_rescale + m_min_scale) {
+    return node;
+  }
+  if (m_rescaled[node]) return m_rescaled[node];
+
+  auto temp = node;
+  while (scale[temp] >= m_fixed_rescale + m_min_scale) {
+    auto rescale_node = dag.makeRescale(temp, m_fixed_rescale);
+    type[rescale_node] = type[temp];
+    scale[rescale_node] = scale[temp] - m_fixed_rescale;
+    temp = rescale_node;
+  }
+  m_rescaled[node] = temp;
+  return temp;
+}
+
+void LazyWaterlineRescaler::operator()(NodePtr &node) {  // forward pass
+  if (node->numOperands() == 0) return;
+  if (type[node] == DataType::Raw) {
+    handleRawScale(node);
+    return;
+  }
+
+  if (isRescaleOp(node->m_op_type)) return;
+
+  // Products and outputs take their operands below the waterline
+  if (isMultiplicationOp(node->m_op_type) ||
+      node->m_op_type == OpType::Output) {
+    std::vector<NodePtr> operands = node->getOperands();
+    for (auto &operand : operands) {
+      auto rescaled = rescaleDown(operand);
+      if (rescaled != operand) node->replaceOperand(operand, rescaled);
+    }
+  }
+
+  if (!isMultiplicationOp(node->m_op_type)) {
+    // Non-multiplication, use op[0]
+    scale[node] = scale[node->operandAt(0)];
+    if (isAdditionOp(node->m_op_type)) {
+      matchAdditionScales(node);
+    }
+    return;
+  }
+
+  std::uint32_t mult_scale = 0;
+  for (auto &operand : node->getOperands()) {
+    mult_scale += scale[operand];
+  }
+  assert(mult_scale != 0);
+  scale[node] = mult_scale;
+}
+
+}  // namespace iyfc
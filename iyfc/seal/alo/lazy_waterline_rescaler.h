@@ -0,0 +1,64 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#include "rescaler.h"
+
+namespace iyfc {
+/**
+ * @class LazyWaterlineRescaler
+ * @brief Rescales a value above the waterline only where it is multiplied
+ * or output.
+ * @details Additions, rotations and relinearizations run on the unrescaled
+ * value, so a sum of products pays one rescale instead of one per term.
+ * Values reused by several products share one rescale.
+ */
+class LazyWaterlineRescaler : public Rescaler {
+  std::uint32_t m_min_scale;
+  std::uint32_t m_fixed_rescale{DEFAULT_SCALE};
+  NodeMap<NodePtr> m_rescaled;  // Rescaled copy of a value, shared by uses
+
+  /**
+   * @brief Rescaled copy of node if it is above the waterline, else node.
+   */
+  NodePtr rescaleDown(const NodePtr &node);
+
+ public:
+  /**
+   * @brief LazyWaterlineRescaler constructor.
+   * @param g The DAG.
+   * @param type NodeMap representing node data types.
+   * @param scale NodeMapOptional representing node scales.
+   */
+  LazyWaterlineRescaler(Dag &g, NodeMap<DataType> &type,
+                        NodeMapOptional<std::uint32_t> &scale);
+
+  virtual ~LazyWaterlineRescaler() {}
+
+  /**
+   * @brief Operator overloading for traversing the DAG and inserting rescale
+   * nodes before multiplications and outputs.
+   */
+  void operator()(NodePtr &node);
+};
+
+}  // namespace iyfc
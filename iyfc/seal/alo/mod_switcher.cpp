@@ -21,6 +21,9 @@
  * SOFTWARE.
  */
 #include "mod_switcher.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <map>
 #include <vector>
 namespace iyfc {
@@ -106,10 +109,140 @@ void ModSwitcher::operator()(
   level[node] = node_level;
 }
 
-// Evaluate Bfv level
-bool BfvModSwitcher::isLevelAddOp(const OpType &op_code) {
-  return (op_code == OpType::Mul);
+std::uint32_t BfvModSwitcher::operator()(
+    BfvNoiseModel &model, std::size_t degree, std::uint32_t plain_bits,
+    const std::vector<std::uint32_t> &prime_bits) {
+  // The special prime is never dropped, the last data prime is kept
+  if (prime_bits.size() < 3) return 0;
+  std::size_t level_cnt = prime_bits.size() - 1;
+  // Data modulus bits after dropping l primes
+  std::vector<double> modulus_bits(level_cnt, 0);
+  for (std::size_t l = 0; l < level_cnt; l++) {
+    for (std::size_t i = 0; i + l < level_cnt; i++) {
+      modulus_bits[l] += prime_bits[i];
+    }
+  }
+
+  double log_n = std::log2(static_cast<double>(degree));
+  double log_t = plain_bits;
+  // Rounding noise of a switch, t * (1 + |s|_1) / 2 with a ternary key
+  double rounding = log_t + log_n;
+  const auto &nodes = model.getCipherNodes();
+  NodeMap<double> noise(dag);
+  model.getNodeNoiseBits(degree, plain_bits, noise);
+
+  // Budget each node has to leave for the operations after it
+  NodeMap<double> required(dag);
+  for (auto it = nodes.rbegin(); it != nodes.rend(); ++it) {
+    auto &node = *it;
+    double need = node->numUses() == 0 ? BFV_NOISE_MARGIN_BITS : 0;
+    for (auto &use : node->getUses()) {
+      if (use->m_op_type == OpType::Output) {
+        need = std::max(need, static_cast<double>(BFV_NOISE_MARGIN_BITS));
+        continue;
+      }
+      if (type[use] != DataType::Cipher) continue;
+      double growth = 0;
+      switch (use->m_op_type) {
+        case OpType::Mul: {
+          std::size_t cipher_cnt = 0;
+          for (auto &operand : use->getOperands()) {
+            if (type[operand] == DataType::Cipher) ++cipher_cnt;
+          }
+          growth = cipher_cnt > 1 ? log_t + log_n + 2 : log_t + log_n - 1;
+        } break;
+        case OpType::Add:
+        case OpType::Sub:
+          growth = 1;
+          break;
+        default:
+          break;
+      }
+      // Key switching noise is about t times below any ciphertext noise
+      need = std::max(need, required[use] + growth);
+    }
+    required[node] = need;
+  }
+
+  // Deepest level each node may be switched to, switching keeps the noise
+  // relative to the modulus and adds the rounding noise
+  NodeMap<std::uint32_t> max_level(dag);
+  for (auto &node : nodes) {
+    double relative = noise[node] - modulus_bits[0];
+    std::uint32_t deepest = 0;
+    for (std::size_t l = 1; l < level_cnt; l++) {
+      double budget = -addLog2(relative, rounding - modulus_bits[l]);
+      if (budget < required[node]) break;
+      deepest = l;
+    }
+    max_level[node] = deepest;
+  }
+
+  // Level each node computes at, operands are aligned down to it
+  NodeMap<std::uint32_t> level(dag);
+  for (auto &node : nodes) {
+    bool has_cipher = false;
+    std::uint32_t lowest = 0;
+    std::uint32_t allowed = std::numeric_limits<std::uint32_t>::max();
+    for (auto &operand : node->getOperands()) {
+      if (type[operand] != DataType::Cipher) continue;
+      has_cipher = true;
+      lowest = std::max(lowest, level[operand]);
+      allowed = std::min(allowed, max_level[operand]);
+    }
+    if (!has_cipher || node->m_op_type == OpType::Output) {
+      level[node] = lowest;
+    } else {
+      level[node] = std::max(lowest, allowed);
+    }
+  }
+
+  std::uint32_t inserted = 0;
+  for (auto &node : nodes) {
+    std::map<std::uint32_t, std::vector<NodePtr>> map_use_levels;
+    for (auto &use : node->getUses()) {
+      if (type[use] != DataType::Cipher && use->m_op_type != OpType::Output)
+        continue;
+      if (level[use] > level[node]) map_use_levels[level[use]].push_back(use);
+    }
+    auto temp = node;
+    auto temp_level = level[node];
+    for (auto &entry : map_use_levels) {  // min to max
+      while (temp_level < entry.first) {
+        temp = dag.makeNode(OpType::ModSwitch, {temp});
+        type[temp] = DataType::Cipher;
+        scale[temp] = scale[node];
+        ++temp_level;
+        ++inserted;
+      }
+      for (auto &use : entry.second) {
+        use->replaceOperand(node, temp);
+      }
+    }
+  }
+  return inserted;
 }
 
+std::uint32_t OutputModSwitcher::operator()(
+    const std::unordered_map<std::string, std::uint32_t> &drop_levels) {
+  std::uint32_t inserted = 0;
+  for (auto &entry : dag.getOutputs()) {
+    auto it = drop_levels.find(entry.first);
+    if (it == drop_levels.end() || it->second == 0) continue;
+    auto output = entry.second;
+    auto value = output->getOperands().at(0);
+    if (type[value] != DataType::Cipher) continue;
+
+    auto temp = value;
+    for (std::uint32_t i = 0; i < it->second; ++i) {
+      temp = dag.makeNode(OpType::ModSwitch, {temp});
+      type[temp] = DataType::Cipher;
+      scale[temp] = scale[value];
+      ++inserted;
+    }
+    output->replaceOperand(value, temp);
+  }
+  return inserted;
+}
 
 }  // namespace iyfc
@@ -21,6 +21,12 @@
  * SOFTWARE.
  */
 #pragma once
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "bfv_noise_model.h"
 #include "dag/iyfc_dag.h"
 #include "dag/node_map.h"
 
@@ -64,10 +70,19 @@ class ModSwitcher {
 
 /**
  * @class BfvModSwitcher
- * @brief ModSwitcher node insertion strategy based on level values with
- * different criteria for Bfv level evaluation. Overrides isLevelAddOp
+ * @brief Drops BFV data primes as soon as the noise budget allows
+ * @details Runs once the parameters are fixed. Every ciphertext node gets the
+ * budget its remaining computation needs, walking back from the outputs, and
+ * the deepest level whose modulus still leaves that budget after the
+ * rounding noise of switching. A node computes at the deepest level all of
+ * its ciphertext operands allow, and each operand is switched down to it
+ * through one mod_switch chain shared by all of its uses.
  */
-class BfvModSwitcher : public ModSwitcher {
+class BfvModSwitcher {
+  Dag &dag;
+  NodeMap<DataType> &type;
+  NodeMapOptional<std::uint32_t> &scale;
+
  public:
   /**
    * @brief BfvModSwitcher constructor
@@ -77,9 +92,49 @@ class BfvModSwitcher : public ModSwitcher {
    */
   BfvModSwitcher(Dag &g, NodeMap<DataType> &type,
                  NodeMapOptional<std::uint32_t> &scale)
-      : ModSwitcher(g, type, scale) {}
+      : dag(g), type(type), scale(scale) {}
 
-  virtual bool isLevelAddOp(const OpType &op_code);
+  /**
+   * @brief Insert the mod_switch nodes
+   * @param [in] model Noise model that traversed the dag
+   * @param [in] degree Polynomial modulus degree
+   * @param [in] plain_bits Plaintext modulus bits
+   * @param [in] prime_bits Coefficient modulus bits, special prime last
+   * @return Number of mod_switch nodes inserted
+   */
+  std::uint32_t operator()(BfvNoiseModel &model, std::size_t degree,
+                           std::uint32_t plain_bits,
+                           const std::vector<std::uint32_t> &prime_bits);
+};
+
+/**
+ * @class OutputModSwitcher
+ * @brief Insert mod_switch nodes in front of the outputs so that results are
+ * serialized without the primes their precision does not need
+ */
+class OutputModSwitcher {
+  Dag &dag;
+  NodeMap<DataType> &type;
+  NodeMapOptional<std::uint32_t> &scale;
+
+ public:
+  /**
+   * @brief OutputModSwitcher constructor
+   * @param [in] g dag
+   * @param [in] type Node data type
+   * @param [in] scale Node scales
+   */
+  OutputModSwitcher(Dag &g, NodeMap<DataType> &type,
+                    NodeMapOptional<std::uint32_t> &scale)
+      : dag(g), type(type), scale(scale) {}
+
+  /**
+   * @brief Switch each output down by its number of levels
+   * @param [in] drop_levels Output name to the number of levels to drop
+   * @return Number of mod_switch nodes inserted
+   */
+  std::uint32_t operator()(
+      const std::unordered_map<std::string, std::uint32_t> &drop_levels);
 };
 
 }  // namespace iyfc
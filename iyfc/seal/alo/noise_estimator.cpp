@@ -0,0 +1,270 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "noise_estimator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "bfv_noise_model.h"
+#include "daghandler/traversal_handler.h"
+#include "daghandler/type_handler.h"
+
+namespace iyfc {
+
+const double NO_ERROR = -std::numeric_limits<double>::infinity();
+// Largest SEAL prime
+const double MAX_PRIME_BITS = 60;
+
+static std::uint32_t ceilBits(double bits) {
+  if (std::isinf(bits) || bits <= 0) return 0;
+  return static_cast<std::uint32_t>(std::ceil(bits));
+}
+
+NoiseEstimator::NoiseEstimator(Dag &g)
+    : m_dag(g), m_types(g), m_levels(g), m_node_bits(g) {
+  TypeHandler infer(m_dag, m_types);
+  DagTraversal(m_dag).forwardPass([&](NodePtr &node) {
+    infer(node);
+    m_levels[node] = levelOf(node);
+    m_order.push_back(node);
+  });
+}
+
+std::uint32_t NoiseEstimator::levelOf(const NodePtr &node) {
+  switch (node->m_op_type) {
+    case OpType::Input:
+    case OpType::Encode:
+      return node->has<EncodeAtLevelAttr>() ? node->get<EncodeAtLevelAttr>()
+                                            : 0;
+    case OpType::ModSwitch:
+    case OpType::Rescale:
+      return m_levels[node->getOperands().at(0)] + 1;
+    default:
+      break;
+  }
+  std::uint32_t level = 0;
+  for (auto &operand : node->getOperands()) {
+    if (m_types[operand] == DataType::Raw) continue;
+    level = std::max(level, m_levels[operand]);
+  }
+  return level;
+}
+
+void NoiseEstimator::estimateCkks(const CKKSParameters &params,
+                                  std::uint32_t precision_bits,
+                                  NoiseReport &report) {
+  // |x| <= 1 without a declared range
+  BfvNoiseModel values(m_dag, m_types, 0);
+  for (auto &node : m_order) values(node);
+
+  double log_n = std::log2(static_cast<double>(params.poly_modulus_degree));
+  double fresh = log_n + FRESH_ERROR_BITS;
+  double rounding = 0.5 * log_n + 1;
+  NodeMap<double> scales(m_dag);
+  report.scale = 0;
+  for (auto &node : m_order) {
+    auto &operands = node->getOperands();
+    double scale = 0;
+    double error = NO_ERROR;
+    for (auto &operand : operands) {
+      scale = std::max(scale, scales[operand]);
+      error = addLog2(error, m_node_bits[operand]);
+    }
+    switch (node->m_op_type) {
+      case OpType::Input:
+        scale = node->get<EncodeAtScaleAttr>();
+        report.scale = std::max(report.scale, node->get<EncodeAtScaleAttr>());
+        error = (m_types[node] == DataType::Cipher ? fresh : rounding) - scale;
+        break;
+      case OpType::Constant:
+      case OpType::U32Constant:
+        scale = 0;
+        break;
+      case OpType::Encode:
+        scale = node->get<EncodeAtScaleAttr>();
+        error = addLog2(error, rounding - scale);
+        break;
+      case OpType::Mul: {
+        auto &lhs = operands.at(0);
+        auto &rhs = operands.at(1);
+        scale = scales[lhs] + scales[rhs];
+        error = addLog2(
+            addLog2(values.getValueBits(lhs) + m_node_bits[rhs],
+                    values.getValueBits(rhs) + m_node_bits[lhs]),
+            m_node_bits[lhs] + m_node_bits[rhs]);
+      } break;
+      case OpType::Rescale:
+        scale -= node->get<RescaleDivisorAttr>();
+        error = addLog2(error, rounding - scale);
+        break;
+      case OpType::Relinearize:
+      case OpType::RotateLeftConst:
+      case OpType::RotateRightConst:
+        error = addLog2(error, fresh - scale);
+        break;
+      default:
+        break;
+    }
+    scales[node] = scale;
+    m_node_bits[node] = error;
+  }
+
+  // How much the outputs amplify the error of each node, in log2, and the
+  // primes dropped between the node and the outputs
+  NodeMap<double> gains(m_dag);
+  NodeMap<std::uint32_t> drops(m_dag);
+  for (auto &node : m_order) gains[node] = NO_ERROR;
+  for (auto it = m_order.rbegin(); it != m_order.rend(); ++it) {
+    auto &node = *it;
+    auto &operands = node->getOperands();
+    if (node->m_op_type == OpType::Output) gains[node] = 0;
+    std::uint32_t drop = drops[node];
+    if (node->m_op_type == OpType::Rescale ||
+        node->m_op_type == OpType::ModSwitch) {
+      ++drop;
+    }
+    for (std::size_t i = 0; i < operands.size(); i++) {
+      auto &operand = operands[i];
+      double gain = gains[node];
+      if (node->m_op_type == OpType::Mul) {
+        gain += values.getValueBits(operands[1 - i]);
+      }
+      gains[operand] = std::max(gains[operand], gain);
+      drops[operand] = std::max(drops[operand], drop);
+    }
+  }
+
+  std::uint32_t data_primes = params.prime_bits.size() - 1;
+  report.primes = data_primes;
+  report.poly_modulus_degree = params.poly_modulus_degree;
+  report.min_scale = 0;
+  std::uint32_t output_primes = 0;
+  for (auto &entry : m_dag.getOutputs()) {
+    auto &node = entry.second;
+    NoiseEstimate estimate;
+    estimate.value_bits = values.getValueBits(node);
+    estimate.noise_bits = m_node_bits[node];
+    if (!std::isinf(estimate.noise_bits)) {
+      // The error follows the scales
+      estimate.min_scale =
+          ceilBits(report.scale + estimate.noise_bits + precision_bits);
+    }
+    estimate.primes = data_primes - std::min(data_primes, m_levels[node]);
+    // The output scale follows the input scale
+    double output_scale =
+        scales[node] + static_cast<double>(estimate.min_scale) - report.scale;
+    estimate.min_primes = ceilBits(
+        (std::max(estimate.value_bits, 0.0) + output_scale + 1) /
+        MAX_PRIME_BITS);
+    report.min_scale = std::max(report.min_scale, estimate.min_scale);
+    output_primes = std::max(output_primes, estimate.min_primes);
+    report.outputs[entry.first] = estimate;
+  }
+
+  report.min_primes = output_primes;
+  for (auto &entry : m_dag.getInputs()) {
+    auto &node = entry.second;
+    NoiseEstimate estimate;
+    estimate.value_bits = values.getValueBits(node);
+    estimate.noise_bits = m_node_bits[node];
+    if (!std::isinf(gains[node])) {
+      // Half of the error budget for the input, the rest for the operations
+      double base = m_types[node] == DataType::Cipher ? fresh : rounding;
+      estimate.min_scale = ceilBits(base + gains[node] + precision_bits + 1);
+    }
+    estimate.primes = data_primes - std::min(data_primes, m_levels[node]);
+    estimate.min_primes = drops[node] + output_primes;
+    report.min_primes = std::max(report.min_primes, estimate.min_primes);
+    report.inputs[entry.first] = estimate;
+  }
+}
+
+void NoiseEstimator::estimateBfv(const BfvParameters &params,
+                                 NoiseReport &report) {
+  BfvNoiseModel model(m_dag, m_types);
+  for (auto &node : m_order) model(node);
+  NodeMap<double> noise(m_dag);
+  model.getNodeNoiseBits(params.poly_modulus_degree, params.plain_modulus,
+                         noise);
+
+  // Data modulus bits after dropping l primes
+  std::uint32_t data_primes = params.prime_bits.size() - 1;
+  std::vector<double> modulus_bits(data_primes, 0);
+  for (std::uint32_t l = 0; l < data_primes; l++) {
+    for (std::uint32_t i = 0; i + l < data_primes; i++) {
+      modulus_bits[l] += params.prime_bits[i];
+    }
+  }
+  double log_n = std::log2(static_cast<double>(params.poly_modulus_degree));
+  double rounding = params.plain_modulus + log_n;
+  for (auto &node : m_order) {
+    if (m_types[node] != DataType::Cipher) {
+      m_node_bits[node] = 0;
+      continue;
+    }
+    auto level = std::min(m_levels[node], data_primes - 1);
+    // Switching keeps the noise relative to the modulus, plus rounding
+    double relative = noise[node] - modulus_bits[0];
+    if (level > 0) {
+      relative = addLog2(relative, rounding - modulus_bits[level]);
+    }
+    // SEAL counts the bits left until the noise reaches half the modulus
+    m_node_bits[node] = std::max(0.0, -relative - 1);
+  }
+
+  report.scale = params.plain_modulus;
+  report.primes = data_primes;
+  report.poly_modulus_degree = params.poly_modulus_degree;
+  report.min_scale = model.getPlainBits(m_dag.getOutputRanges());
+  if (report.min_scale == 0) report.min_scale = params.plain_modulus;
+  report.min_primes = 0;
+  for (auto &entry : m_dag.getOutputs()) {
+    auto &node = entry.second;
+    NoiseEstimate estimate;
+    estimate.value_bits = model.getValueBits(node);
+    estimate.noise_bits = m_node_bits[node];
+    estimate.min_scale = std::isinf(estimate.value_bits)
+                             ? params.plain_modulus
+                             : ceilBits(estimate.value_bits) + 2;
+    estimate.primes = data_primes - std::min(data_primes, m_levels[node]);
+    estimate.min_primes =
+        ceilBits((noise[node] + BFV_NOISE_MARGIN_BITS) / MAX_PRIME_BITS);
+    report.min_primes = std::max(report.min_primes, estimate.min_primes);
+    report.outputs[entry.first] = estimate;
+  }
+  for (auto &entry : m_dag.getInputs()) {
+    auto &node = entry.second;
+    NoiseEstimate estimate;
+    estimate.value_bits = model.getValueBits(node);
+    estimate.noise_bits = m_node_bits[node];
+    estimate.min_scale = std::isinf(estimate.value_bits)
+                             ? params.plain_modulus
+                             : ceilBits(estimate.value_bits) + 2;
+    estimate.primes = data_primes - std::min(data_primes, m_levels[node]);
+    estimate.min_primes = report.min_primes;
+    report.inputs[entry.first] = estimate;
+  }
+}
+
+}  // namespace iyfc
@@ -0,0 +1,88 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "bfv_parameters.h"
+#include "ckks_parameters.h"
+#include "comm_include.h"
+#include "dag/iyfc_dag.h"
+#include "dag/node_map.h"
+
+namespace iyfc {
+
+/**
+ * @class NoiseEstimator
+ * @brief Static noise and precision estimate of a compiled SEAL DAG
+ * @details CKKS bounds the absolute error of every value in log2: fresh
+ * encryptions and key switches add about N * 6 sigma, encoding and rescaling
+ * add their rounding, each divided by the scale of the value, and products
+ * multiply the error of one operand by the bound of the other. Inputs
+ * without a declared range are assumed within [-1, 1]. BFV takes the noise
+ * of BfvNoiseModel, the budget of a node is what its data primes keep above
+ * the noise, as SEAL's invariant_noise_budget. Input recommendations come
+ * from how much the outputs amplify the error of each input.
+ */
+class NoiseEstimator {
+ public:
+  /**
+   * @brief NoiseEstimator constructor, infers the node types
+   * @param [in] g Compiled DAG
+   */
+  NoiseEstimator(Dag &g);
+
+  /**
+   * @brief Estimate the error of a CKKS DAG
+   * @param [in] params Encryption parameters the DAG was compiled with
+   * @param [in] precision_bits Output precision the scales should meet
+   * @param [out] report Inputs, outputs and recommended scale and chain
+   */
+  void estimateCkks(const CKKSParameters &params, std::uint32_t precision_bits,
+                    NoiseReport &report);
+
+  /**
+   * @brief Estimate the noise budget of a BFV DAG
+   * @param [in] params Encryption parameters the DAG was compiled with
+   * @param [out] report Inputs, outputs and recommended plaintext modulus
+   * and chain
+   */
+  void estimateBfv(const BfvParameters &params, NoiseReport &report);
+
+  /**
+   * @brief Estimate of one node after estimateCkks or estimateBfv, CKKS log2
+   * error bound or BFV noise budget
+   */
+  double getNodeBits(const NodePtr &node) const { return m_node_bits[*node]; }
+
+ private:
+  Dag &m_dag;
+  NodeMap<DataType> m_types;
+  NodeMap<std::uint32_t> m_levels;  // primes dropped
+  NodeMap<double> m_node_bits;
+  std::vector<NodePtr> m_order;  // forward order
+
+  std::uint32_t levelOf(const NodePtr &node);
+};
+
+}  // namespace iyfc
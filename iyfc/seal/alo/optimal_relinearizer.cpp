@@ -0,0 +1,263 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "optimal_relinearizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <queue>
+
+#include "daghandler/traversal_handler.h"
+
+namespace iyfc {
+
+namespace {
+
+// Max flow by Dinic, the source side of the min cut is what the source
+// still reaches once no augmenting path is left
+class MinCutGraph {
+ public:
+  static constexpr std::int64_t INF =
+      std::numeric_limits<std::int64_t>::max() / 2;
+
+  explicit MinCutGraph(std::size_t size)
+      : m_adj(size), m_level(size), m_next(size) {}
+
+  void addEdge(std::size_t from, std::size_t to, std::int64_t cap) {
+    m_adj[from].push_back(m_edges.size());
+    m_edges.push_back({to, cap});
+    m_adj[to].push_back(m_edges.size());
+    m_edges.push_back({from, 0});
+  }
+
+  std::int64_t maxFlow(std::size_t source, std::size_t sink) {
+    std::int64_t flow = 0;
+    while (buildLevels(source, sink)) {
+      std::fill(m_next.begin(), m_next.end(), 0);
+      while (std::int64_t pushed = augment(source, sink)) flow += pushed;
+    }
+    return flow;
+  }
+
+  bool onSourceSide(std::size_t node) const { return m_level[node] >= 0; }
+
+ private:
+  struct Edge {
+    std::size_t to;
+    std::int64_t cap;
+  };
+
+  bool buildLevels(std::size_t source, std::size_t sink) {
+    std::fill(m_level.begin(), m_level.end(), -1);
+    std::queue<std::size_t> queue;
+    m_level[source] = 0;
+    queue.push(source);
+    while (!queue.empty()) {
+      auto node = queue.front();
+      queue.pop();
+      for (auto e : m_adj[node]) {
+        auto &edge = m_edges[e];
+        if (edge.cap > 0 && m_level[edge.to] < 0) {
+          m_level[edge.to] = m_level[node] + 1;
+          queue.push(edge.to);
+        }
+      }
+    }
+    return m_level[sink] >= 0;
+  }
+
+  // One blocking-flow path, iterative as the path can be as long as the DAG
+  std::int64_t augment(std::size_t source, std::size_t sink) {
+    std::vector<std::size_t> path;  // edges taken from the source
+    std::size_t node = source;
+    while (node != sink) {
+      auto &i = m_next[node];
+      while (i < m_adj[node].size()) {
+        auto &edge = m_edges[m_adj[node][i]];
+        if (edge.cap > 0 && m_level[edge.to] == m_level[node] + 1) break;
+        i++;
+      }
+      if (i < m_adj[node].size()) {
+        path.push_back(m_adj[node][i]);
+        node = m_edges[path.back()].to;
+        continue;
+      }
+      // Dead end, the parent moves on to its next edge
+      if (path.empty()) return 0;
+      node = m_edges[path.back() ^ 1].to;
+      path.pop_back();
+      m_next[node]++;
+    }
+    std::int64_t pushed = INF;
+    for (auto e : path) pushed = std::min(pushed, m_edges[e].cap);
+    for (auto e : path) {
+      m_edges[e].cap -= pushed;
+      m_edges[e ^ 1].cap += pushed;
+    }
+    return pushed;
+  }
+
+  std::vector<Edge> m_edges;
+  std::vector<std::vector<std::size_t>> m_adj;
+  std::vector<std::int64_t> m_level;
+  std::vector<std::size_t> m_next;  // first edge left to try per node
+};
+
+}  // namespace
+
+OptimalRelinearizer::OptimalRelinearizer(Dag &g, NodeMap<DataType> &type,
+                                         NodeMapOptional<std::uint32_t> &scale)
+    : dag(g), type(type), scale(scale) {}
+
+bool OptimalRelinearizer::isEncryptedMultOp(const NodePtr &node) {
+  if (node->m_op_type != OpType::Mul) return false;
+  for (auto &operand : node->getOperands()) {
+    assert(type[operand] != DataType::Undef);
+    if (type[operand] != DataType::Cipher) return false;
+  }
+  return true;
+}
+
+bool OptimalRelinearizer::needsTwoParts(const NodePtr &use) {
+  return isEncryptedMultOp(use) || use->m_op_type == OpType::RotateLeftConst ||
+         use->m_op_type == OpType::RotateRightConst ||
+         use->m_op_type == OpType::Output;
+}
+
+std::uint32_t OptimalRelinearizer::countLazy(
+    const std::vector<NodePtr> &nodes) {
+  NodeMap<bool> pending(dag);
+  std::uint32_t cnt = 0;
+  for (auto &node : nodes) {
+    if (node->numOperands() == 0 || node->numUses() == 0) continue;
+    if (!isEncryptedMultOp(node) && !pending[node]) continue;
+    bool must_insert = false;
+    auto first_use = node->getUses()[0];
+    for (auto &use : node->getUses()) {
+      if (needsTwoParts(use) || use != first_use) must_insert = true;
+    }
+    if (must_insert) {
+      ++cnt;
+    } else {
+      for (auto &use : node->getUses()) pending[use] = true;
+    }
+  }
+  return cnt;
+}
+
+std::uint32_t OptimalRelinearizer::operator()() {
+  std::vector<NodePtr> nodes;
+  auto dag_traverse = DagTraversal(dag);
+  dag_traverse.forwardPass(
+      [&](const NodePtr &node) { nodes.push_back(node); });
+  m_lazy_cnt = countLazy(nodes);
+  m_relin_cnt = 0;
+
+  // Values that can have three parts, in forward order. Value i is flow
+  // node 2 * i + 2, its auxiliary node 2 * i + 3.
+  std::vector<NodePtr> values;
+  NodeMap<std::size_t> id(dag);  // 1 + index in values, 0 for none
+  for (auto &node : nodes) {
+    if (type[node] != DataType::Cipher ||
+        node->m_op_type == OpType::Relinearize) {
+      continue;
+    }
+    bool three_parts = isEncryptedMultOp(node);
+    if (!three_parts && !needsTwoParts(node)) {
+      for (auto &operand : node->getOperands()) {
+        if (id[operand] != 0) three_parts = true;
+      }
+    }
+    if (three_parts) {
+      values.push_back(node);
+      id[node] = values.size();
+    }
+  }
+  if (values.empty()) return 0;
+
+  const std::size_t source = 0;
+  const std::size_t sink = 1;
+  MinCutGraph graph(2 * values.size() + 2);
+  for (std::size_t i = 0; i < values.size(); i++) {
+    auto &value = values[i];
+    if (isEncryptedMultOp(value)) {
+      graph.addEdge(source, 2 * i + 2, MinCutGraph::INF);
+    }
+    graph.addEdge(2 * i + 2, 2 * i + 3, 1);
+    for (auto &use : value->getUses()) {
+      if (use->m_op_type == OpType::Relinearize) continue;
+      if (needsTwoParts(use) || id[use] == 0) {
+        graph.addEdge(2 * i + 3, sink, MinCutGraph::INF);
+      } else {
+        graph.addEdge(2 * i + 3, 2 * (id[use] - 1) + 2, MinCutGraph::INF);
+      }
+    }
+  }
+  graph.maxFlow(source, sink);
+
+  // A value on the source side keeps three parts for its uses there, a cut
+  // value is relinearized for the others
+  auto onSourceSide = [&](const NodePtr &node) {
+    return id[node] != 0 && graph.onSourceSide(2 * (id[node] - 1) + 2);
+  };
+  auto isCut = [&](const NodePtr &node) {
+    return onSourceSide(node) &&
+           !graph.onSourceSide(2 * (id[node] - 1) + 3);
+  };
+  auto readsRelinearized = [&](const NodePtr &value, const NodePtr &use) {
+    return isCut(value) && (needsTwoParts(use) || !onSourceSide(use));
+  };
+
+  // Values that really have three parts, others on the source side are
+  // left alone
+  NodeMap<bool> three_parts(dag);
+  for (auto &value : values) {
+    bool three = isEncryptedMultOp(value);
+    for (auto &operand : value->getOperands()) {
+      if (three_parts[operand] && !readsRelinearized(operand, value)) {
+        three = true;
+      }
+    }
+    three_parts[value] = three;
+  }
+
+  for (auto &value : values) {
+    if (!three_parts[value]) continue;
+    std::vector<NodePtr> relin_uses;
+    for (auto &use : value->getUses()) {
+      if (use->m_op_type == OpType::Relinearize) continue;
+      assert(!needsTwoParts(use) || readsRelinearized(value, use));
+      if (readsRelinearized(value, use)) relin_uses.push_back(use);
+    }
+    if (relin_uses.empty()) continue;
+
+    auto relin_node = dag.makeNode(OpType::Relinearize, {value});
+    ++m_relin_cnt;
+    type[relin_node] = type[value];
+    scale[relin_node] = scale[value];
+    for (auto &use : relin_uses) use->replaceOperand(value, relin_node);
+  }
+  return m_relin_cnt;
+}
+
+}  // namespace iyfc
@@ -0,0 +1,97 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "dag/iyfc_dag.h"
+#include "dag/node_map.h"
+
+namespace iyfc {
+
+/**
+ * @class OptimalRelinearizer
+ * @brief Places the fewest relinearizations the DAG needs
+ * @details A product of two ciphertexts has three parts. Additions, plain
+ * multiplications, negations, rescales and mod switches accept it, while
+ * ciphertext products, rotations and outputs need two parts. Whether each
+ * value stays at three parts is a labeling whose cost is one
+ * relinearization per value that has three parts and a use with two, a
+ * min cut over the DAG. Every value has a unit edge to an auxiliary node
+ * with unbounded edges to its uses, so a value pays once however many of
+ * its uses need two parts. Unlike LazyRelinearizer, which relinearizes a
+ * value as soon as it has several uses, sums that share products keep
+ * three parts until they are needed.
+ */
+class OptimalRelinearizer {
+  Dag &dag;
+  NodeMap<DataType> &type;
+  NodeMapOptional<std::uint32_t> &scale;
+  std::uint32_t m_relin_cnt = 0;
+  std::uint32_t m_lazy_cnt = 0;
+
+  bool isEncryptedMultOp(const NodePtr &node);
+
+  /**
+   * @brief Whether a use needs its operands relinearized
+   */
+  bool needsTwoParts(const NodePtr &use);
+
+  /**
+   * @brief Relinearizations the greedy rule of LazyRelinearizer inserts
+   */
+  std::uint32_t countLazy(const std::vector<NodePtr> &nodes);
+
+ public:
+  /**
+   * @brief OptimalRelinearizer constructor
+   * @param [in] g DAG
+   * @param [in] type Node data types
+   * @param [in] scale Node scales
+   */
+  OptimalRelinearizer(Dag &g, NodeMap<DataType> &type,
+                      NodeMapOptional<std::uint32_t> &scale);
+
+  /**
+   * @brief Insert the relinearize nodes
+   * @return Number of relinearize nodes inserted
+   */
+  std::uint32_t operator()();
+
+  std::uint32_t getRelinCnt() const { return m_relin_cnt; }
+
+  /**
+   * @brief Relinearizations LazyRelinearizer would insert
+   */
+  std::uint32_t getLazyCnt() const { return m_lazy_cnt; }
+
+  /**
+   * @brief Relinearizations saved against LazyRelinearizer, 0 when the
+   * greedy placement needs no more
+   */
+  std::uint32_t getSavedCnt() const {
+    return m_lazy_cnt > m_relin_cnt ? m_lazy_cnt - m_relin_cnt : 0;
+  }
+};
+
+}  // namespace iyfc
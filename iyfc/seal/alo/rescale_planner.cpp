@@ -0,0 +1,151 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "rescale_planner.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "ckks_parameter_search.h"
+#include "daghandler/traversal_handler.h"
+
+namespace iyfc {
+
+RescalePlanner::RescalePlanner(Dag &g, NodeMap<DataType> &types,
+                               NodeMapOptional<std::uint32_t> &scales)
+    : m_dag(g), m_types(types), m_scales(scales) {
+  for (auto &source : m_dag.getSources()) {
+    m_min_scale = std::max(m_min_scale, m_scales[source]);
+  }
+  m_fixed_rescale = m_dag.m_scale;
+}
+
+RescaleReport RescalePlanner::plan(RESCALE_STRATEGY strategy) {
+  RescaleReport report;
+  report.strategy = strategy;
+  const bool lazy = strategy == LAZY_RESCALE;
+  const std::uint32_t waterline = m_fixed_rescale + m_min_scale;
+
+  NodeMap<std::uint32_t> scale(m_dag);
+  NodeMap<std::uint32_t> level(m_dag);  // primes dropped before the value
+  // Lazy: the shared rescaled copy of a value above the waterline
+  NodeMap<bool> rescaled(m_dag);
+  NodeMap<std::uint32_t> down_scale(m_dag);
+  NodeMap<std::uint32_t> down_level(m_dag);
+  CkksParameterSearch search(m_dag, m_types);
+
+  auto isCipher = [&](const NodePtr &node) {
+    return m_types[node] == DataType::Cipher;
+  };
+  // Rescale a value until it is below the waterline
+  auto rescaleDown = [&](const NodePtr &node, std::uint32_t &node_scale,
+                         std::uint32_t &node_level) {
+    while (node_scale >= waterline) {
+      if (isCipher(node)) {
+        search.countOp(OpType::Rescale, false, node_level);
+      }
+      ++report.rescales;
+      ++node_level;
+      node_scale -= m_fixed_rescale;
+    }
+  };
+
+  auto dag_traverse = DagTraversal(m_dag);
+  dag_traverse.forwardPass([&](const NodePtr &node) {
+    if (node->numOperands() == 0) {
+      scale[node] = m_scales.has(node) ? m_scales.at(node) : 0;
+      level[node] = 0;
+      return;
+    }
+    const auto op = node->m_op_type;
+    const bool is_mul = op == OpType::Mul;
+
+    // Operand scales and levels as the node sees them
+    std::vector<std::uint32_t> op_scales;
+    std::vector<std::uint32_t> op_levels;
+    bool plain_operand = false;
+    for (auto &operand : node->getOperands()) {
+      std::uint32_t op_scale = scale[operand];
+      std::uint32_t op_level = level[operand];
+      if (lazy && (is_mul || op == OpType::Output) &&
+          m_types[operand] != DataType::Raw && op_scale >= waterline) {
+        if (!rescaled[operand]) {
+          rescaleDown(operand, op_scale, op_level);
+          down_scale[operand] = op_scale;
+          down_level[operand] = op_level;
+          rescaled[operand] = true;
+        }
+        op_scale = down_scale[operand];
+        op_level = down_level[operand];
+      }
+      op_scales.push_back(op_scale);
+      op_levels.push_back(op_level);
+      plain_operand = plain_operand || !isCipher(operand);
+    }
+    std::uint32_t node_level =
+        *std::max_element(op_levels.begin(), op_levels.end());
+
+    if (m_types[node] == DataType::Raw) {
+      scale[node] = *std::max_element(op_scales.begin(), op_scales.end());
+      level[node] = node_level;
+      return;
+    }
+
+    std::uint32_t node_scale = op_scales[0];
+    if (op == OpType::Rescale) {
+      node_scale -= node->get<RescaleDivisorAttr>();
+      ++node_level;
+    } else if (is_mul) {
+      node_scale = 0;
+      for (auto op_scale : op_scales) node_scale += op_scale;
+    } else if (op == OpType::Add || op == OpType::Sub) {
+      node_scale = *std::max_element(op_scales.begin(), op_scales.end());
+      std::size_t i = 0;
+      for (auto &operand : node->getOperands()) {
+        if (op_scales[i] < node_scale && m_types[operand] != DataType::Raw) {
+          ++report.scale_ups;
+          if (isCipher(operand)) {
+            search.countOp(OpType::Encode, false, op_levels[i]);
+            search.countOp(OpType::Mul, true, op_levels[i]);
+          }
+        }
+        ++i;
+      }
+    }
+    if (isCipher(node)) search.countOp(op, plain_operand, node_level);
+    if (is_mul && !lazy) rescaleDown(node, node_scale, node_level);
+    scale[node] = node_scale;
+    level[node] = node_level;
+  });
+
+  for (auto &output : m_dag.getOutputs()) {
+    report.chain_length = std::max(report.chain_length, level[output.second]);
+  }
+  CkksChain chain;
+  chain.output_primes.push_back(m_fixed_rescale);
+  chain.rescale_primes.assign(report.chain_length, m_fixed_rescale);
+  chain.special_prime = m_fixed_rescale;
+  report.cost = search.cost(2 * m_dag.getVecSize(), chain);
+  return report;
+}
+
+}  // namespace iyfc
@@ -0,0 +1,69 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#include <cstdint>
+
+#include "comm_include.h"
+#include "dag/data_type.h"
+#include "dag/iyfc_dag.h"
+#include "dag/node_map.h"
+
+namespace iyfc {
+
+/**
+ * @class RescalePlanner
+ * @brief Predicts what a rescale strategy inserts, without rewriting the DAG
+ * @details Replays the scale rules of EagerWaterlineRescaler or
+ * LazyWaterlineRescaler over the typed DAG, counting the rescales, the
+ * scale ups of addition operands and the primes dropped before each
+ * ciphertext op. The cost comes from the latency model of
+ * CkksParameterSearch with one output prime at the vector size degree, so
+ * it only ranks strategies against each other.
+ */
+class RescalePlanner {
+ public:
+  /**
+   * @brief RescalePlanner constructor
+   * @param [in] g DAG, with constants already scaled
+   * @param [in] types Node data types
+   * @param [in] scales Node scales, set for the sources
+   */
+  RescalePlanner(Dag &g, NodeMap<DataType> &types,
+                 NodeMapOptional<std::uint32_t> &scales);
+
+  /**
+   * @brief Predict a strategy
+   * @param [in] strategy EAGER_RESCALE or LAZY_RESCALE
+   * @return Rescales, scale ups, chain length and cost of the strategy
+   */
+  RescaleReport plan(RESCALE_STRATEGY strategy);
+
+ private:
+  Dag &m_dag;
+  NodeMap<DataType> &m_types;
+  NodeMapOptional<std::uint32_t> &m_scales;
+  std::uint32_t m_min_scale = 0;
+  std::uint32_t m_fixed_rescale = DEFAULT_SCALE;
+};
+
+}  // namespace iyfc
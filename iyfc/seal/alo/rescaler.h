@@ -21,9 +21,12 @@
  * SOFTWARE.
  */
 #pragma once
+#include <cassert>
+
 #include "dag/data_type.h"
 #include "dag/iyfc_dag.h"
 #include "dag/node_map.h"
+#include "util/logging.h"
 
 namespace iyfc {
 
@@ -75,6 +78,37 @@ class Rescaler {
     right_node->replaceOperand(left_node, rescale_node);
   }
 
+  // Scale up the lower operands of an addition with a constant 1, scale
+  // constraint + - ==
+  void matchAdditionScales(NodePtr &node) {
+    auto max_scale = scale[node];
+    for (auto &operand : node->getOperands()) {
+      if (scale[operand] > max_scale) max_scale = scale[operand];
+    }
+
+    for (auto &operand : node->getOperands()) {
+      if (scale[operand] < max_scale && type[operand] != DataType::Raw) {
+        LOG(LOGLEVEL::Trace,
+            "Scaling up t%i from scale %i to match other addition operands "
+            "at scale %i",
+            operand->m_index, scale[operand], max_scale);
+
+        auto scale_constant = node->m_dag->makeUniformConstant(1);
+        dag.updateGroupIndex();
+        scale[scale_constant] = max_scale - scale[operand];
+        scale_constant->set<EncodeAtScaleAttr>(scale[scale_constant]);
+
+        auto mul_node = dag.makeNode(OpType::Mul, {operand, scale_constant});
+        scale[mul_node] = max_scale;
+        node->replaceOperand(operand, mul_node);
+      }
+    }
+    for (auto &operand : node->getOperands()) {
+      assert(max_scale == scale[operand] || type[operand] == DataType::Raw);
+    }
+    scale[node] = max_scale;
+  }
+
   //raw node takes the maximum scale of the op
   void handleRawScale(NodePtr node) {
     if (node->numOperands() > 0) {
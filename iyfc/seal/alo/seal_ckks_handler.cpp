@@ -30,35 +30,60 @@ int SealCkksHandler::dagTranspile(Dag &input_dag) { return transpile(input_dag);
 
 void SealCkksHandler::transform(Dag &dag, NodeMap<DataType> &types,
                                 NodeMapOptional<std::uint32_t> &scales) {
+  PassScope scope(dag, "SealCkksHandler::transform");
   auto dag_rewrite = DagTraversal(dag);
-  // Type inference pass
-  dag_rewrite.forwardPass(TypeHandler(dag, types));
+  // Type inference, later updates only retype the rewritten nodes
+  TypeInference inference(dag, types);
+  inference.update();
   // Precompute constant data nodes
   dag_rewrite.forwardPass(ConstantDoubleHandler(dag, scales));
-  // rescale
-  dag_rewrite.forwardPass(EagerWaterlineRescaler(dag, types, scales));
-  LOG(LOGLEVEL::Debug, "Running EagerWaterlineRescaler pass");
+  // rescale, with the strategy of lower predicted cost unless one is set
+  RescalePlanner planner(dag, types, scales);
+  RescaleReport eager = planner.plan(EAGER_RESCALE);
+  RescaleReport lazy = planner.plan(LAZY_RESCALE);
+  auto strategy = dag.getRescaleStrategy();
+  RescaleReport report =
+      strategy == LAZY_RESCALE ||
+              (strategy == AUTO_RESCALE && lazy.cost < eager.cost)
+          ? lazy
+          : eager;
+  report.eager_cost = eager.cost;
+  report.lazy_cost = lazy.cost;
+  if (report.strategy == LAZY_RESCALE) {
+    dag_rewrite.forwardPass(LazyWaterlineRescaler(dag, types, scales));
+  } else {
+    dag_rewrite.forwardPass(EagerWaterlineRescaler(dag, types, scales));
+  }
+  dag.setRescaleReport(report);
+  LOG(LOGLEVEL::Debug,
+      "Running %s rescaler: %u rescales, %u scale ups, chain length %u, "
+      "predicted cost %.3g (eager %.3g, lazy %.3g)",
+      report.strategy == LAZY_RESCALE ? "lazy" : "eager", report.rescales,
+      report.scale_ups, report.chain_length, report.cost, eager.cost,
+      lazy.cost);
 
-  // Type inference pass
-  dag_rewrite.forwardPass(TypeHandler(dag, types));
+  inference.update();
 
   // Insert encode nodes
   dag_rewrite.forwardPass(EncodeInserter(dag, types, scales));
 
-  // Type inference pass
-  dag_rewrite.forwardPass(TypeHandler(dag, types));
+  inference.update();
 
-  // Relinearization pass
-  dag_rewrite.forwardPass(LazyRelinearizer(dag, types, scales));
+  // Relinearization pass, fewest relinearizations by a min cut
+  OptimalRelinearizer relinearizer(dag, types, scales);
+  auto relin_cnt = relinearizer();
+  LOG(LOGLEVEL::Debug,
+      "OptimalRelinearizer inserted %u relinearize nodes, %u fewer than "
+      "LazyRelinearizer",
+      relin_cnt, relinearizer.getSavedCnt());
+  dag.setRelinReport(RelinReport{relin_cnt, relinearizer.getLazyCnt()});
 
-  // Type inference pass
-  dag_rewrite.forwardPass(TypeHandler(dag, types));
+  inference.update();
 
   // Mod-switch strategy
   dag_rewrite.backwardPass(ModSwitcher(dag, types, scales));
 
-  // Type inference pass
-  dag_rewrite.forwardPass(TypeHandler(dag, types));
+  inference.update();
 
   // SEAL lowering pass
   dag_rewrite.forwardPass(SEALLowering(dag, types));
@@ -66,49 +91,35 @@ void SealCkksHandler::transform(Dag &dag, NodeMap<DataType> &types,
 
 void SealCkksHandler::validate(Dag &dag, NodeMap<DataType> &types,
                                NodeMapOptional<std::uint32_t> &scales) {
+  PassScope scope(dag, "SealCkksHandler::validate");
   auto dag_traverse = DagTraversal(dag);
 
-  // update types
-  dag_traverse.forwardPass(TypeHandler(dag, types));
+  // Read-only passes, run in one traversal after typing each node
+  TypeHandler infer(dag, types);
   LevelsChecker lc(dag, types);
-  dag_traverse.forwardPass(lc);
-  try {
-    LOG(LOGLEVEL::Debug, "Running ParameterChecker pass");
-    ParameterChecker pc(dag, types);
-    dag_traverse.forwardPass(pc);
-  } catch (const InconsistentParameters &e) {
+  ParameterChecker pc(dag, types);
+  ScalesChecker sc(dag, scales, types);
+  bool params_consistent = true;
+  dag_traverse.forwardPass([&](NodePtr &node) {
+    infer(node);
+    lc(node);
+    if (params_consistent) {
+      try {
+        pc(node);
+      } catch (const InconsistentParameters &e) {
+        params_consistent = false;
+      }
+    }
+    sc(node);
+  });
+  if (!params_consistent) {
     warn(
         "The current rescaler produced inconsistent parameters. This is a "
         "bug, as this rescaler should be able to handle all programs.");
   }
-  LOG(LOGLEVEL::Debug, "Running ScalesChecker pass");
-  ScalesChecker sc(dag, scales, types);
-  dag_traverse.forwardPass(sc);
-}
-
-std::size_t SealCkksHandler::getMinDegreeForBitCount(
-    int (*MaxBitsFun)(std::size_t), int bit_cnt) {
-  std::size_t degree = 1024;
-  int max_bits_seen = 0;
-  while (true) {
-    auto max_bits_for_degree = MaxBitsFun(degree);
-    max_bits_seen = std::max(max_bits_seen, max_bits_for_degree);
-    //==0 Failed to check parameter table
-    if (max_bits_for_degree == 0) {
-      warn(
-          "Dag requires a %u bit modulus, but parameters are available for a "
-          "maximum of %u ",
-          bit_cnt, max_bits_seen);
-      throw std::logic_error("in seal ckks, err bit modulus!");
-    }
-    if (max_bits_for_degree >= bit_cnt) {
-      return degree;
-    }
-    degree *= 2;
-  }
 }
 
-void SealCkksHandler::extractSignature(const Dag &dag) {
+void SealCkksHandler::extractSignature(Dag &dag) {
   std::unordered_map<std::string, SealEncodingInfo> inputs;
 
   for (auto &input : dag.getInputs()) {
@@ -118,20 +129,43 @@ void SealCkksHandler::extractSignature(const Dag &dag) {
     inputs.emplace(
         input.first,
         SealEncodingInfo(type, input.second->get<EncodeAtScaleAttr>(),
-                         input.second->get<EncodeAtLevelAttr>()));
+                         input.second->get<EncodeAtLevelAttr>(),
+                         input.second->has<ComplexAttr>()));
   }
-  m_signature = std::make_shared<SealSignature>(
-      SealSignature(dag.getVecSize(), std::move(inputs)));
+
+  // Outputs reachable from a complex input carry complex slots
+  std::unordered_set<std::string> complex_outputs;
+  if (dag.m_has_complex) {
+    NodeMap<bool> is_complex(dag);
+    auto dag_traverse = DagTraversal(dag);
+    dag_traverse.forwardPass([&](const NodePtr &node) {
+      bool complex_node = node->has<ComplexAttr>();
+      for (auto &operand : node->getOperands()) {
+        complex_node = complex_node || is_complex[operand];
+      }
+      is_complex[node] = complex_node;
+    });
+    for (auto &output : dag.getOutputs()) {
+      if (is_complex[output.second]) complex_outputs.insert(output.first);
+    }
+  }
+  m_signature = std::make_shared<SealSignature>(SealSignature(
+      dag.getVecSize(), std::move(inputs), std::move(complex_outputs)));
 }
 
 int SealCkksHandler::determineEncryptionParameters(
     Dag &dag, NodeMapOptional<std::uint32_t> &scales, NodeMap<DataType> types) {
   auto dag_traverse = DagTraversal(dag);
   EncryptionParametersSelector eps(dag, scales, types);
-  dag_traverse.forwardPass(eps);
   // Rotate key selector
   RotationKeys rks(dag, types);
-  dag_traverse.forwardPass(rks);
+  // Op counts for the latency model of the parameter search
+  CkksParameterSearch search(dag, types);
+  dag_traverse.forwardPass([&](const NodePtr &node) {
+    eps(node);
+    rks(node);
+    search(node);
+  });
   // LOG(LOGLEVEL::Debug, "\n after EncryptionParametersSelector %s \n",
   // dag.toDOT().c_str());
 
@@ -139,32 +173,20 @@ int SealCkksHandler::determineEncryptionParameters(
   m_enc_params->prime_bits = eps.getEncryptionParameters();
   m_enc_params->rotations = rks.getRotationKeys();
 
-  // If bit_cnt is too large, parameter acquisition will fail. max 881
-  int bit_cnt = 0;
-  for (auto &log_q : m_enc_params->prime_bits) bit_cnt += log_q;
-
   // Decisions based on different parameters of security intensity
+  int (*max_bits_fun)(std::size_t) = nullptr;
   if (m_config.m_security_level <= 128) {
-    if (m_config.m_quantum_safe)
-      m_enc_params->poly_modulus_degree = getMinDegreeForBitCount(
-          &seal::util::seal_he_std_parms_128_tq, bit_cnt);
-    else
-      m_enc_params->poly_modulus_degree = getMinDegreeForBitCount(
-          &seal::util::seal_he_std_parms_128_tc, bit_cnt);
+    max_bits_fun = m_config.m_quantum_safe
+                       ? &seal::util::seal_he_std_parms_128_tq
+                       : &seal::util::seal_he_std_parms_128_tc;
   } else if (m_config.m_security_level <= 192) {
-    if (m_config.m_quantum_safe)
-      m_enc_params->poly_modulus_degree = getMinDegreeForBitCount(
-          &seal::util::seal_he_std_parms_192_tq, bit_cnt);
-    else
-      m_enc_params->poly_modulus_degree = getMinDegreeForBitCount(
-          &seal::util::seal_he_std_parms_192_tc, bit_cnt);
+    max_bits_fun = m_config.m_quantum_safe
+                       ? &seal::util::seal_he_std_parms_192_tq
+                       : &seal::util::seal_he_std_parms_192_tc;
   } else if (m_config.m_security_level <= 256) {
-    if (m_config.m_quantum_safe)
-      m_enc_params->poly_modulus_degree = getMinDegreeForBitCount(
-          &seal::util::seal_he_std_parms_256_tq, bit_cnt);
-    else
-      m_enc_params->poly_modulus_degree = getMinDegreeForBitCount(
-          &seal::util::seal_he_std_parms_256_tc, bit_cnt);
+    max_bits_fun = m_config.m_quantum_safe
+                       ? &seal::util::seal_he_std_parms_256_tq
+                       : &seal::util::seal_he_std_parms_256_tc;
   } else {
     warn(
         "iyfc has support for up to 256 bit security, but %d bit security was "
@@ -174,7 +196,48 @@ int SealCkksHandler::determineEncryptionParameters(
     return SEAL_SECUITY_LEVEL_BITS_NOT_MATCH;
   }
 
-  auto slots = m_enc_params->poly_modulus_degree / 2;
+  // Search output prime splits and special primes around the chain of the
+  // selector, a cheaper chain often fits half the degree
+  CkksChain baseline;
+  baseline.output_primes = eps.getOutputPrimes();
+  baseline.rescale_primes = eps.getRescalePrimes();
+  baseline.special_prime = m_enc_params->prime_bits.back();
+  CkksChain chain =
+      search.search(max_bits_fun, 2 * dag.getVecSize(), baseline,
+                    eps.getOutputBits(), dag.m_output_mod_switch);
+  int bit_cnt = chain.totalBits();
+  if (chain.poly_modulus_degree == 0) {
+    bit_cnt = baseline.totalBits();
+    // If bit_cnt is too large, parameter acquisition will fail. max 881
+    warn(
+        "Dag requires a %u bit modulus, but parameters are available for a "
+        "maximum of %u ",
+        bit_cnt, max_bits_fun(32768));
+    throw std::logic_error("in seal ckks, err bit modulus!");
+  }
+  std::size_t baseline_degree = std::max<std::size_t>(
+      CkksParameterSearch::getMinDegree(max_bits_fun, baseline.totalBits()),
+      2 * dag.getVecSize());
+  LOG(LOGLEVEL::Debug,
+      "parameter search scored %lu chains, cost %.3g at degree %lu, selector "
+      "chain cost %.3g at degree %lu",
+      search.getCandidateCnt(), chain.cost, chain.poly_modulus_degree,
+      search.cost(baseline_degree, baseline), baseline_degree);
+  m_enc_params->prime_bits = chain.primeBits();
+  m_enc_params->poly_modulus_degree = chain.poly_modulus_degree;
+  eps.setOutputPrimes(chain.output_primes);
+
+  // Switch outputs down to the primes their scale and range need
+  if (dag.m_output_mod_switch) {
+    OutputModSwitcher oms(dag, types, scales);
+    auto switched = oms(eps.getOutputDropLevels());
+    LOG(LOGLEVEL::Debug, "OutputModSwitcher inserted %u mod_switch nodes",
+        switched);
+  }
+
+  // The search never goes below the vector size, warn about the degree
+  // security alone would need
+  auto slots = CkksParameterSearch::getMinDegree(max_bits_fun, bit_cnt) / 2;
   if (m_config.m_warn_vecsize && slots > dag.getVecSize()) {
     LOG(LOGLEVEL::Debug,
         "Dag specifies vector size %i while at least %i slots are "
@@ -185,17 +248,14 @@ int SealCkksHandler::determineEncryptionParameters(
         "cost.",
         dag.getVecSize(), slots, slots);
   }
-  if (slots < dag.getVecSize()) {
-    if (m_config.m_warn_vecsize) {
-      LOG(LOGLEVEL::Debug,
-          "Dag uses vector size %i while only %i slots are required for "
-          "security. "
-          "This does not affect correctness, but higher performance may be "
-          "available "
-          "with a smaller vector size.",
-          dag.getVecSize(), slots);
-    }
-    m_enc_params->poly_modulus_degree = 2 * dag.getVecSize();
+  if (m_config.m_warn_vecsize && slots < dag.getVecSize()) {
+    LOG(LOGLEVEL::Debug,
+        "Dag uses vector size %i while only %i slots are required for "
+        "security. "
+        "This does not affect correctness, but higher performance may be "
+        "available "
+        "with a smaller vector size.",
+        dag.getVecSize(), slots);
   }
 
   if (logLevelLeast(LOGLEVEL::Debug)) {
@@ -25,6 +25,7 @@
 #include <seal/util/hestdparms.h>
 
 #include "ckks_config.h"
+#include "ckks_parameter_search.h"
 #include "ckks_parameters.h"
 #include "daghandler/ckks_rotation_keys_handler.h"
 #include "daghandler/clean_node_handler.h"
@@ -38,10 +39,12 @@
 #include "eager_waterline_rescaler.h"
 #include "encode_inserter.h"
 #include "encryption_parameter_selector.h"
-#include "lazy_relinearizer.h"
+#include "lazy_waterline_rescaler.h"
 #include "levels_checker.h"
 #include "mod_switcher.h"
+#include "optimal_relinearizer.h"
 #include "parameter_checker.h"
+#include "rescale_planner.h"
 #include "rescaler.h"
 #include "scales_checker.h"
 #include "seal_lowering.h"
@@ -76,14 +79,6 @@ class SealCkksHandler : public ParametersInterface {
   void validate(Dag &dag, NodeMap<DataType> &types,
                 NodeMapOptional<std::uint32_t> &scales);
 
-  /**
-   * @brief Determines degree parameter.
-   * @param [in] MaxBitsFun Processing function related to security strength.
-   * @param [in] bitCount Total bit count required for DAG execution.
-   */
-  std::size_t getMinDegreeForBitCount(int (*MaxBitsFun)(std::size_t),
-                                      int bitCount);
-
   /**
    * @brief Determines encryption parameters.
    * @param [in] dag DAG
@@ -94,7 +89,7 @@ class SealCkksHandler : public ParametersInterface {
                                     NodeMapOptional<std::uint32_t> &scales,
                                     NodeMap<DataType> types);
 
-  void extractSignature(const Dag &dag);
+  void extractSignature(Dag &dag);
 
   /**
    * @brief transpile
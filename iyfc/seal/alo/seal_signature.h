@@ -23,6 +23,7 @@
 #pragma once
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include "dag/data_type.h"
 
 namespace iyfc {
@@ -35,9 +36,14 @@ struct SealEncodingInfo {
   DataType input_type;
   int scale;
   int level;
+  bool is_complex;
 
-  SealEncodingInfo(DataType input_type, int scale, int level)
-      : input_type(input_type), scale(scale), level(level) {}
+  SealEncodingInfo(DataType input_type, int scale, int level,
+                   bool is_complex = false)
+      : input_type(input_type),
+        scale(scale),
+        level(level),
+        is_complex(is_complex) {}
 };
 
 /**
@@ -47,10 +53,15 @@ struct SealEncodingInfo {
 struct SealSignature {
   int vec_size;
   std::unordered_map<std::string, SealEncodingInfo> inputs;
+  // Outputs depending on complex inputs, decoded as complex vectors
+  std::unordered_set<std::string> complex_outputs;
 
   SealSignature(int vec_size,
-                std::unordered_map<std::string, SealEncodingInfo> inputs)
-      : vec_size(vec_size), inputs(inputs) {}
+                std::unordered_map<std::string, SealEncodingInfo> inputs,
+                std::unordered_set<std::string> complex_outputs = {})
+      : vec_size(vec_size),
+        inputs(inputs),
+        complex_outputs(complex_outputs) {}
 };
 
 std::unique_ptr<msg::SealSignature> serialize(const SealSignature &);
@@ -50,22 +50,42 @@ seal::SEALContext getSEALContext(const seal::EncryptionParameters &params) {
   }
 }
 
+/**
+ * @brief Save a seeded Serializable key, about half the expanded size
+ */
+template <class T>
+static std::string saveSeeded(const seal::Serializable<T> &obj) {
+  std::string data;
+  data.resize(static_cast<size_t>(
+      obj.save_size(seal::Serialization::compr_mode_default)));
+  data.resize(static_cast<size_t>(
+      obj.save(reinterpret_cast<seal::seal_byte *>(&data[0]), data.size(),
+               seal::Serialization::compr_mode_default)));
+  return data;
+}
+
 tuple<unique_ptr<SEALPublic>, unique_ptr<SEALSecret>> getKeysByContext(
     const seal::SEALContext &context, const vector<int> &vec_rotations,
     std::shared_ptr<SealEncoderBase> p_en) {
   seal::KeyGenerator keygen(context);
 
   seal::PublicKey public_key;
-  seal::GaloisKeys galois_keys;
-  seal::RelinKeys relin_keys;
-
   keygen.create_public_key(public_key);
-  keygen.create_galois_keys(vec_rotations, galois_keys);
-  keygen.create_relin_keys(relin_keys);
+
+  // Evaluation keys stay seeded, one galois key set per rotation step so
+  // that execute expands only the steps a DAG uses
+  std::map<int, std::string> seeded_galois;
+  for (int step : vec_rotations) {
+    seeded_galois[step] =
+        saveSeeded(keygen.create_galois_keys(std::vector<int>{step}));
+  }
+  std::string seeded_relin = saveSeeded(keygen.create_relin_keys());
 
   auto secretCtx = make_unique<SEALSecret>(context, keygen.secret_key(), p_en);
-  auto publicCtx = make_unique<SEALPublic>(context, public_key, galois_keys,
-                                           relin_keys, p_en);
+  auto publicCtx =
+      make_unique<SEALPublic>(context, public_key, seal::GaloisKeys(),
+                              seal::RelinKeys(), p_en);
+  publicCtx->setSeededKeys(std::move(seeded_galois), std::move(seeded_relin));
 
   return make_tuple(move(publicCtx), move(secretCtx));
 }
@@ -91,19 +111,27 @@ tuple<unique_ptr<SEALPublic>, unique_ptr<SEALSecret>> generateKeys(
 
 tuple<unique_ptr<SEALPublic>, unique_ptr<SEALSecret>> generateKeys(
     const BfvParameters &abstractParams) {
-  auto params = seal::EncryptionParameters(seal::scheme_type::bfv);  
+  auto params = seal::EncryptionParameters(seal::scheme_type::bfv);
   size_t poly_modulus_degree = abstractParams.poly_modulus_degree;
-  // size_t poly_modulus_degree = 16384;
 
   params.set_poly_modulus_degree(poly_modulus_degree);
-  params.set_coeff_modulus(
-      seal::CoeffModulus::BFVDefault(poly_modulus_degree));
-  params.set_plain_modulus(
-      seal::PlainModulus::Batching(poly_modulus_degree, 20));
-  
+  // Parameters saved before the noise model carry no usable chain
+  if (abstractParams.plain_modulus == 0 ||
+      abstractParams.plain_modulus > MAX_BFV_PLAIN_BITS) {
+    params.set_coeff_modulus(
+        seal::CoeffModulus::BFVDefault(poly_modulus_degree));
+    params.set_plain_modulus(seal::PlainModulus::Batching(
+        poly_modulus_degree, DEFAULT_BFV_PLAIN_BITS));
+  } else {
+    vector<int> log_qs(abstractParams.prime_bits.begin(),
+                       abstractParams.prime_bits.end());
+    params.set_coeff_modulus(
+        seal::CoeffModulus::Create(poly_modulus_degree, log_qs));
+    params.set_plain_modulus(seal::PlainModulus::Batching(
+        poly_modulus_degree, abstractParams.plain_modulus));
+  }
 
-  // auto context = getSEALContext(params)
-  seal::SEALContext context(params);
+  auto context = getSEALContext(params);
 
   vector<int> vec_rotations(abstractParams.rotations.begin(),
                             abstractParams.rotations.end());
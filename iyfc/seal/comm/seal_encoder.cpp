@@ -21,25 +21,45 @@
  * SOFTWARE.
  */
 #include "seal_encoder.h"
+#include <seal/util/common.h>
+#include <seal/util/ntt.h>
+#include <seal/util/uintarithsmallmod.h>
+
 #include <algorithm>
 
 namespace iyfc {
 
 void CkksEncoder::encode(const ValuationType &src,
                          seal::Plaintext &destination) {
+  if (std::holds_alternative<std::vector<std::complex<double>>>(src)) {
+    m_encoder.encode(std::get<std::vector<std::complex<double>>>(src),
+                     m_parms_id, pow(2.0, m_ckks_scale), destination, m_pool);
+    return;
+  }
   m_encoder.encode(std::get<std::vector<double>>(src), m_parms_id,
-                   pow(2.0, m_ckks_scale), destination);
+                   pow(2.0, m_ckks_scale), destination, m_pool);
 }
 
 void CkksEncoder::decode(const seal::Plaintext &plain,
                          ValuationType &destination) {
   std::vector<double> result;
-  m_encoder.decode(plain, result);
+  m_encoder.decode(plain, result, m_pool);
+  destination = std::move(result);
+}
+
+void CkksEncoder::decodeComplex(const seal::Plaintext &plain,
+                                ValuationType &destination) {
+  std::vector<std::complex<double>> result;
+  m_encoder.decode(plain, result, m_pool);
   destination = std::move(result);
 }
 
 size_t CkksEncoder::getSlotCnt() { return m_encoder.slot_count(); }
 
+std::shared_ptr<SealEncoderBase> CkksEncoder::clone() const {
+  return std::make_shared<CkksEncoder>(m_context);
+}
+
 void BfvEncoder::encode(const ValuationType &src,
                         seal::Plaintext &destination) {
   m_encoder.encode(std::get<std::vector<int64_t>>(src), destination);
@@ -48,9 +68,56 @@ void BfvEncoder::encode(const ValuationType &src,
 void BfvEncoder::decode(const seal::Plaintext &plain,
                         ValuationType &destination) {
   std::vector<int64_t> result;
-  m_encoder.decode(plain, result);
+  m_encoder.decode(plain, result, m_pool);
+  destination = std::move(result);
+}
+
+void BfvEncoder::decodeSlots(const seal::Plaintext &plain,
+                             const std::vector<uint32_t> &indices,
+                             ValuationType &destination) {
+  auto context_data = m_context.first_context_data();
+  size_t slots = m_encoder.slot_count();
+  size_t log_n = seal::util::get_power_of_two(slots);
+  // One slot costs a pass over the coefficients, the batch decoder an NTT of
+  // n * log(n) / 2 butterflies
+  if (plain.is_ntt_form() ||
+      2 * indices.size() * plain.coeff_count() > slots * log_n) {
+    SealEncoderBase::decodeSlots(plain, indices, destination);
+    return;
+  }
+  const seal::Modulus &modulus = context_data->parms().plain_modulus();
+  uint64_t root = context_data->plain_ntt_tables()->get_root();
+  uint64_t m = slots << 1;
+  size_t row_size = slots >> 1;
+  uint64_t modulus_div_two = modulus.value() >> 1;
+
+  std::vector<int64_t> result;
+  result.reserve(indices.size());
+  for (auto idx : indices) {
+    if (idx >= slots) break;
+    // Slot i of the top row holds the plaintext polynomial at root^(3^i),
+    // the bottom row at root^(-3^i), as in BatchEncoder's index map
+    uint64_t pos = 1;
+    for (size_t i = 0; i < idx % row_size; i++) pos = (pos * 3) & (m - 1);
+    if (idx >= row_size) pos = m - pos;
+    uint64_t x = seal::util::exponentiate_uint_mod(root, pos, modulus);
+
+    uint64_t value = 0;
+    for (size_t j = plain.coeff_count(); j-- > 0;) {
+      value = seal::util::multiply_uint_mod(value, x, modulus);
+      value = seal::util::add_uint_mod(value, plain[j], modulus);
+    }
+    result.push_back(value > modulus_div_two
+                         ? static_cast<int64_t>(value) -
+                               static_cast<int64_t>(modulus.value())
+                         : static_cast<int64_t>(value));
+  }
   destination = std::move(result);
 }
 
 size_t BfvEncoder::getSlotCnt() { return m_encoder.slot_count(); }
+
+std::shared_ptr<SealEncoderBase> BfvEncoder::clone() const {
+  return std::make_shared<BfvEncoder>(m_context);
+}
 }  // namespace iyfc
\ No newline at end of file
@@ -23,9 +23,13 @@
 #pragma once
 #include <seal/seal.h>
 
+#include <memory>
+#include <stdexcept>
 #include <variant>
+#include <vector>
 
 #include "comm_include.h"
+#include "util/thread_util.h"
 
 namespace iyfc {
 // seal encode ckks bfv parameters
@@ -52,6 +56,20 @@ class SealEncoderBase {
     m_parms_id = parms_id;
   }
 
+  /**
+   * @brief  setMemoryPool memory pool used by encode/decode
+   * @param [in] pool e.g. a thread-local pool for per-thread encoders
+   */
+  void setMemoryPool(seal::MemoryPoolHandle pool) { m_pool = pool; }
+  seal::MemoryPoolHandle getMemoryPool() const { return m_pool; }
+
+  /**
+   * @brief  clone a new encoder on the same context
+   * @details encode parameters are per-instance state, so concurrent encoding
+   * needs one encoder per thread
+   */
+  virtual std::shared_ptr<SealEncoderBase> clone() const = 0;
+
   /**
    * @brief  encode
    * @param [in] src const ValuationType &
@@ -66,9 +84,32 @@ class SealEncoderBase {
    */
   virtual void decode(const seal::Plaintext &plain,
                       ValuationType &destination) = 0;
+  /**
+   * @brief  decodeComplex decode both parts of the slots
+   * @param [in] plain const seal::Plaintext &
+   * @param [out] destination ValuationType & holding complex vector
+   */
+  virtual void decodeComplex(const seal::Plaintext &plain,
+                             ValuationType &destination) {
+    throw std::logic_error("complex decode is only supported by ckks");
+  }
+  /**
+   * @brief  decodeSlots decode only the given slots
+   * @details the default decodes everything and drops the rest
+   * @param [in] plain const seal::Plaintext &
+   * @param [in] indices ascending slot indices
+   * @param [out] destination ValuationType & holding indices.size() values
+   */
+  virtual void decodeSlots(const seal::Plaintext &plain,
+                           const std::vector<uint32_t> &indices,
+                           ValuationType &destination) {
+    decode(plain, destination);
+    pickSlots(destination, indices);
+  }
   virtual size_t getSlotCnt() = 0;
   double m_ckks_scale = 0.0;
   seal::parms_id_type m_parms_id;
+  seal::MemoryPoolHandle m_pool = seal::MemoryManager::GetPool();
 };
 
 /**
@@ -79,11 +120,16 @@ class CkksEncoder : public SealEncoderBase {
  public:
   virtual void encode(const ValuationType &src, seal::Plaintext &destination);
   virtual void decode(const seal::Plaintext &plain, ValuationType &destination);
+  virtual void decodeComplex(const seal::Plaintext &plain,
+                             ValuationType &destination);
   virtual size_t getSlotCnt();
-  CkksEncoder(const seal::SEALContext &context) : m_encoder(context) {}
+  virtual std::shared_ptr<SealEncoderBase> clone() const;
+  CkksEncoder(const seal::SEALContext &context)
+      : m_context(context), m_encoder(context) {}
   ~CkksEncoder() {}
 
  private:
+  seal::SEALContext m_context;
   seal::CKKSEncoder m_encoder;
 };
 
@@ -95,12 +141,62 @@ class BfvEncoder : public SealEncoderBase {
  public:
   virtual void encode(const ValuationType &src, seal::Plaintext &destination);
   virtual void decode(const seal::Plaintext &plain, ValuationType &destination);
+  virtual void decodeSlots(const seal::Plaintext &plain,
+                           const std::vector<uint32_t> &indices,
+                           ValuationType &destination);
   virtual size_t getSlotCnt();
-  BfvEncoder(const seal::SEALContext &context) : m_encoder(context) {}
+  virtual std::shared_ptr<SealEncoderBase> clone() const;
+  BfvEncoder(const seal::SEALContext &context)
+      : m_context(context), m_encoder(context) {}
   ~BfvEncoder() {}
 
  private:
+  seal::SEALContext m_context;
   seal::BatchEncoder m_encoder;
 };
 
+/**
+ * @class ThreadEncoders
+ * @brief Per-thread encoders for parallelFor, kept by their owner across
+ * calls. Each clone is made on first use with its own memory pool. Falls
+ * back to the shared encoder when only one thread runs. Call prepare()
+ * before each parallelFor and pass its result as the thread count; one
+ * parallelFor at a time, the owner serializes calls.
+ */
+class ThreadEncoders {
+ public:
+  explicit ThreadEncoders(std::shared_ptr<SealEncoderBase> encoder)
+      : m_encoder(encoder) {}
+
+  /**
+   * @brief Size for task_cnt tasks, earlier clones are kept.
+   * @return Thread count to pass to parallelFor
+   */
+  uint32_t prepare(size_t task_cnt) {
+    m_thread_num = task_cnt <= 1 ? 1 : getWorkerThreadNum();
+    if (m_encoders.size() < m_thread_num) m_encoders.resize(m_thread_num);
+    return m_thread_num;
+  }
+
+  uint32_t threadNum() const { return m_thread_num; }
+
+  SealEncoderBase &get(size_t thread_id) {
+    if (m_thread_num <= 1) return *m_encoder;
+    auto &encoder = m_encoders.at(thread_id);
+    if (!encoder) {
+      // Worker threads are not pinned to a thread id across calls, so the
+      // pool belongs to the clone rather than to a thread
+      encoder = m_encoder->clone();
+      encoder->setMemoryPool(
+          seal::MemoryManager::GetPool(seal::mm_prof_opt::mm_force_new));
+    }
+    return *encoder;
+  }
+
+ private:
+  std::shared_ptr<SealEncoderBase> m_encoder;
+  uint32_t m_thread_num{1};
+  std::vector<std::shared_ptr<SealEncoderBase>> m_encoders;
+};
+
 }  // namespace iyfc
\ No newline at end of file
@@ -39,6 +39,7 @@
 #include "dag/constant_value.h"
 #include "dag/iyfc_dag.h"
 #include "dag/node_map.h"
+#include "daghandler/incremental_handler.h"
 #include "daghandler/node_degree_cnt.h"
 #include "daghandler/traversal_handler.h"
 #include "err_code.h"
@@ -70,6 +71,10 @@ namespace iyfc {
   } else                                                                   \
     return;
 
+// Sees a ciphertext right after the executor computed it
+typedef std::function<void(const NodePtr &, const seal::Ciphertext &)>
+    CipherProbe;
+
 /**
  * @class SEALExecutor
  * @brief seal library execution class traverses the nodes in the execution DAG
@@ -98,6 +103,10 @@ class SEALExecutor {
   std::unordered_map<uint64_t, int> m_index2in;  // node  in-degree information
   bool m_has_err{false};
   std::vector<T> temp_vec;
+  // Set when values are kept between runs, see enableIncremental
+  std::unique_ptr<IncrementalExe> m_incremental;
+  // Sees every ciphertext computed, see setProbe
+  CipherProbe m_probe;
 
   bool isCipher(const NodePtr &t) {
     return std::holds_alternative<seal::Ciphertext>(m_objects.at(t));
@@ -480,6 +489,28 @@ class SEALExecutor {
   }
 
   bool IsErr() { return m_has_err; }
+
+  /**
+   * @brief Keep every value after a run so that the next run only recomputes
+   * the nodes downstream of changed inputs. Disables in-place evaluation.
+   */
+  void enableIncremental() {
+    m_incremental = std::make_unique<IncrementalExe>();
+  }
+
+  /**
+   * @brief Call probe with every ciphertext right after it is computed, to
+   * measure its noise on a debug key
+   */
+  void setProbe(CipherProbe probe) { m_probe = std::move(probe); }
+
+  /**
+   * @brief Whether setInputs has to load the input for this run
+   */
+  bool needInput(const std::string &name) const {
+    return !m_incremental || m_incremental->isInputDirty(name);
+  }
+
   /**
    * @brief encode_raw Encode primitive data types
    */
@@ -512,7 +543,13 @@ class SEALExecutor {
     if (m_has_err) {
       throw std::logic_error("exe err");
     }
-    
+    // Outside the requested outputs, or value of the previous run still valid
+    bool in_cone = dag.inExeCone(*node);
+    if (m_incremental ? !m_incremental->needCompute(*node, in_cone)
+                      : !in_cone) {
+      return;
+    }
+
     if (logLevelLeast(LOGLEVEL::Trace)) {
       printf("iyfc: Execute t%lu = %s(", node->m_index,
              getOpName(node->m_op_type).c_str());
@@ -538,7 +575,8 @@ class SEALExecutor {
     for (int i = 0; i < arg_size; i++) {
       m_index2out[args[i]->m_index]--;
       // printf("op %d,  out_cnt %d \n", i, m_index2out[args[i]->m_index]);
-      if (m_index2out[args[i]->m_index] == 0) vec_agr_inplace[i] = true;
+      if (m_index2out[args[i]->m_index] == 0 && !m_incremental)
+        vec_agr_inplace[i] = true;
     }
 
     switch (node->m_op_type) {
@@ -715,13 +753,20 @@ class SEALExecutor {
       } break;
       case OpType::Output: {
         SEAL_EXE_CHECK_ERROR(arg_size == 1, "exe dag err:Output args !=1");
-        m_objects[node] = std::move(m_objects.at(args[0]));
+        if (m_incremental) {
+          m_objects[node] = m_objects.at(args[0]);
+        } else {
+          m_objects[node] = std::move(m_objects.at(args[0]));
+        }
       } break;
       default:
         warn("Unhandled m_op_type %s", getOpName(node->m_op_type).c_str());
         m_has_err = true;
         return;
     }
+    if (m_probe && m_objects.has(node) && isCipher(node)) {
+      m_probe(node, std::get<seal::Ciphertext>(m_objects.at(node)));
+    }
   }
 
   void free(const NodePtr &node) {
@@ -743,6 +788,7 @@ class SEALExecutor {
    */
   void getOutputs(SEALValuation &enc_outputs) {
     for (auto &out : dag.getOutputs()) {
+      if (!dag.inExeCone(*out.second)) continue;
       std::visit(Overloaded{[&](const seal::Ciphertext &output) {
                               enc_outputs[out.first] = output;
                             },
@@ -817,6 +863,7 @@ class CkksSealExecutor : public SEALExecutor<double> {
     for (auto &in : inputs) {
       // LOG(LOGLEVEL::Debug, "setInputs for exe name : %s \n",
       // in.first.c_str());
+      if (!needInput(in.first)) continue;
       auto node = dag.getInput(in.first);
 
       std::visit(
@@ -898,6 +945,7 @@ class BfvSealExecutor : public SEALExecutor<int64_t> {
 
   virtual void setInputs(const SEALValuation &inputs) {
     for (auto &in : inputs) {
+      if (!needInput(in.first)) continue;
       auto node = dag.getInput(in.first);
 
       std::visit(
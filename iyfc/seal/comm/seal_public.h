@@ -24,11 +24,24 @@
 #pragma once
 #include <seal/seal.h>
 
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <type_traits>
+
 #include "comm_include.h"
+#include "daghandler/ckks_rotation_keys_handler.h"
+#include "daghandler/incremental_handler.h"
 #include "daghandler/traversal_handler.h"
 #include "seal/alo/seal_signature.h"
 #include "seal_encoder.h"
+#include "seal_executor.h"
 #include "seal_valuation.h"
+#include "seal_zero_pool.h"
+#include "util/thread_util.h"
 
 namespace iyfc {
 
@@ -54,7 +67,8 @@ class SEALPublic {
         relinKeys(rk),
         encryptor(ctx, publicKey),
         evaluator(ctx),
-        encoder_ptr(p_en) {}
+        encoder_ptr(p_en),
+        m_encoders(p_en) {}
 
   /**
    * @brief Encrypt plaintext inputs.
@@ -65,104 +79,196 @@ class SEALPublic {
   template <typename T>
   SEALValuation encrypt(const Valuation &variant_inputs,
                         const SealSignature &signature) {
-    SEALValuation sealInputs(context);
-    size_t slot_count = encoder_ptr->getSlotCnt();
-    LOG(LOGLEVEL::Trace, "slot_count %u, sig_vec_size %u", slot_count,
-        signature.vec_size);
-    if (slot_count < signature.vec_size) {
-      warn("Vector size cannot be larger than slot count");
-      return sealInputs;
-    }
-    if (slot_count % signature.vec_size != 0) {
-      warn("Vector size must exactly divide the slot count");
-      return sealInputs;
-    }
+    std::vector<const Valuation::value_type *> items;
+    items.reserve(variant_inputs.size());
+    for (auto &in : variant_inputs) items.push_back(&in);
+    return encryptItems(
+        items, signature,
+        [&](const Valuation::value_type &in, SealEncoderBase &encoder,
+            std::string &seeded) -> SchemeValue {
+          if (auto *v =
+                  std::get_if<std::vector<std::complex<double>>>(&in.second)) {
+            return encryptComplex(in.first, *v, signature, encoder, seeded);
+          }
+          return encryptSpan<T>(in.first, toInputSpan(in.second), signature,
+                                encoder, seeded);
+        });
+  }
 
-    for (auto &in : variant_inputs) {
-      auto name = in.first;  // Input name
-      std::vector<T> v;
-      if (std::holds_alternative<std::vector<T>>(in.second)) {
-        v = get<std::vector<T>>(in.second);
-      } else if (std::holds_alternative<double>(in.second)) {
-        v.insert(v.end(), signature.vec_size, T(get<double>(in.second)));
-      } else if (std::holds_alternative<int64_t>(in.second)) {
-        v.insert(v.end(), signature.vec_size, T(get<int64_t>(in.second)));
-      }
+  /**
+   * @brief Encrypt caller-owned inputs without copying them into a Valuation.
+   * @param [in] inputs Input views, converted to T while encoding
+   * @param [in] signature Signature information
+   * @return SEALValuation Encrypted ciphertext
+   */
+  template <typename T>
+  SEALValuation encrypt(const InputSpans &inputs,
+                        const SealSignature &signature) {
+    std::vector<const InputSpans::value_type *> items;
+    items.reserve(inputs.size());
+    for (auto &in : inputs) items.push_back(&in);
+    return encryptItems(
+        items, signature,
+        [&](const InputSpans::value_type &in, SealEncoderBase &encoder,
+            std::string &seeded) -> SchemeValue {
+          return encryptSpan<T>(in.first, in.second, signature, encoder,
+                                seeded);
+        });
+  }
 
-      auto v_size = v.size();
-      // TODO remove this check
-      if (v_size != signature.vec_size) {
-        v.resize(signature.vec_size);
-        LOG(LOGLEVEL::Debug,
-            "Input size does not match dag vector size, resize");
-      }
-      auto info = signature.inputs.at(name);
-      auto ctx_data = context.first_context_data();
+  /**
+   * @brief Use seeded evaluation keys, expanded on demand by execute
+   * @details Concurrent executes may expand keys, an expansion waits for the
+   * running executes and blocks new ones. Not to be called while executes
+   * run.
+   * @param [in] seeded_galois Seeded GaloisKeys per rotation step
+   * @param [in] seeded_relin Seeded RelinKeys
+   */
+  void setSeededKeys(std::map<int, std::string> seeded_galois,
+                     std::string seeded_relin) {
+    std::unique_lock<std::shared_mutex> lock(m_keys_mutex);
+    m_seeded_galois = std::move(seeded_galois);
+    m_seeded_relin = std::move(seeded_relin);
+    m_expanded_steps.clear();
+    galoisKeys = seal::GaloisKeys();
+    relinKeys = seal::RelinKeys();
+  }
 
-      for (size_t i = 0; i < info.level; ++i) {
-        ctx_data = ctx_data->next_context_data();
+  /**
+   * @brief Expand the seeded relinearization keys and the galois keys of the
+   * given rotation steps, steps without a seeded key are skipped
+   */
+  void expandKeys(const std::set<int> &steps) {
+    std::unique_lock<std::shared_mutex> lock(m_keys_mutex);
+    if (!m_seeded_relin.empty() && relinKeys.size() == 0) {
+      relinKeys.load(context, reinterpret_cast<const seal::seal_byte *>(
+                                  m_seeded_relin.data()),
+                     m_seeded_relin.size());
+    }
+    for (int step : steps) {
+      auto seeded = m_seeded_galois.find(step);
+      if (seeded == m_seeded_galois.end() || m_expanded_steps.count(step)) {
+        continue;
       }
-      if (info.input_type == DataType::Cipher ||
-          info.input_type == DataType::Plain) {
-        seal::Plaintext plain;
-
-        if (v_size == 1) {
-          encoder_ptr->setEncodePara(info.scale, ctx_data->parms_id());
-          ValuationType src(v[0]);
-          encoder_ptr->encode(src, plain);
-          // encoder.encode(v[0], ctx_data->parms_id(), pow(2.0,
-          // info.scale),plain);
-        } else {
-          vector<T> vec(slot_count);
-          assert(v_size <= slot_count);
-          assert((slot_count % v_size) == 0);
-          auto replicas = (slot_count / v_size);
-
-          for (uint32_t r = 0; r < replicas; ++r) {
-            for (uint64_t i = 0; i < v_size; ++i) {
-              vec[(r * v_size) + i] = v[i];
-            }
-          }
+      seal::GaloisKeys step_keys;
+      step_keys.load(context,
+                     reinterpret_cast<const seal::seal_byte *>(
+                         seeded->second.data()),
+                     seeded->second.size());
+      // Keys are indexed by galois element, merge the non-empty slots
+      auto &keys = galoisKeys.data();
+      if (keys.size() < step_keys.data().size()) {
+        keys.resize(step_keys.data().size());
+      }
+      for (size_t i = 0; i < step_keys.data().size(); ++i) {
+        if (!step_keys.data()[i].empty()) {
+          keys[i] = std::move(step_keys.data()[i]);
+        }
+      }
+      galoisKeys.parms_id() = step_keys.parms_id();
+      m_expanded_steps.insert(step);
+    }
+  }
 
-          encoder_ptr->setEncodePara(info.scale, ctx_data->parms_id());
+  /**
+   * @brief Expand the keys of the steps and hold the keys for reading
+   * @return Shared lock, no expansion changes the keys until it is released
+   */
+  std::shared_lock<std::shared_mutex> lockKeys(const std::set<int> &steps) {
+    std::shared_lock<std::shared_mutex> lock(m_keys_mutex);
+    while (needsExpansion(steps)) {
+      lock.unlock();
+      expandKeys(steps);
+      lock.lock();
+    }
+    return lock;
+  }
 
-          ValuationType src = vec;
-          encoder_ptr->encode(src, plain);
+  /**
+   * @brief Switch between public-key and seeded symmetric encryption
+   * @param [in] sk Secret key for SYMMETRIC_MODE, nullptr for public-key
+   * encryption
+   */
+  void setSymmetricKey(const seal::SecretKey *sk) {
+    if (sk) {
+      encryptor.set_secret_key(*sk);
+    }
+    m_symmetric = sk != nullptr;
+  }
 
-          // encoder.encode(vec, ctx_data->parms_id(), pow(2.0,
-          // info.scale),plain);
-        }
-        if (info.input_type == DataType::Cipher) {
-          seal::Ciphertext cipher;
-          encryptor.encrypt(plain, cipher);
-          sealInputs[name] = move(cipher);
-        } else if (info.input_type == DataType::Plain) {
-          sealInputs[name] = move(plain);
+  /**
+   * @brief Enable, resize or disable (size_per_level 0) the pool of
+   * encryptions of zero used by encrypt.
+   * @param [in] config Pool configuration
+   * @param [in] signature Signature information, its Cipher inputs decide
+   * the pooled levels
+   */
+  void setZeroPool(const EncryptPoolConfig &config,
+                   const SealSignature &signature) {
+    if (m_zero_pool) {
+      m_zero_pool->stopRefill();
+      if (!m_zero_pool_path.empty()) {
+        std::ofstream out(m_zero_pool_path, std::ios::binary);
+        if (out.fail()) {
+          throw std::logic_error("setZeroPool Could not open file");
         }
-      } else {
-        sealInputs[name] = std::shared_ptr<ConstantValue<T>>(
-            new DenseConstantValue<T>(signature.vec_size, v));
+        m_zero_pool->save(out);
+      }
+      m_zero_pool.reset();
+      m_zero_pool_path.clear();
+    }
+    if (config.size_per_level == 0) {
+      return;
+    }
+    auto zero_pool = std::make_shared<SealZeroPool>(context, publicKey, config);
+    for (auto &in : signature.inputs) {
+      if (in.second.input_type == DataType::Cipher) {
+        zero_pool->reserve(zeroParmsId(in.second.level));
       }
     }
+    if (!config.persist_path.empty()) {
+      std::ifstream in(config.persist_path, std::ios::binary);
+      if (in.good()) {
+        zero_pool->load(in);
+        in.close();
+        // A persisted encryption of zero must never be used twice
+        std::remove(config.persist_path.c_str());
+      }
+    }
+    if (config.refill_thread) {
+      zero_pool->startRefill();
+    } else {
+      zero_pool->fill();
+    }
+    m_zero_pool = zero_pool;
+    m_zero_pool_path = config.persist_path;
+  }
 
-    return sealInputs;
+  /**
+   * @brief Metrics of the pool of encryptions of zero, all zero if disabled
+   */
+  EncryptPoolMetrics getZeroPoolMetrics() const {
+    return m_zero_pool ? m_zero_pool->metrics() : EncryptPoolMetrics();
   }
 
   /**
    * @brief Execute operations on encrypted inputs.
    * @param [in] dag DAG
    * @param [in] inputs Encrypted inputs
+   * @param [in] probe Sees every ciphertext computed, may be empty
    * @return SEALValuation Encrypted outputs
   */
   template <typename T_EXE>
   SEALValuation execute(
-      Dag &dag, const SEALValuation &inputs) {
+      Dag &dag, const SEALValuation &inputs, CipherProbe probe = nullptr) {
+    auto keys_lock = lockKeys(collectRotationSteps(dag));
     // Otherwise fall back to singlecore evaluation
     DagTraversal dag_traverse(dag);
 
     // Executor to handle SEAL operations
     auto seal_executor = T_EXE(encoder_ptr, dag, context, encryptor, evaluator,
                                galoisKeys, relinKeys);
+    seal_executor.setProbe(std::move(probe));
     seal_executor.setInputs(inputs);
 
     SEALValuation enc_outputs(context);
@@ -182,7 +288,239 @@ class SEALPublic {
     return enc_outputs;
   }
 
+  /**
+   * @brief Execute reusing the values of the executor's previous run, only
+   * the nodes downstream of changed inputs are recomputed.
+   * @param [in] dag DAG
+   * @param [in] inputs Encrypted inputs
+   * @param [in] versions Encryption versions of the inputs
+   * @param [in,out] executor Executor of the previous run, created when null
+   * and dropped after an error
+   * @param [in] probe Sees every ciphertext recomputed, may be empty
+   * @return SEALValuation Encrypted outputs
+   */
+  template <typename T_EXE>
+  SEALValuation executeIncremental(Dag &dag, const SEALValuation &inputs,
+                                   const InputVersions &versions,
+                                   std::unique_ptr<T_EXE> &executor,
+                                   CipherProbe probe = nullptr) {
+    auto keys_lock = lockKeys(collectRotationSteps(dag));
+    if (executor == nullptr) {
+      executor = std::make_unique<T_EXE>(encoder_ptr, dag, context, encryptor,
+                                         evaluator, galoisKeys, relinKeys);
+      executor->enableIncremental();
+    }
+    executor->setProbe(std::move(probe));
+    executor->m_incremental->beginRun(dag, versions, dag.getExeInputs());
+    executor->setInputs(inputs);
+
+    SEALValuation enc_outputs(context);
+    DagTraversal dag_traverse(dag);
+    try {
+      dag_traverse.forwardPass(*executor);
+    } catch (...) {
+      // Values of a partial run cannot be reused
+      executor.reset();
+      throw;
+    }
+    if (executor->IsErr()) {
+      executor.reset();
+      return enc_outputs;
+    }
+    executor->m_incremental->endRun();
+    dag.setRecomputedCnt(executor->m_incremental->recomputedCnt());
+    LOG(LOGLEVEL::Debug, "incremental execute recomputed %zu nodes",
+        dag.getRecomputedCnt());
+    executor->getOutputs(enc_outputs);
+    return enc_outputs;
+  }
+
  private:
+  /**
+   * @brief Whether expandKeys has keys left to load for the steps, called
+   * with m_keys_mutex held
+   */
+  bool needsExpansion(const std::set<int> &steps) const {
+    if (!m_seeded_relin.empty() && relinKeys.size() == 0) return true;
+    for (int step : steps) {
+      if (m_seeded_galois.count(step) && !m_expanded_steps.count(step)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Encode and encrypt one input, thread-safe for distinct encoders.
+   * @param [out] seeded Seeded serialization in symmetric mode
+   */
+  template <typename Item, typename F>
+  SEALValuation encryptItems(const std::vector<const Item *> &items,
+                             const SealSignature &signature,
+                             F &&encrypt_one) {
+    SEALValuation sealInputs(context);
+    size_t slot_count = encoder_ptr->getSlotCnt();
+    LOG(LOGLEVEL::Trace, "slot_count %u, sig_vec_size %u", slot_count,
+        signature.vec_size);
+    if (slot_count < signature.vec_size) {
+      warn("Vector size cannot be larger than slot count");
+      return sealInputs;
+    }
+    if (slot_count % signature.vec_size != 0) {
+      warn("Vector size must exactly divide the slot count");
+      return sealInputs;
+    }
+
+    // Inputs (and the tiles of a long input) are independent, encode and
+    // encrypt them concurrently, then insert serially.
+    std::vector<SchemeValue> values(items.size());
+    std::vector<std::string> seeded(items.size());
+    std::lock_guard<std::mutex> lock(m_encoders_mutex);
+    uint32_t thread_num = m_encoders.prepare(items.size());
+    parallelFor(
+        items.size(),
+        [&](size_t idx, size_t thread_id) {
+          values[idx] =
+              encrypt_one(*items[idx], m_encoders.get(thread_id), seeded[idx]);
+        },
+        thread_num);
+    for (size_t i = 0; i < items.size(); ++i) {
+      sealInputs[items[i]->first] = std::move(values[i]);
+      if (!seeded[i].empty()) {
+        sealInputs.setSeeded(items[i]->first, std::move(seeded[i]));
+      }
+    }
+
+    return sealInputs;
+  }
+
+  /**
+   * @brief Encode and encrypt one input, thread-safe for distinct encoders.
+   * The input is converted to T and replicated straight into the slot
+   * vector handed to the encoder.
+   * @param [out] seeded Seeded serialization in symmetric mode
+   */
+  template <typename T>
+  SchemeValue encryptSpan(const std::string &name, const InputSpan &in,
+                          const SealSignature &signature,
+                          SealEncoderBase &encoder, std::string &seeded) {
+    size_t period = inputPeriod(in, signature.vec_size);
+    if (in.size > 1 && in.size != period) {
+      LOG(LOGLEVEL::Debug, "Input size does not match dag vector size, resize");
+    }
+    auto info = signature.inputs.at(name);
+    if (info.input_type != DataType::Cipher &&
+        info.input_type != DataType::Plain) {
+      std::vector<T> v(period);
+      fillSlots(in, v.data(), v.size(), signature.vec_size);
+      return std::shared_ptr<ConstantValue<T>>(
+          new DenseConstantValue<T>(period, std::move(v)));
+    }
+    auto ctx_data = context.first_context_data();
+    for (size_t i = 0; i < info.level; ++i) {
+      ctx_data = ctx_data->next_context_data();
+    }
+    seal::Plaintext plain;
+    encoder.setEncodePara(info.scale, ctx_data->parms_id());
+    // A single value fills every slot
+    std::vector<T> vec(encoder.getSlotCnt());
+    fillSlots(in, vec.data(), vec.size(), signature.vec_size);
+    ValuationType src = std::move(vec);
+    encoder.encode(src, plain);
+    if (info.input_type == DataType::Plain) {
+      return plain;
+    }
+    return encryptPlain(plain, encoder.getMemoryPool(), seeded);
+  }
+
+  /**
+   * @brief Encrypt one complex input, both parts share the CKKS slots.
+   */
+  SchemeValue encryptComplex(const std::string &name,
+                             const std::vector<std::complex<double>> &v,
+                             const SealSignature &signature,
+                             SealEncoderBase &encoder, std::string &seeded) {
+    auto info = signature.inputs.at(name);
+    if (!info.is_complex) {
+      throw std::logic_error("input " + name + " is not declared complex");
+    }
+    if (info.input_type != DataType::Cipher &&
+        info.input_type != DataType::Plain) {
+      throw std::logic_error("complex input " + name + " must be encoded");
+    }
+    size_t slot_count = encoder.getSlotCnt();
+    std::vector<std::complex<double>> vec(slot_count);
+    // Replicate over all slots, as for real inputs
+    size_t v_size = signature.vec_size;
+    for (size_t i = 0; i < slot_count; ++i) {
+      size_t pos = i % v_size;
+      vec[i] = pos < v.size() ? v[pos] : std::complex<double>(0, 0);
+    }
+    auto ctx_data = context.first_context_data();
+    for (size_t i = 0; i < info.level; ++i) {
+      ctx_data = ctx_data->next_context_data();
+    }
+    encoder.setEncodePara(info.scale, ctx_data->parms_id());
+    ValuationType src = std::move(vec);
+    seal::Plaintext plain;
+    encoder.encode(src, plain);
+    if (info.input_type == DataType::Plain) {
+      return plain;
+    }
+    return encryptPlain(plain, encoder.getMemoryPool(), seeded);
+  }
+
+  /**
+   * @brief Level at which the zero for an input is encrypted, BFV always
+   * encrypts at the first level and scales the plaintext in.
+   */
+  seal::parms_id_type zeroParmsId(size_t level) const {
+    auto ctx_data = context.first_context_data();
+    if (ctx_data->parms().scheme() != seal::scheme_type::ckks) {
+      return ctx_data->parms_id();
+    }
+    for (size_t i = 0; i < level; ++i) {
+      ctx_data = ctx_data->next_context_data();
+    }
+    return ctx_data->parms_id();
+  }
+
+  /**
+   * @brief Encrypt an encoded input, online path (zero + plain) when the
+   * pool has an entry for its level.
+   * @param [out] seeded Seeded serialization in symmetric mode
+   */
+  seal::Ciphertext encryptPlain(const seal::Plaintext &plain,
+                                seal::MemoryPoolHandle pool,
+                                std::string &seeded) {
+    seal::Ciphertext cipher;
+    if (m_symmetric) {
+      // The seeded form is uploaded, the expanded one is kept for local use
+      auto serializable = encryptor.encrypt_symmetric(plain, pool);
+      seeded.resize(static_cast<size_t>(
+          serializable.save_size(seal::Serialization::compr_mode_default)));
+      seeded.resize(static_cast<size_t>(serializable.save(
+          reinterpret_cast<seal::seal_byte *>(&seeded[0]), seeded.size(),
+          seal::Serialization::compr_mode_default)));
+      cipher.load(context,
+                  reinterpret_cast<const seal::seal_byte *>(seeded.data()),
+                  seeded.size());
+      return cipher;
+    }
+    auto parms_id =
+        plain.is_ntt_form() ? plain.parms_id() : context.first_parms_id();
+    if (m_zero_pool && m_zero_pool->take(parms_id, cipher)) {
+      // The zero carries no message, so it takes the plaintext's scale
+      if (plain.is_ntt_form()) {
+        cipher.scale() = plain.scale();
+      }
+      evaluator.add_plain_inplace(cipher, plain);
+      return cipher;
+    }
+    encryptor.encrypt(plain, cipher, pool);
+    return cipher;
+  }
+
   seal::SEALContext context;
 
   seal::PublicKey publicKey;
@@ -193,6 +531,18 @@ class SEALPublic {
   seal::Evaluator evaluator;
   // seal::CkksEncoder encoder;
   std::shared_ptr<SealEncoderBase> encoder_ptr;
+  // Clones of encoder_ptr reused by every encrypt, one encrypt at a time
+  ThreadEncoders m_encoders;
+  std::mutex m_encoders_mutex;
+  std::shared_ptr<SealZeroPool> m_zero_pool;
+  // Seeded evaluation keys, empty when the keys were given expanded
+  std::map<int, std::string> m_seeded_galois;
+  std::string m_seeded_relin;
+  std::set<int> m_expanded_steps;
+  // Executes read the keys under a shared lock, expansion takes it alone
+  mutable std::shared_mutex m_keys_mutex;
+  bool m_symmetric{false};
+  std::string m_zero_pool_path;
 
   friend std::unique_ptr<msg::SEALPublic> serialize(const SEALPublic &);
 };  // namespace iyfc
@@ -23,11 +23,18 @@
 #pragma once
 #include <seal/seal.h>
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+
 #include "comm_include.h"
 #include "seal/alo/seal_signature.h"
 #include "seal_encoder.h"
 #include "seal_valuation.h"
 #include "util/overloaded.h"
+#include "util/thread_util.h"
 
 namespace iyfc {
 
@@ -49,7 +56,8 @@ class SEALSecret {
       : m_context(ctx),
         m_secret_key(sk),
         encoder_ptr(p_en),
-        m_decryptor(ctx, m_secret_key) {}
+        m_decryptor(ctx, m_secret_key),
+        m_encoders(p_en) {}
 
 
   /**
@@ -61,45 +69,190 @@ class SEALSecret {
   template <typename T>
   Valuation decrypt(const SEALValuation &enc_outputs,
                     const SealSignature &signature) {
-    Valuation outputs;
-    ValuationType decode_vec;
+    std::vector<const std::pair<const std::string, SchemeValue> *> items;
+    for (auto &out : enc_outputs) items.push_back(&out);
+    return decryptItems<T>(items, signature, nullptr);
+  }
 
+  /**
+   * @brief Decrypt only some outputs and decode only some of their slots.
+   * @param [in] enc_outputs Encrypted ciphertext outputs
+   * @param [in] signature Signature information
+   * @param [in] names Outputs to decrypt, others are skipped
+   * @param [in] slots Slots to keep, BFV decodes only these when few
+   * @return Valuation Decrypted outputs holding the selected slots
+   */
+  template <typename T>
+  Valuation decryptPartial(const SEALValuation &enc_outputs,
+                           const SealSignature &signature,
+                           const std::vector<std::string> &names,
+                           const SlotSelection &slots) {
+    std::unordered_set<std::string> wanted(names.begin(), names.end());
+    std::vector<const std::pair<const std::string, SchemeValue> *> items;
     for (auto &out : enc_outputs) {
-      auto name = out.first;
-      visit(Overloaded{[&](const seal::Ciphertext &cipher) {
-                         seal::Plaintext plain;
-                         m_decryptor.decrypt(cipher, plain);
-                         encoder_ptr->decode(plain, decode_vec);
-                         outputs[name] = decode_vec;
-                       },
-                       [&](const seal::Plaintext &plain) {
-                         encoder_ptr->decode(plain, decode_vec);
-                         outputs[name] = decode_vec;
-                       },
-                       [&](const std::shared_ptr<ConstantValue<double>> &raw) {
-                         std::vector<double> temp_vec;
-                         outputs[name] =
-                             raw->expand(temp_vec, signature.vec_size);
-                       },
-                       [&](const std::shared_ptr<ConstantValue<int64_t>> &raw) {
-                         std::vector<int64_t> temp_vec;
-                         outputs[name] =
-                             raw->expand(temp_vec, signature.vec_size);
-                       }},
-            out.second);
-      auto &v = std::get<vector<T>>(outputs.at(name));
-      v.resize(signature.vec_size);
+      if (wanted.count(out.first)) items.push_back(&out);
     }
-    return outputs;
+    auto indices = slots.indices(signature.vec_size);
+    // Replicas past the slot count do not exist
+    size_t slot_count = encoder_ptr->getSlotCnt();
+    while (!indices.empty() && indices.back() >= slot_count) {
+      indices.pop_back();
+    }
+    return decryptItems<T>(items, signature, &indices);
   }
 
+  /**
+   * @brief Noise budget of a BFV ciphertext in bits, 0 once it no longer
+   * decrypts correctly
+   */
+  double noiseBudget(const seal::Ciphertext &cipher) {
+    return m_decryptor.invariant_noise_budget(cipher);
+  }
+
+  /**
+   * @brief log2 of the largest imaginary part of a CKKS ciphertext holding
+   * real slots, which is the error of the computation. -inf when exact.
+   */
+  double imagErrorBits(const seal::Ciphertext &cipher) {
+    seal::Plaintext plain;
+    m_decryptor.decrypt(cipher, plain);
+    ValuationType decode_vec;
+    encoder_ptr->decodeComplex(plain, decode_vec);
+    double max_imag = 0;
+    for (auto &slot : std::get<std::vector<std::complex<double>>>(decode_vec)) {
+      max_imag = std::max(max_imag, std::abs(slot.imag()));
+    }
+    return std::log2(max_imag);
+  }
+
+  /**
+   * @brief Secret key, for clients encrypting in SYMMETRIC_MODE
+   */
+  const seal::SecretKey &getSecretKey() const { return m_secret_key; }
+
  private:
+  /**
+   * @brief Decrypt the given outputs concurrently.
+   * @param [in] indices Slots to keep, nullptr keeps vec_size slots
+   */
+  template <typename T>
+  Valuation decryptItems(
+      const std::vector<const std::pair<const std::string, SchemeValue> *>
+          &items,
+      const SealSignature &signature, const std::vector<uint32_t> *indices) {
+    Valuation outputs;
+    std::vector<ValuationType> values(items.size());
+    std::lock_guard<std::mutex> lock(m_encoders_mutex);
+    uint32_t thread_num = m_encoders.prepare(items.size());
+    // Decryptor is not declared thread-safe, every extra worker thread gets
+    // its own.
+    if (m_decryptors.size() < thread_num) m_decryptors.resize(thread_num);
+    parallelFor(
+        items.size(),
+        [&](size_t idx, size_t thread_id) {
+          seal::Decryptor *decryptor = &m_decryptor;
+          if (thread_num > 1) {
+            auto &local = m_decryptors[thread_id];
+            if (!local) {
+              local =
+                  std::make_unique<seal::Decryptor>(m_context, m_secret_key);
+            }
+            decryptor = local.get();
+          }
+          values[idx] = decryptOne<T>(items[idx]->first, items[idx]->second,
+                                      signature, *decryptor,
+                                      m_encoders.get(thread_id), indices);
+        },
+        thread_num);
+    for (size_t i = 0; i < items.size(); ++i) {
+      outputs[items[i]->first] = std::move(values[i]);
+    }
+    return outputs;
+  }
+
+  /**
+   * @brief Decrypt and decode one output, thread-safe for distinct
+   * decryptors and encoders.
+   */
+  template <typename T>
+  ValuationType decryptOne(const std::string &name, const SchemeValue &value,
+                           const SealSignature &signature,
+                           seal::Decryptor &decryptor,
+                           SealEncoderBase &encoder,
+                           const std::vector<uint32_t> *indices) {
+    if (signature.complex_outputs.count(name)) {
+      auto decode_vec =
+          decryptComplex(name, value, signature, decryptor, encoder);
+      if (indices) pickSlots(decode_vec, *indices);
+      return decode_vec;
+    }
+    ValuationType decode_vec;
+    auto decodePlain = [&](const seal::Plaintext &plain) {
+      if (indices) {
+        encoder.decodeSlots(plain, *indices, decode_vec);
+      } else {
+        encoder.decode(plain, decode_vec);
+      }
+    };
+    visit(Overloaded{[&](const seal::Ciphertext &cipher) {
+                       seal::Plaintext plain;
+                       decryptor.decrypt(cipher, plain);
+                       decodePlain(plain);
+                     },
+                     [&](const seal::Plaintext &plain) { decodePlain(plain); },
+                     [&](const std::shared_ptr<ConstantValue<double>> &raw) {
+                       std::vector<double> temp_vec;
+                       decode_vec = raw->expand(temp_vec, signature.vec_size);
+                     },
+                     [&](const std::shared_ptr<ConstantValue<int64_t>> &raw) {
+                       std::vector<int64_t> temp_vec;
+                       decode_vec = raw->expand(temp_vec, signature.vec_size);
+                     }},
+          value);
+    if (!indices) {
+      std::get<vector<T>>(decode_vec).resize(signature.vec_size);
+    } else if (!std::holds_alternative<seal::Ciphertext>(value) &&
+               !std::holds_alternative<seal::Plaintext>(value)) {
+      // Raw values were expanded in full, decodeSlots covered the others
+      pickSlots(decode_vec, *indices);
+    }
+    return decode_vec;
+  }
+
+  /**
+   * @brief Decrypt one output holding complex slots.
+   */
+  ValuationType decryptComplex(const std::string &name,
+                               const SchemeValue &value,
+                               const SealSignature &signature,
+                               seal::Decryptor &decryptor,
+                               SealEncoderBase &encoder) {
+    ValuationType decode_vec;
+    if (std::holds_alternative<seal::Ciphertext>(value)) {
+      seal::Plaintext plain;
+      decryptor.decrypt(std::get<seal::Ciphertext>(value), plain);
+      encoder.decodeComplex(plain, decode_vec);
+    } else if (std::holds_alternative<seal::Plaintext>(value)) {
+      encoder.decodeComplex(std::get<seal::Plaintext>(value), decode_vec);
+    } else {
+      throw std::logic_error("complex output " + name + " is not encoded");
+    }
+    auto &v = std::get<std::vector<std::complex<double>>>(decode_vec);
+    v.resize(signature.vec_size);
+    return decode_vec;
+  }
+
   seal::SEALContext m_context;
   seal::SecretKey m_secret_key;
 
   // seal::CkksEncoder m_encoder;
   std::shared_ptr<SealEncoderBase> encoder_ptr;
   seal::Decryptor m_decryptor;
+  // Per-thread encoders and decryptors reused by every decrypt, one decrypt
+  // at a time
+  ThreadEncoders m_encoders;
+  std::vector<std::unique_ptr<seal::Decryptor>> m_decryptors;
+  std::mutex m_encoders_mutex;
 
   friend std::unique_ptr<msg::SEALSecret> serialize(const SEALSecret &);
 };
@@ -66,7 +66,19 @@ class SEALValuation {
     // });
     for (auto &item : p_valuation->m_values) {
       m_values[item.first] = std::move(item.second);
+      m_seeded.erase(item.first);
     }
+    for (auto &item : p_valuation->m_seeded) {
+      m_seeded[item.first] = std::move(item.second);
+    }
+  }
+
+  /**
+   * @brief Keep the seeded serialization of a symmetric ciphertext, it is
+   * written instead of the full ciphertext by serialize
+   */
+  void setSeeded(const std::string &name, std::string data) {
+    m_seeded[name] = std::move(data);
   }
 
   bool isEmpty() { return m_values.empty(); }
@@ -74,6 +86,7 @@ class SEALValuation {
  private:
   seal::EncryptionParameters params;  // For deserialization, context content is needed, so keeping it here.
   std::unordered_map<std::string, SchemeValue> m_values;
+  std::unordered_map<std::string, std::string> m_seeded;
 
   friend std::unique_ptr<msg::SEALValuation> serialize(const SEALValuation &);
 };
@@ -0,0 +1,186 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "seal_zero_pool.h"
+
+#include <stdexcept>
+
+namespace iyfc {
+
+SealZeroPool::SealZeroPool(seal::SEALContext ctx, const seal::PublicKey &pk,
+                           const EncryptPoolConfig &config)
+    : m_context(ctx), m_encryptor(ctx, pk), m_config(config) {}
+
+SealZeroPool::~SealZeroPool() { stopRefill(); }
+
+void SealZeroPool::reserve(const seal::parms_id_type &parms_id) {
+  if (!m_context.get_context_data(parms_id)) {
+    throw std::logic_error("SealZeroPool reserve: parms_id not in context");
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_zeros[parms_id];
+  }
+  m_cv.notify_one();
+}
+
+bool SealZeroPool::needRefill(seal::parms_id_type &parms_id) const {
+  // Refill the emptiest level first
+  size_t min_size = m_config.size_per_level;
+  for (auto &level : m_zeros) {
+    if (level.second.size() < min_size) {
+      min_size = level.second.size();
+      parms_id = level.first;
+    }
+  }
+  return min_size < m_config.size_per_level;
+}
+
+void SealZeroPool::fill() {
+  auto pool = seal::MemoryManager::GetPool(
+      seal::mm_prof_opt::mm_force_thread_local);
+  seal::parms_id_type parms_id;
+  while (true) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (!needRefill(parms_id)) return;
+    }
+    seal::Ciphertext zero;
+    m_encryptor.encrypt_zero(parms_id, zero, pool);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_zeros[parms_id].push_back(std::move(zero));
+    m_generated++;
+  }
+}
+
+void SealZeroPool::refillLoop() {
+  auto pool = seal::MemoryManager::GetPool(
+      seal::mm_prof_opt::mm_force_thread_local);
+  seal::parms_id_type parms_id;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cv.wait(lock, [&] { return m_stop || needRefill(parms_id); });
+      if (m_stop) return;
+    }
+    seal::Ciphertext zero;
+    m_encryptor.encrypt_zero(parms_id, zero, pool);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_zeros[parms_id].push_back(std::move(zero));
+    m_generated++;
+  }
+}
+
+void SealZeroPool::startRefill() {
+  if (m_refill_thread.joinable()) return;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = false;
+  }
+  m_refill_thread = std::thread(&SealZeroPool::refillLoop, this);
+}
+
+void SealZeroPool::stopRefill() {
+  if (!m_refill_thread.joinable()) return;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_cv.notify_all();
+  m_refill_thread.join();
+}
+
+bool SealZeroPool::take(const seal::parms_id_type &parms_id,
+                        seal::Ciphertext &cipher) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto iter = m_zeros.find(parms_id);
+    if (iter == m_zeros.end() || iter->second.empty()) {
+      m_misses++;
+      return false;
+    }
+    cipher = std::move(iter->second.front());
+    iter->second.pop_front();
+    m_hits++;
+  }
+  m_cv.notify_one();
+  return true;
+}
+
+EncryptPoolMetrics SealZeroPool::metrics() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  EncryptPoolMetrics metrics;
+  metrics.hits = m_hits;
+  metrics.misses = m_misses;
+  metrics.generated = m_generated;
+  for (auto &level : m_zeros) {
+    metrics.available += level.second.size();
+  }
+  return metrics;
+}
+
+void SealZeroPool::save(std::ostream &stream) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  uint64_t level_cnt = m_zeros.size();
+  stream.write(reinterpret_cast<const char *>(&level_cnt), sizeof(level_cnt));
+  for (auto &level : m_zeros) {
+    stream.write(reinterpret_cast<const char *>(level.first.data()),
+                 sizeof(seal::parms_id_type));
+    uint64_t cnt = level.second.size();
+    stream.write(reinterpret_cast<const char *>(&cnt), sizeof(cnt));
+    for (auto &zero : level.second) {
+      zero.save(stream);
+    }
+    level.second.clear();
+  }
+  if (!stream) {
+    throw std::logic_error("SealZeroPool save: write failed");
+  }
+}
+
+void SealZeroPool::load(std::istream &stream) {
+  uint64_t level_cnt = 0;
+  stream.read(reinterpret_cast<char *>(&level_cnt), sizeof(level_cnt));
+  for (uint64_t i = 0; stream && i < level_cnt; i++) {
+    seal::parms_id_type parms_id;
+    uint64_t cnt = 0;
+    stream.read(reinterpret_cast<char *>(parms_id.data()),
+                sizeof(seal::parms_id_type));
+    stream.read(reinterpret_cast<char *>(&cnt), sizeof(cnt));
+    std::deque<seal::Ciphertext> zeros;
+    for (uint64_t j = 0; stream && j < cnt; j++) {
+      seal::Ciphertext zero;
+      // load checks that the ciphertext is valid for the context
+      zero.load(m_context, stream);
+      zeros.push_back(std::move(zero));
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto &level = m_zeros[parms_id];
+    for (auto &zero : zeros) level.push_back(std::move(zero));
+  }
+  if (!stream) {
+    throw std::logic_error("SealZeroPool load: truncated stream");
+  }
+}
+
+}  // namespace iyfc
@@ -0,0 +1,108 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <seal/seal.h>
+
+#include <condition_variable>
+#include <deque>
+#include <istream>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+#include "comm_include.h"
+
+namespace iyfc {
+
+/**
+ * @class SealZeroPool
+ * @brief Pool of public-key encryptions of zero, one queue per level.
+ * @details Sampling the encryption randomness and multiplying by the public
+ * key dominate SEAL encryption. The pool does this offline, online encryption
+ * takes one entry and adds the encoded plaintext. Every entry is handed out
+ * at most once.
+ */
+class SealZeroPool {
+ public:
+  SealZeroPool(seal::SEALContext ctx, const seal::PublicKey &pk,
+               const EncryptPoolConfig &config);
+  ~SealZeroPool();
+
+  /**
+   * @brief Keep the level of parms_id filled
+   */
+  void reserve(const seal::parms_id_type &parms_id);
+
+  /**
+   * @brief Fill all reserved levels up to size_per_level on this thread
+   */
+  void fill();
+
+  /**
+   * @brief Start / stop the background refill thread
+   */
+  void startRefill();
+  void stopRefill();
+
+  /**
+   * @brief Take one encryption of zero at parms_id
+   * @return false if the level is empty (counted as a miss)
+   */
+  bool take(const seal::parms_id_type &parms_id, seal::Ciphertext &cipher);
+
+  EncryptPoolMetrics metrics() const;
+
+  /**
+   * @brief Persist pooled entries, the pool is emptied so that no entry
+   * can be used twice
+   */
+  void save(std::ostream &stream);
+
+  /**
+   * @brief Load entries saved by save(), throws if they do not belong to
+   * the context
+   */
+  void load(std::istream &stream);
+
+ private:
+  bool needRefill(seal::parms_id_type &parms_id) const;
+  void refillLoop();
+
+  seal::SEALContext m_context;
+  seal::Encryptor m_encryptor;
+  EncryptPoolConfig m_config;
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::map<seal::parms_id_type, std::deque<seal::Ciphertext>> m_zeros;
+  std::thread m_refill_thread;
+  bool m_stop{false};
+
+  uint64_t m_hits{0};
+  uint64_t m_misses{0};
+  uint64_t m_generated{0};
+};
+
+}  // namespace iyfc
@@ -0,0 +1,95 @@
+
+/*
+*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "dag/request_batcher.h"
+#include "iyfc_include.h"
+#include "test_comm.h"
+
+using namespace std;
+using namespace iyfc;
+
+namespace iyfctest {
+
+// The constant is a T, so int64_t compiles to seal_bfv and double to
+// seal_ckks
+template <typename T>
+void checkRequestBatcher(const string& dag_name, const string& lib_name) {
+  const T one = 1;
+  DagPtr dag = initDag(dag_name, 64);
+  Expr x1 = setInputName(dag, "x1");
+  Expr x2 = setInputName(dag, "x2");
+  setOutput(dag, "test_out", x1 * x2 + x1 + one);
+  compileDag(dag);
+  checkLib(dag, lib_name);
+  genKeys(dag);
+
+  BatchConfig config;
+  config.max_latency_ms = 1000;
+  vector<vector<T>> expects;
+  vector<future<Valuation>> results;
+  {
+    RequestBatcher batcher(dag, config);
+    EXPECT_GT(batcher.capacity(), 8u);
+    for (int req = 0; req < 8; req++) {
+      vector<T> vec_x1, vec_out;
+      T x2_value = static_cast<T>(req % 4);
+      for (int i = 0; i < 64; i++) {
+        vec_x1.emplace_back(static_cast<T>(rand() % 8));
+        vec_out.emplace_back(vec_x1[i] * x2_value + vec_x1[i] + one);
+      }
+      results.push_back(batcher.submit({{"x1", vec_x1}, {"x2", x2_value}}));
+      expects.push_back(vec_out);
+    }
+    batcher.flush();
+    for (size_t req = 0; req < results.size(); req++) {
+      check_result(results[req].get(), expects[req], 0.01);
+    }
+    // Every request went into the same execution
+    EXPECT_EQ(batcher.batchesRun(), 1u);
+  }
+  releaseDag(dag);
+}
+
+TEST(TEST_BATCH, seal_ckks_request_batcher) {
+  checkRequestBatcher<double>("BATCH_CKKS", "seal_ckks");
+}
+
+TEST(TEST_BATCH, seal_bfv_request_batcher) {
+  checkRequestBatcher<int64_t>("BATCH_BFV", "seal_bfv");
+}
+
+TEST(TEST_BATCH, rotation_runs_alone) {
+  DagPtr dag = initDag("BATCH_ROTATION", 64);
+  Expr x1 = setInputName(dag, "x1");
+  setOutput(dag, "test_out", x1 + (x1 << 1));
+  compileDag(dag);
+  genKeys(dag);
+  {
+    RequestBatcher batcher(dag);
+    EXPECT_EQ(batcher.capacity(), 1u);
+  }
+  releaseDag(dag);
+}
+
+}  // namespace iyfctest
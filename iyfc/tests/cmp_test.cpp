@@ -24,6 +24,7 @@
 
 // Comparison operator testing
 #include "test_comm.h"
+#include "util/math_util.h"
 
 using namespace std;
 using namespace iyfc;
@@ -75,4 +76,46 @@ TEST_CMP_EXPR(less_eq, <=);
 TEST_CMP_EXPR(more, >);
 TEST_CMP_EXPR(more_eq, >=);
 
+// Tiles hold the same slots as the single-ciphertext encoding of their rows
+TEST(TEST_CMP, encode_tiles) {
+  // Two full tiles and a partial one
+  vector<uint32_t> vec_org;
+  for (int i = 0; i < 2 * MAX_CMP_NUM + 5; i++) {
+    vec_org.emplace_back(static_cast<uint32_t>(rand()));
+  }
+  Valuation tiles;
+  EXPECT_EQ(encodeOrgInputforCmpTiles(vec_org, "x", tiles), 3u);
+  ASSERT_EQ(tiles.size(), 3u);
+  for (uint32_t t = 0; t < 3; t++) {
+    auto begin = vec_org.begin() + t * MAX_CMP_NUM;
+    vector<uint32_t> rows(begin, min(begin + MAX_CMP_NUM, vec_org.end()));
+    Valuation expect;
+    encodeOrgInputforCmp(rows, "x", expect);
+    ASSERT_TRUE(tiles.count("x_" + to_string(t)));
+    EXPECT_EQ(get<vector<double>>(tiles["x_" + to_string(t)]),
+              get<vector<double>>(expect["x"]))
+        << "tile " << t;
+  }
+}
+
+// Rows of every block, including a partial last one, match decimalConvert
+// for a specialized base and a generic one
+TEST(TEST_CMP, bulk_decimal_convert) {
+  const uint32_t bits = 16;
+  vector<uint32_t> vec_org;
+  for (int i = 0; i < 600; i++) {
+    vec_org.emplace_back(static_cast<uint32_t>(rand()));
+  }
+  for (uint32_t k : {4u, 5u}) {
+    vector<double> dst(vec_org.size() * bits, -1.0);
+    bulkDecimalConvert(vec_org.data(), vec_org.size(), k, bits, dst.data());
+    for (size_t r = 0; r < vec_org.size(); r++) {
+      auto digits = decimalConvert(vec_org[r], k, bits);
+      for (uint32_t j = 0; j < bits; j++) {
+        EXPECT_EQ(dst[r * bits + j], digits[j]) << "base " << k << " row " << r;
+      }
+    }
+  }
+}
+
 }  // namespace iyfctest
\ No newline at end of file
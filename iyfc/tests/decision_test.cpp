@@ -22,6 +22,8 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
  */
+#include "daghandler/traversal_handler.h"
+#include "daghandler/type_handler.h"
 #include "iyfc_include.h"
 #include "test_comm.h"
 
@@ -29,12 +31,6 @@ using namespace std;
 using namespace iyfc;
 
 namespace iyfctest {
-void checkLib(DagPtr dag, const string& lib_name) {
-  vector<string> vec_libs = getLibInfo(dag);
-  if (vec_libs.size() == 0) FAIL();
-  EXPECT_EQ(vec_libs[0], lib_name);
-}
-
 #define TEST_EXPR_ONE_LIB(NAME, EXPR, TYPE, LIB_NAME)       \
   TEST(TEST_DECIDION, NAME) {                               \
     vector<TYPE> vec_input;                                 \
@@ -126,4 +122,271 @@ TEST(TEST_DECIDION, use_concrete) {
   releaseDag(dag);
 }
 
+// Long chains compile in linear time, the old traversal rescanned all
+// sources after every node
+TEST(TEST_DECIDION, long_add_chain) {
+  const int chain_len = 10000;
+  vector<int64_t> vec_input;
+  vector<int64_t> vec_out;
+  for (int i = 0; i < 1024; i++) {
+    vec_input.emplace_back(rand() % 2);
+    vec_out.emplace_back(vec_input.back() * (chain_len + 1));
+  }
+  DagPtr dag = initDag("DECISION", 1024);
+  Expr x = setInputName(dag, "x");
+  // The int64 constant selects seal_bfv
+  Expr z = x + static_cast<int64_t>(0);
+  for (int i = 0; i < chain_len; i++) z = z + x;
+  Valuation inputs{{"x", vec_input}};
+  Valuation output = execute(inputs, dag, z);
+  checkLib(dag, "seal_bfv");
+  check_result(output, vec_out, 0.0);
+  releaseDag(dag);
+}
+
+// An 81 bit output used to take 40, 40 and 20 bit primes, the parameter
+// search splits it into two primes
+TEST(TEST_DECIDION, seal_ckks_split_output_primes) {
+  vector<double> vec_input;
+  vector<double> vec_out;
+  for (int i = 0; i < 1024; i++) {
+    vec_input.emplace_back(static_cast<double>(rand() % 8));
+    vec_out.emplace_back(vec_input.back() * vec_input.back() + 1.0);
+  }
+  DagPtr dag = initDag("DECISION", 1024);
+  setScale(dag, 40);
+  Expr x = setInputName(dag, "x");
+  setOutput(dag, "z", x * x + 1.0);
+  setOutputRange(dag, "z", 41);
+  compileDag(dag);
+  genKeys(dag);
+  Valuation inputs{{"x", vec_input}};
+  encryptInput(dag, inputs);
+  exeDag(dag);
+  Valuation output;
+  decryptOutput(dag, output);
+  checkLib(dag, "seal_ckks");
+  check_result(output, vec_out, 0.01);
+
+  // 41 and 40 bit output primes and the 40 bit rescale prime
+  NoiseReport report;
+  EXPECT_EQ(estimateNoise(dag, report), 0);
+  EXPECT_EQ(report.poly_modulus_degree, 8192u);
+  EXPECT_EQ(report.primes, 3u);
+  releaseDag(dag);
+}
+
+// A sum of products pays one rescale with the lazy rescaler, one per term
+// with the eager one, the default picks lazy by its predicted cost
+TEST(TEST_DECIDION, seal_ckks_lazy_rescale) {
+  const int term_cnt = 8;
+  vector<vector<double>> vec_x(term_cnt), vec_y(term_cnt);
+  vector<double> vec_z;
+  vector<double> vec_out(1024, 0.0);
+  for (int i = 0; i < 1024; i++) {
+    vec_z.emplace_back(static_cast<double>(rand() % 4));
+    for (int j = 0; j < term_cnt; j++) {
+      vec_x[j].emplace_back(static_cast<double>(rand() % 4));
+      vec_y[j].emplace_back(static_cast<double>(rand() % 4));
+      vec_out[i] += vec_x[j].back() * vec_y[j].back();
+    }
+    vec_out[i] *= vec_z.back();
+  }
+  for (auto strategy : {EAGER_RESCALE, LAZY_RESCALE, AUTO_RESCALE}) {
+    DagPtr dag = initDag("DECISION", 1024);
+    setRescaleStrategy(dag, strategy);
+    Valuation inputs{{"z", vec_z}};
+    Expr z = setInputName(dag, "z");
+    Expr sum = setInputName(dag, "x0") * setInputName(dag, "y0");
+    inputs["x0"] = vec_x[0];
+    inputs["y0"] = vec_y[0];
+    for (int j = 1; j < term_cnt; j++) {
+      string x_name = "x" + to_string(j);
+      string y_name = "y" + to_string(j);
+      sum = sum + setInputName(dag, x_name) * setInputName(dag, y_name);
+      inputs[x_name] = vec_x[j];
+      inputs[y_name] = vec_y[j];
+    }
+    Expr out = sum * z;
+    Valuation output = execute(inputs, dag, out);
+    checkLib(dag, "seal_ckks");
+    check_result(output, vec_out, 0.01);
+
+    RescaleReport report;
+    getRescaleReport(dag, report);
+    EXPECT_EQ(report.chain_length, 2u);
+    EXPECT_LT(report.lazy_cost, report.eager_cost);
+    if (strategy == EAGER_RESCALE) {
+      EXPECT_EQ(report.strategy, EAGER_RESCALE);
+      EXPECT_EQ(report.rescales, static_cast<uint32_t>(term_cnt + 1));
+    } else {
+      EXPECT_EQ(report.strategy, LAZY_RESCALE);
+      EXPECT_EQ(report.rescales, 2u);
+    }
+    releaseDag(dag);
+  }
+}
+
+// A product shared by two sums stays unrelinearized, only the sums are
+// relinearized before the outputs
+TEST(TEST_DECIDION, seal_bfv_shared_product_relin) {
+  const vector<string> names{"x", "y", "a", "b", "c", "d"};
+  Valuation inputs;
+  vector<vector<int64_t>> vecs(names.size());
+  for (size_t j = 0; j < names.size(); j++) {
+    for (int i = 0; i < 1024; i++) vecs[j].emplace_back(rand() % 8);
+    inputs[names[j]] = vecs[j];
+  }
+  DagPtr dag = initDag("DECISION", 1024);
+  vector<Expr> exprs;
+  for (auto& name : names) exprs.emplace_back(setInputName(dag, name));
+  Expr p = exprs[0] * exprs[1];
+  // The int64 constant selects seal_bfv
+  setOutput(dag, "u", p + exprs[2] * exprs[3] + static_cast<int64_t>(1));
+  setOutput(dag, "v", p - exprs[4] * exprs[5]);
+  compileDag(dag);
+  checkLib(dag, "seal_bfv");
+  // The greedy placement also relinearizes the shared product
+  RelinReport report;
+  getRelinReport(dag, report);
+  EXPECT_EQ(report.relins, 2u);
+  EXPECT_EQ(report.lazy_relins, report.relins + 1);
+  genKeys(dag);
+  encryptInput(dag, inputs);
+  exeDag(dag);
+  Valuation output;
+  decryptOutput(dag, output);
+  auto& u = get<vector<int64_t>>(output["u"]);
+  auto& v = get<vector<int64_t>>(output["v"]);
+  for (int i = 0; i < 1024; i++) {
+    int64_t product = vecs[0][i] * vecs[1][i];
+    EXPECT_EQ(u[i], product + vecs[2][i] * vecs[3][i] + 1);
+    EXPECT_EQ(v[i], product - vecs[4][i] * vecs[5][i]);
+  }
+  releaseDag(dag);
+}
+
+// Declared input ranges size the BFV plaintext modulus to the outputs
+TEST(TEST_DECIDION, seal_bfv_input_range) {
+  vector<int64_t> vec_x;
+  vector<int64_t> vec_y;
+  vector<int64_t> vec_out;
+  for (int i = 0; i < 1024; i++) {
+    vec_x.emplace_back(rand() % 1024 - 512);
+    vec_y.emplace_back(rand() % 1024);
+    vec_out.emplace_back((vec_x.back() + 10) * vec_y.back() - vec_x.back());
+  }
+  DagPtr dag = initDag("DECISION", 1024);
+  Expr x = setInputName(dag, "x");
+  Expr y = setInputName(dag, "y");
+  setInputRange(dag, "x", 10);
+  setInputRange(dag, "y", 10);
+  Expr z = (x + 10) * y - x;
+  Valuation inputs{{"x", vec_x}, {"y", vec_y}};
+  Valuation output = execute(inputs, dag, z);
+  checkLib(dag, "seal_bfv");
+  check_result(output, vec_out, 0.0);
+  releaseDag(dag);
+}
+
+// Small outputs still get a plaintext modulus with a batching prime, which
+// no size right above 2N has
+TEST(TEST_DECIDION, seal_bfv_small_input_range) {
+  vector<int64_t> vec_x;
+  vector<int64_t> vec_out;
+  for (int i = 0; i < 1024; i++) {
+    vec_x.emplace_back(rand() % 7 - 3);
+    vec_out.emplace_back(vec_x.back() * vec_x.back() + 1);
+  }
+  DagPtr dag = initDag("DECISION", 1024);
+  Expr x = setInputName(dag, "x");
+  setInputRange(dag, "x", 2);
+  Expr z = x * x + 1;
+  Valuation inputs{{"x", vec_x}};
+  Valuation output = execute(inputs, dag, z);
+  checkLib(dag, "seal_bfv");
+  check_result(output, vec_out, 0.0);
+  releaseDag(dag);
+}
+
+TEST(TEST_DECIDION, seal_bfv_mod_switch_product) {
+  // Set membership product, the late products run over fewer primes
+  const int item_cnt = 8;
+  vector<vector<int64_t>> vec_items(item_cnt);
+  vector<int64_t> vec_y;
+  vector<int64_t> vec_out(1024, 1);
+  for (int i = 0; i < 1024; i++) {
+    vec_y.emplace_back(rand() % 8);
+    for (int j = 0; j < item_cnt; j++) {
+      vec_items[j].emplace_back(rand() % 8);
+      vec_out[i] *= vec_items[j].back() - vec_y.back();
+    }
+  }
+  DagPtr dag = initDag("DECISION", 1024);
+  Expr y = setInputName(dag, "y");
+  setInputRange(dag, "y", 3);
+  Valuation inputs{{"y", vec_y}};
+  vector<Expr> terms;
+  for (int j = 0; j < item_cnt; j++) {
+    string name = "x" + to_string(j);
+    Expr x = setInputName(dag, name);
+    setInputRange(dag, name, 3);
+    inputs[name] = vec_items[j];
+    terms.emplace_back(x - y);
+  }
+  while (terms.size() > 1) {
+    vector<Expr> next;
+    for (size_t j = 0; j < terms.size(); j += 2) {
+      next.emplace_back(terms[j] * terms[j + 1]);
+    }
+    terms = next;
+  }
+  // The int64 constant selects seal_bfv
+  Expr out = terms[0] + static_cast<int64_t>(0);
+  Valuation output = execute(inputs, dag, out);
+  checkLib(dag, "seal_bfv");
+  check_result(output, vec_out, 0.0);
+
+  // The output is left below the top level
+  NoiseReport report;
+  EXPECT_EQ(estimateNoise(dag, report), 0);
+  ASSERT_EQ(report.outputs.count("test_out"), 1);
+  EXPECT_LT(report.outputs["test_out"].primes, report.primes);
+  releaseDag(dag);
+}
+
+// After a local rewrite only the rewired nodes and the uses whose operand
+// type changed are retyped, to the types a full inference gives
+TEST(TEST_DECIDION, incremental_type_inference) {
+  Dag dag("RETYPE", 1024);
+  NodePtr x = dag.makeInput("x");
+  NodePtr w = dag.makeDenseConstant({2.0});
+  NodePtr a = dag.makeNode(OpType::Add, {x, w});
+  NodePtr b = dag.makeNode(OpType::Mul, {w, w});
+  NodePtr d = dag.makeNode(OpType::Add, {b, w});
+  NodePtr e = dag.makeNode(OpType::Mul, {a, d});
+  dag.makeOutput("out", e);
+
+  NodeMap<DataType> types(dag);
+  TypeInference inference(dag, types);
+  inference.update();
+  EXPECT_EQ(inference.retypedCnt(), 7u);
+  EXPECT_EQ(types[d], DataType::Raw);
+  EXPECT_EQ(types[e], DataType::Cipher);
+
+  // d now reads the cipher a instead of the raw b
+  ASSERT_TRUE(d->replaceOperand(b, a));
+  inference.update();
+  // b, d and a were rewired, e follows the new type of d
+  EXPECT_EQ(inference.retypedCnt(), 4u);
+  EXPECT_EQ(types[d], DataType::Cipher);
+
+  NodeMap<DataType> full_types(dag);
+  TypeInference full(dag, full_types);
+  full.update();
+  DagTraversal(dag).forwardPass([&](NodePtr& node) {
+    EXPECT_EQ(types[node], full_types[node]) << node->m_index;
+  });
+}
+
 }  // namespace iyfctest
\ No newline at end of file
@@ -0,0 +1,302 @@
+
+/*
+*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "iyfc_include.h"
+#include "test_comm.h"
+
+using namespace std;
+using namespace iyfc;
+
+namespace iyfctest {
+
+// The constant of each DAG is a T, so int64_t DAGs compile to seal_bfv and
+// double DAGs to seal_ckks
+
+template <typename T>
+void checkEncryptPool(const string& dag_name, const string& lib_name,
+                      bool refill_thread) {
+  const T one = 1;
+  vector<T> vec_x1, vec_x2, vec_out;
+  for (int i = 0; i < 1024; i++) {
+    vec_x1.emplace_back(static_cast<T>(rand() % 8));
+    vec_x2.emplace_back(static_cast<T>(rand() % 8));
+    vec_out.emplace_back(vec_x1[i] * vec_x2[i] + vec_x1[i] + one);
+  }
+  DagPtr dag = initDag(dag_name, 1024);
+  Expr x1 = setInputName(dag, "x1");
+  Expr x2 = setInputName(dag, "x2");
+  setOutput(dag, "test_out", x1 * x2 + x1 + one);
+  compileDag(dag);
+  checkLib(dag, lib_name);
+  genKeys(dag);
+
+  EncryptPoolConfig config;
+  config.size_per_level = 4;
+  config.refill_thread = refill_thread;
+  setEncryptPool(dag, config);
+
+  Valuation inputs{{"x1", vec_x1}, {"x2", vec_x2}};
+  encryptInput(dag, inputs);
+  exeDag(dag);
+  Valuation output;
+  decryptOutput(dag, output);
+  check_result(output, vec_out, 0.01);
+
+  EncryptPoolMetrics metrics;
+  getEncryptPoolMetrics(dag, metrics);
+  if (refill_thread) {
+    // The refill thread may not have produced the entries yet
+    EXPECT_EQ(metrics.hits + metrics.misses, 2u);
+  } else {
+    EXPECT_EQ(metrics.hits, 2u);
+    EXPECT_EQ(metrics.misses, 0u);
+    EXPECT_EQ(metrics.available + metrics.hits, metrics.generated);
+  }
+
+  config.size_per_level = 0;
+  setEncryptPool(dag, config);
+  getEncryptPoolMetrics(dag, metrics);
+  EXPECT_EQ(metrics.generated, 0u);
+  releaseDag(dag);
+}
+
+TEST(TEST_ENCRYPT, seal_ckks_encrypt_pool) {
+  checkEncryptPool<double>("ENCRYPT_POOL_CKKS", "seal_ckks", false);
+}
+
+TEST(TEST_ENCRYPT, seal_bfv_encrypt_pool) {
+  checkEncryptPool<int64_t>("ENCRYPT_POOL_BFV", "seal_bfv", false);
+}
+
+TEST(TEST_ENCRYPT, seal_ckks_encrypt_pool_refill_thread) {
+  checkEncryptPool<double>("ENCRYPT_POOL_THREAD", "seal_ckks", true);
+}
+
+template <typename T>
+void checkSymmetricEncrypt(const string& dag_name, const string& lib_name) {
+  const T one = 1;
+  vector<T> vec_x1, vec_x2, vec_out;
+  for (int i = 0; i < 1024; i++) {
+    vec_x1.emplace_back(static_cast<T>(rand() % 8));
+    vec_x2.emplace_back(static_cast<T>(rand() % 8));
+    vec_out.emplace_back(vec_x1[i] * vec_x2[i] + vec_x1[i] + one);
+  }
+  DagPtr dag = initDag(dag_name, 1024);
+  Expr x1 = setInputName(dag, "x1");
+  Expr x2 = setInputName(dag, "x2");
+  setOutput(dag, "test_out", x1 * x2 + x1 + one);
+  compileDag(dag);
+  checkLib(dag, lib_name);
+  genKeys(dag);
+  Valuation inputs{{"x1", vec_x1}, {"x2", vec_x2}};
+
+  string str_public;
+  encryptInput(dag, inputs, true);
+  savaInputTostr(dag, str_public);
+
+  string str_seeded;
+  setEncryptMode(dag, SYMMETRIC_MODE);
+  encryptInput(dag, inputs, true);
+  savaInputTostr(dag, str_seeded);
+  EXPECT_LT(str_seeded.size(), str_public.size() * 3 / 4);
+
+  // Server side: the seeded ciphertexts are expanded on load
+  loadInputFromStr(dag, str_seeded, true);
+  exeDag(dag);
+  Valuation output;
+  decryptOutput(dag, output);
+  check_result(output, vec_out, 0.01);
+  releaseDag(dag);
+}
+
+TEST(TEST_ENCRYPT, seal_ckks_symmetric_seeded) {
+  checkSymmetricEncrypt<double>("SYMMETRIC_CKKS", "seal_ckks");
+}
+
+TEST(TEST_ENCRYPT, seal_bfv_symmetric_seeded) {
+  checkSymmetricEncrypt<int64_t>("SYMMETRIC_BFV", "seal_bfv");
+}
+
+template <typename T>
+void checkPartialDecrypt(const string& dag_name, const string& lib_name) {
+  const T one = 1;
+  vector<T> vec_x1, vec_x2, vec_out;
+  for (int i = 0; i < 1024; i++) {
+    vec_x1.emplace_back(static_cast<T>(rand() % 8));
+    vec_x2.emplace_back(static_cast<T>(rand() % 8));
+    vec_out.emplace_back(vec_x1[i] * vec_x2[i] + vec_x1[i] + one);
+  }
+  DagPtr dag = initDag(dag_name, 1024);
+  Expr x1 = setInputName(dag, "x1");
+  Expr x2 = setInputName(dag, "x2");
+  setOutput(dag, "test_out", x1 * x2 + x1 + one);
+  setOutput(dag, "skipped_out", x1 + x2);
+  compileDag(dag);
+  checkLib(dag, lib_name);
+  genKeys(dag);
+  Valuation inputs{{"x1", vec_x1}, {"x2", vec_x2}};
+  encryptInput(dag, inputs);
+  exeDag(dag);
+
+  // A few slots, BFV evaluates them without decoding the whole vector
+  SlotSelection slots;
+  slots.offset = 3;
+  slots.stride = 16;
+  slots.count = 3;
+  Valuation output;
+  decryptPartialOutput(dag, {"test_out"}, output, slots);
+  EXPECT_EQ(output.count("skipped_out"), 0u);
+  auto& few = std::get<vector<T>>(output["test_out"]);
+  ASSERT_EQ(few.size(), 3u);
+  for (uint32_t i = 0; i < few.size(); i++) {
+    EXPECT_NEAR(few[i], vec_out[3 + 16 * i], 0.01);
+  }
+
+  // Every 16th slot up to the end
+  slots.offset = 0;
+  slots.count = 0;
+  output.clear();
+  decryptPartialOutput(dag, {"test_out"}, output, slots);
+  auto& strided = std::get<vector<T>>(output["test_out"]);
+  ASSERT_EQ(strided.size(), 1024u / 16);
+  for (uint32_t i = 0; i < strided.size(); i++) {
+    EXPECT_NEAR(strided[i], vec_out[16 * i], 0.01);
+  }
+  releaseDag(dag);
+}
+
+TEST(TEST_ENCRYPT, seal_ckks_partial_decrypt) {
+  checkPartialDecrypt<double>("PARTIAL_DECRYPT_CKKS", "seal_ckks");
+}
+
+TEST(TEST_ENCRYPT, seal_bfv_partial_decrypt) {
+  checkPartialDecrypt<int64_t>("PARTIAL_DECRYPT_BFV", "seal_bfv");
+}
+
+template <typename T>
+void checkSpanInputOutput(const string& dag_name, const string& lib_name) {
+  const T one = 1;
+  vector<T> vec_x1;
+  for (int i = 0; i < 1024; i++) {
+    vec_x1.emplace_back(static_cast<T>(rand() % 8));
+  }
+  DagPtr dag = initDag(dag_name, 1024);
+  Expr x1 = setInputName(dag, "x1");
+  Expr x2 = setInputName(dag, "x2");
+  setOutput(dag, "test_out", x1 * x2 + x1 + one);
+  setOutput(dag, "skipped_out", x1 + x2);
+  compileDag(dag);
+  checkLib(dag, lib_name);
+  genKeys(dag);
+
+  // x2 is a single value filling every slot
+  T two = 2;
+  InputSpans inputs{{"x1", InputSpan(vec_x1.data(), vec_x1.size())},
+                    {"x2", InputSpan(&two, 1)}};
+  encryptInputSpans(dag, inputs);
+  exeDag(dag);
+
+  vector<double> out_f64(1024, -1);
+  OutputBuffers outputs{{"test_out", OutputBuffer(out_f64.data(), 1024)}};
+  decryptOutputTo(dag, outputs);
+  ASSERT_EQ(outputs["test_out"].size, 1024u);
+  for (uint32_t i = 0; i < out_f64.size(); i++) {
+    EXPECT_NEAR(out_f64[i], vec_x1[i] * two + vec_x1[i] + one, 0.01);
+  }
+
+  // Smaller buffer, other element type, selected slots only
+  vector<int64_t> out_i64(8, -1);
+  SlotSelection slots;
+  slots.stride = 2;
+  outputs = {{"test_out", OutputBuffer(out_i64.data(), 4)}};
+  decryptOutputTo(dag, outputs, slots);
+  ASSERT_EQ(outputs["test_out"].size, 4u);
+  for (uint32_t i = 0; i < 4; i++) {
+    EXPECT_EQ(out_i64[i],
+              static_cast<int64_t>(vec_x1[2 * i] * two + vec_x1[2 * i] + one));
+  }
+  EXPECT_EQ(out_i64[4], -1);
+  releaseDag(dag);
+}
+
+TEST(TEST_ENCRYPT, seal_ckks_span_input_output) {
+  checkSpanInputOutput<double>("SPAN_IO_CKKS", "seal_ckks");
+}
+
+TEST(TEST_ENCRYPT, seal_bfv_span_input_output) {
+  checkSpanInputOutput<int64_t>("SPAN_IO_BFV", "seal_bfv");
+}
+
+template <typename T>
+void checkThreadedEncrypt(const string& dag_name, const string& lib_name) {
+  // One input and one output per worker thread
+  const T one = 1;
+  vector<vector<T>> vec_x(4);
+  for (int i = 0; i < 1024; i++) {
+    for (auto& v : vec_x) v.emplace_back(static_cast<T>(rand() % 8));
+  }
+  DagPtr dag = initDag(dag_name, 1024);
+  vector<Expr> x;
+  for (int i = 0; i < 4; i++) {
+    x.push_back(setInputName(dag, "x" + to_string(i)));
+  }
+  setOutput(dag, "sum_out", x[0] * x[1] + x[2] * x[3] + one);
+  setOutput(dag, "diff_out", x[0] - x[3] + one);
+  compileDag(dag);
+  checkLib(dag, lib_name);
+  genKeys(dag);
+
+  setThreadNum(4);
+  Valuation inputs;
+  for (int i = 0; i < 4; i++) inputs["x" + to_string(i)] = vec_x[i];
+  // The second round reuses the per-thread encoders of the first
+  for (int round = 0; round < 2; round++) {
+    encryptInput(dag, inputs);
+    exeDag(dag);
+    Valuation output;
+    decryptOutput(dag, output);
+    auto& sum = std::get<vector<T>>(output["sum_out"]);
+    auto& diff = std::get<vector<T>>(output["diff_out"]);
+    ASSERT_EQ(sum.size(), 1024u);
+    ASSERT_EQ(diff.size(), 1024u);
+    for (uint32_t i = 0; i < 1024; i++) {
+      EXPECT_NEAR(sum[i],
+                  vec_x[0][i] * vec_x[1][i] + vec_x[2][i] * vec_x[3][i] + one,
+                  0.01);
+      EXPECT_NEAR(diff[i], vec_x[0][i] - vec_x[3][i] + one, 0.01);
+    }
+  }
+  setThreadNum(0);
+  releaseDag(dag);
+}
+
+TEST(TEST_ENCRYPT, seal_ckks_thread_encoders) {
+  checkThreadedEncrypt<double>("THREAD_ENCODERS_CKKS", "seal_ckks");
+}
+
+TEST(TEST_ENCRYPT, seal_bfv_thread_encoders) {
+  checkThreadedEncrypt<int64_t>("THREAD_ENCODERS_BFV", "seal_bfv");
+}
+
+}  // namespace iyfctest
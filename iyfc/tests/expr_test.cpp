@@ -626,4 +626,41 @@ TEST_F(ExprTestVectorInt, DecrementTest){
 }
 
 
+// Test Conv1D with zero padding
+TEST(ExprTestConv, Conv1DPaddingTest){
+    DagPtr dag = initDag("conv1d", 16);
+    Expr x = setInputName(dag, "x");
+    Valuation inputs;
+    vector<double> vec_x{1, 2, 3, 4, 5, 6, 7, 8};
+    vec_x.resize(16);
+    inputs["x"] = vec_x;
+    Expr y = Conv1D(x, 8, vector<double>{1.0, 2.0, -1.0}, 1, 1);
+    Valuation output = execute(inputs, dag, y);
+    auto& v = get<vector<double>>(output["test_out"]);
+    vector<double> expect{0, 2, 4, 6, 8, 10, 12, 23};
+    for (uint32_t i = 0; i < expect.size(); i++) {
+        EXPECT_NEAR(v[i], expect[i], 0.001);
+    }
+    releaseDag(dag);
+}
+
+// Test Conv2D with stride, outputs are placed at the strided anchors
+TEST(ExprTestConv, Conv2DStrideTest){
+    DagPtr dag = initDag("conv2d", 16);
+    Expr x = setInputName(dag, "x");
+    Valuation inputs;
+    vector<double> vec_x(16);
+    for (uint32_t i = 0; i < 16; i++) vec_x[i] = i;
+    inputs["x"] = vec_x;
+    Expr y = Conv2D(x, 4, 4, {{1.0, 1.0}, {1.0, 1.0}}, 2);
+    Valuation output = execute(inputs, dag, y);
+    auto& v = get<vector<double>>(output["test_out"]);
+    EXPECT_NEAR(v[0], 10, 0.001);
+    EXPECT_NEAR(v[2], 18, 0.001);
+    EXPECT_NEAR(v[8], 42, 0.001);
+    EXPECT_NEAR(v[10], 50, 0.001);
+    EXPECT_NEAR(v[1], 0, 0.001);
+    releaseDag(dag);
+}
+
 } // namespace iyfctest
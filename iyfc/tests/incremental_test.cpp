@@ -0,0 +1,215 @@
+
+/*
+*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <unordered_set>
+
+#include "daghandler/traversal_handler.h"
+#include "iyfc_include.h"
+#include "test_comm.h"
+
+using namespace std;
+using namespace iyfc;
+
+namespace iyfctest {
+
+// Nodes an incremental run recomputes after the named inputs changed: their
+// forward cone in the compiled DAG, inputs included. Every node when empty.
+size_t coneSize(DagPtr dag, const unordered_set<string>& names) {
+  unordered_set<const Node*> cone;
+  for (auto& name : names) cone.insert(dag->getInput(name).get());
+  size_t node_cnt = 0;
+  DagTraversal(*dag).forwardPass([&](NodePtr& node) {
+    node_cnt++;
+    for (auto& operand : node->getOperands()) {
+      if (cone.count(operand.get())) {
+        cone.insert(node.get());
+        break;
+      }
+    }
+  });
+  return names.empty() ? node_cnt : cone.size();
+}
+
+template <typename T>
+vector<T> randomVec(uint32_t size) {
+  vector<T> vec;
+  for (uint32_t i = 0; i < size; i++) {
+    vec.emplace_back(static_cast<T>(rand() % 8));
+  }
+  return vec;
+}
+
+// The constant is a T, so int64_t compiles to seal_bfv and double to
+// seal_ckks
+template <typename T>
+void checkIncrementalExe(const string& dag_name, const string& lib_name) {
+  const T one = 1;
+  DagPtr dag = initDag(dag_name, 64);
+  Expr x1 = setInputName(dag, "x1");
+  Expr x2 = setInputName(dag, "x2");
+  setOutput(dag, "test_out", x1 * x2 + x1 + one);
+  compileDag(dag);
+  checkLib(dag, lib_name);
+  genKeys(dag);
+  setIncrementalExe(dag, true);
+
+  vector<T> vec_x1 = randomVec<T>(64);
+  vector<T> vec_x2 = randomVec<T>(64);
+  auto expect = [&]() {
+    vector<T> vec_out;
+    for (uint32_t i = 0; i < 64; i++) {
+      vec_out.emplace_back(vec_x1[i] * vec_x2[i] + vec_x1[i] + one);
+    }
+    return vec_out;
+  };
+  encryptInput(dag, {{"x1", vec_x1}, {"x2", vec_x2}});
+  exeDag(dag);
+  Valuation outputs;
+  decryptOutput(dag, outputs);
+  check_result(outputs, expect(), 0.01);
+  size_t full_cnt = coneSize(dag, {});
+  EXPECT_EQ(getRecomputedCnt(dag), full_cnt);
+
+  // Only x2 changes, x1 and its ciphertext stay as they were
+  vec_x2 = randomVec<T>(64);
+  encryptInput(dag, {{"x2", vec_x2}});
+  exeDag(dag);
+  outputs.clear();
+  decryptOutput(dag, outputs);
+  check_result(outputs, expect(), 0.01);
+  EXPECT_EQ(getRecomputedCnt(dag), coneSize(dag, {"x2"}));
+  EXPECT_LT(getRecomputedCnt(dag), full_cnt);
+
+  // Changed input named by the caller
+  vec_x1 = randomVec<T>(64);
+  encryptInput(dag, {{"x1", vec_x1}});
+  exeDag(dag, {"x1"});
+  outputs.clear();
+  decryptOutput(dag, outputs);
+  check_result(outputs, expect(), 0.01);
+  EXPECT_EQ(getRecomputedCnt(dag), coneSize(dag, {"x1"}));
+  EXPECT_LT(getRecomputedCnt(dag), full_cnt);
+  releaseDag(dag);
+}
+
+TEST(TEST_INCREMENTAL, seal_ckks_incremental_exe) {
+  checkIncrementalExe<double>("INCREMENTAL_CKKS", "seal_ckks");
+}
+
+TEST(TEST_INCREMENTAL, seal_bfv_incremental_exe) {
+  checkIncrementalExe<int64_t>("INCREMENTAL_BFV", "seal_bfv");
+}
+
+TEST(TEST_INCREMENTAL, group_children) {
+  DagPtr group = initDagGroup("INCREMENTAL_GROUP", 64);
+  DagPtr dag_sum = initDag("child_sum", 64);
+  Expr lhs = setInputName(dag_sum, "lhs");
+  setOutput(dag_sum, "sum_out", lhs * lhs + 1.0);
+  addDag(group, dag_sum);
+
+  DagPtr dag_table = initDag("child_table", 64);
+  setNextNodeIndex(dag_table, getNextNodeIndex(group));
+  Expr table = setInputName(dag_table, "table");
+  Expr param = setInputName(dag_table, "param");
+  setOutput(dag_table, "table_out", table * param);
+  addDag(group, dag_table);
+  compileDag(group);
+  genKeys(group);
+  setIncrementalExe(group, true);
+
+  vector<double> vec_lhs = randomVec<double>(64);
+  vector<double> vec_table = randomVec<double>(64);
+  encryptInput(dag_sum, {{"lhs", vec_lhs}});
+  encryptInput(dag_table, {{"table", vec_table}});
+  // Dashboard style: fixed table, one parameter changing per query
+  for (int query = 0; query < 3; query++) {
+    double param = query + 1;
+    encryptInput(dag_table, {{"param", param}});
+    exeDag(dag_table);
+    Valuation outputs;
+    decryptOutput(dag_table, outputs);
+    vector<double> vec_out;
+    for (auto& item : vec_table) vec_out.emplace_back(item * param);
+    check_result(outputs, vec_out, 0.01);
+  }
+
+  exeDag(dag_sum);
+  Valuation outputs;
+  decryptOutput(dag_sum, outputs);
+  vector<double> vec_out;
+  for (auto& item : vec_lhs) vec_out.emplace_back(item * item + 1.0);
+  check_result(outputs, vec_out, 0.01);
+  releaseDag(group);
+}
+
+TEST(TEST_INCREMENTAL, pruned_outputs) {
+  DagPtr dag = initDag("PRUNED_OUTPUTS", 64);
+  Expr x1 = setInputName(dag, "x1");
+  Expr x2 = setInputName(dag, "x2");
+  setOutput(dag, "sum_out", x1 + x2);
+  setOutput(dag, "cube_out", x1 * x1 * x1);
+  compileDag(dag);
+  genKeys(dag);
+
+  vector<double> vec_x1 = randomVec<double>(64);
+  vector<double> vec_x2 = randomVec<double>(64);
+  encryptInput(dag, {{"x1", vec_x1}, {"x2", vec_x2}});
+  vector<double> vec_sum, vec_cube;
+  for (uint32_t i = 0; i < 64; i++) {
+    vec_sum.emplace_back(vec_x1[i] + vec_x2[i]);
+    vec_cube.emplace_back(vec_x1[i] * vec_x1[i] * vec_x1[i]);
+  }
+
+  // Twice each, the second run takes the cached cone
+  for (int run = 0; run < 2; run++) {
+    exeDagOutputs(dag, {"sum_out"});
+    Valuation outputs;
+    decryptOutput(dag, outputs);
+    EXPECT_EQ(outputs.size(), 1u);
+    check_result(outputs, vec_sum, 0.01);
+
+    exeDagOutputs(dag, {"cube_out"});
+    outputs.clear();
+    decryptOutput(dag, outputs);
+    EXPECT_EQ(outputs.size(), 1u);
+    check_result(outputs, vec_cube, 0.01);
+  }
+  EXPECT_THROW(exeDagOutputs(dag, {"no_such_out"}), std::logic_error);
+
+  // Nodes skipped by a pruned incremental run are computed when asked for
+  setIncrementalExe(dag, true);
+  exeDagOutputs(dag, {"sum_out"});
+  vec_x1 = randomVec<double>(64);
+  encryptInput(dag, {{"x1", vec_x1}});
+  exeDagOutputs(dag, {"sum_out"});
+  exeDag(dag);
+  Valuation outputs;
+  decryptPartialOutput(dag, {"cube_out"}, outputs);
+  vec_cube.clear();
+  for (auto& item : vec_x1) vec_cube.emplace_back(item * item * item);
+  check_result(outputs, vec_cube, 0.01);
+  releaseDag(dag);
+}
+
+}  // namespace iyfctest
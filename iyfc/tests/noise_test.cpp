@@ -0,0 +1,121 @@
+
+/*
+*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "iyfc_include.h"
+#include "test_comm.h"
+
+using namespace std;
+using namespace iyfc;
+
+namespace iyfctest {
+
+// x1 * x2 + x1 + 1, the constant is a T, so int64_t compiles to seal_bfv
+// and double to seal_ckks
+template <typename T>
+DagPtr buildNoiseDag(const string& dag_name, const string& lib_name,
+                     vector<T>& vec_out, Valuation& inputs) {
+  const T one = 1;
+  vector<T> vec_x1;
+  vector<T> vec_x2;
+  for (uint32_t i = 0; i < 64; i++) {
+    vec_x1.emplace_back(static_cast<T>(rand() % 8));
+    vec_x2.emplace_back(static_cast<T>(rand() % 8));
+    vec_out.emplace_back(vec_x1[i] * vec_x2[i] + vec_x1[i] + one);
+  }
+  DagPtr dag = initDag(dag_name, 64);
+  Expr x1 = setInputName(dag, "x1");
+  Expr x2 = setInputName(dag, "x2");
+  setOutput(dag, "test_out", x1 * x2 + x1 + one);
+  setInputRange(dag, "x1", 3);
+  setInputRange(dag, "x2", 3);
+  compileDag(dag);
+  checkLib(dag, lib_name);
+  genKeys(dag);
+  inputs = {{"x1", vec_x1}, {"x2", vec_x2}};
+  return dag;
+}
+
+TEST(TEST_NOISE, seal_ckks_estimate) {
+  vector<double> vec_out;
+  Valuation inputs;
+  DagPtr dag =
+      buildNoiseDag<double>("NOISE_CKKS", "seal_ckks", vec_out, inputs);
+  NoiseReport report;
+  EXPECT_EQ(estimateNoise(dag, report), 0);
+  EXPECT_EQ(report.lib, "seal_ckks");
+  ASSERT_EQ(report.outputs.count("test_out"), 1);
+  EXPECT_LT(report.outputs["test_out"].noise_bits,
+            -static_cast<double>(DEFAULT_CKKS_PRECISION_BITS));
+  EXPECT_GT(report.min_scale, 0);
+  EXPECT_LE(report.min_scale, report.scale);
+  EXPECT_GE(report.primes, report.min_primes);
+
+  // The static bound holds on the debug key
+  setNoiseCheck(dag, true);
+  encryptInput(dag, inputs);
+  exeDag(dag);
+  vector<NoiseMeasurement> measurements;
+  EXPECT_EQ(getNoiseMeasurements(dag, measurements), 0);
+  EXPECT_FALSE(measurements.empty());
+  for (auto& item : measurements) {
+    EXPECT_LE(item.measured_bits, item.estimated_bits) << item.op;
+  }
+  Valuation outputs;
+  decryptOutput(dag, outputs);
+  check_result(outputs, vec_out, 0.01);
+  releaseDag(dag);
+}
+
+TEST(TEST_NOISE, seal_bfv_estimate) {
+  vector<int64_t> vec_out;
+  Valuation inputs;
+  DagPtr dag =
+      buildNoiseDag<int64_t>("NOISE_BFV", "seal_bfv", vec_out, inputs);
+  NoiseReport report;
+  EXPECT_EQ(estimateNoise(dag, report), 0);
+  EXPECT_EQ(report.lib, "seal_bfv");
+  ASSERT_EQ(report.outputs.count("test_out"), 1);
+  EXPECT_GT(report.outputs["test_out"].noise_bits, 0);
+  // x1 * x2 + x1 + 1 is below 2^7, plus a sign and a bit of slack
+  EXPECT_EQ(report.outputs["test_out"].min_scale, 9);
+  EXPECT_LE(report.min_scale, report.scale);
+  EXPECT_GE(report.primes, report.min_primes);
+
+  setNoiseCheck(dag, true);
+  encryptInput(dag, inputs);
+  exeDag(dag);
+  vector<NoiseMeasurement> measurements;
+  EXPECT_EQ(getNoiseMeasurements(dag, measurements), 0);
+  EXPECT_FALSE(measurements.empty());
+  for (auto& item : measurements) {
+    // Budgets are whole bits in SEAL
+    EXPECT_GE(item.measured_bits + 1, item.estimated_bits) << item.op;
+  }
+  Valuation outputs;
+  decryptOutput(dag, outputs);
+  check_result(outputs, vec_out, 0.0);
+  releaseDag(dag);
+}
+
+}  // namespace iyfctest
@@ -24,6 +24,7 @@
  */
 
 #include "test_comm.h"
+#include "util/math_util.h"
 using namespace std;
 using namespace iyfc;
 
@@ -171,4 +172,79 @@ TEST_QUERY_SUM(query_more_and_plain_sum,
 TEST_QUERY_SUM(query_more_or_plain_sum,
                 (lhs_1 >= plain_num_1) || (lhs_2 > plain_num_2));
 
+// Complex-slot packing, one QuerySum over the complex spectrum
+TEST(TEST_QUERY, query_less_sum_complex) {
+  DagPtr dag = initDag("QUERY");
+  Expr lhs_1 = setInputName(dag, "lhs");
+  Expr rhs_1 = setInputName(dag, "rhs");
+  Expr fft_in = setComplexInputName(dag, "fft");
+  setOutput(dag, "fft_out", QuerySum(fft_in, lhs_1 < rhs_1));
+  compileDag(dag);
+  genKeys(dag);
+  Valuation inputs;
+  vector<uint32_t> vec_input1;
+  vector<uint32_t> vec_input2;
+  vector<uint32_t> vec_org;
+  uint32_t plain_result = 0;
+  for (int i = 0; i < MAX_CMP_NUM; i++) {
+    uint32_t lhs = rand() % MAX_CMP_NUM;
+    uint32_t rhs = rand() % MAX_CMP_NUM;
+    uint32_t org = rand() % 1024;
+    vec_input1.emplace_back(lhs);
+    vec_input2.emplace_back(rhs);
+    vec_org.emplace_back(org);
+    if (lhs < rhs) plain_result += org;
+  }
+  encodeOrgInputforCmp(vec_input1, "lhs", inputs);
+  encodeOrgInputforCmp(vec_input2, "rhs", inputs);
+  encodeOrgInputFFTComplex(vec_org, "fft", inputs);
+  encryptInput(dag, inputs);
+  exeDag(dag);
+  uint32_t sum_result = 0;
+  getFFTComplexSumOutputs(dag, MAX_CMP_NUM, "fft_out", sum_result);
+  EXPECT_EQ(sum_result, plain_result);
+}
+
+// Batched plans over two full blocks and a tail give the spectra of the
+// per-record FFT, also after the plan cache was released
+TEST(TEST_QUERY, batch_fft_matches_single) {
+  vector<uint32_t> vec_org;
+  for (int i = 0; i < 150; i++) vec_org.emplace_back(rand() % 100000000);
+
+  for (int round = 0; round < 2; round++) {
+    vector<ComplexDouble> vec_spectrum;
+    batchFFTEncode(vec_org, FFT_N, vec_spectrum);
+    ASSERT_EQ(vec_spectrum.size(), vec_org.size() * FFT_N);
+    vector<double> vec_results;
+    batchFFTDecode(vec_spectrum, vec_org.size(), FFT_N, vec_results);
+    ASSERT_EQ(vec_results.size(), vec_org.size());
+    {
+      FastFourierTransform forward(FFT_N, FFTW_FORWARD);
+      FastFourierTransform backward(FFT_N, FFTW_BACKWARD);
+      for (size_t r = 0; r < vec_org.size(); r++) {
+        vector<int> vec_num;
+        getNumReVec(vec_org[r], vec_num);
+        for (int i = 0; i < FFT_N; i++) {
+          forward.m_in[i][0] = double(vec_num[i]);
+          forward.m_in[i][1] = 0;
+        }
+        forward.fft();
+        for (int i = 0; i < FFT_N; i++) {
+          auto& batched = vec_spectrum[r * FFT_N + i];
+          EXPECT_NEAR(batched.real(), forward.m_out[i][0], 1e-9) << r;
+          EXPECT_NEAR(batched.imag(), forward.m_out[i][1], 1e-9) << r;
+          backward.m_in[i][0] = forward.m_out[i][0];
+          backward.m_in[i][1] = forward.m_out[i][1];
+        }
+        backward.fft();
+        EXPECT_NEAR(vec_results[r], getComplexNum(backward.m_out, FFT_N), 1e-6)
+            << r;
+        EXPECT_NEAR(vec_results[r], vec_org[r], 0.5) << r;
+      }
+    }
+    // No FastFourierTransform is alive here
+    releaseFFTPlans();
+  }
+}
+
 }  // namespace iyfctest
\ No newline at end of file
@@ -21,6 +21,7 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
  */
+#include "proto/openfhe_serialization.h"
 #include "test_comm.h"
 using namespace std;
 using namespace iyfc;
@@ -141,6 +142,135 @@ TEST(TEST_SERIALIZE, seal_ckks_ser_dag) {
       });
 }
 
+// Rotation keys travel seeded and are expanded on the executing side
+TEST(TEST_SERIALIZE, seal_ckks_ser_dag_rotation) {
+  serFun(
+      [&](DagPtr dag) -> Expr {
+        Expr input_expr_x = setInputName(dag, "x");
+        Expr input_expr_y = setInputName(dag, "y");
+        return (input_expr_x << 1) * input_expr_y + (input_expr_y >> 2);
+      },
+      [&](Valuation& inputs, Valuation& out_puts_plain, uint32_t vec_size) {
+        vector<double> vec_input_x;
+        vector<double> vec_input_y;
+        vector<double> vec_out;
+        int64_t data_bound = (1 << 10);
+        for (uint32_t i = 0; i < vec_size; i++) {
+          vec_input_x.emplace_back(static_cast<double>(rand() % data_bound));
+          vec_input_y.emplace_back(static_cast<double>(rand() % data_bound));
+        }
+        for (uint32_t i = 0; i < vec_size; i++) {
+          vec_out.emplace_back(
+              vec_input_x[(i + 1) % vec_size] * vec_input_y[i] +
+              vec_input_y[(i + vec_size - 2) % vec_size]);
+        }
+
+        inputs["x"] = std::move(vec_input_x);
+        inputs["y"] = std::move(vec_input_y);
+        out_puts_plain["z"] = std::move(vec_out);
+      },
+      [&](Valuation& outputs, Valuation& outputs_plain) {
+        check_result<double>(
+            outputs, std::get<vector<double>>(outputs_plain["z"]), 0.01);
+      });
+}
+
+// Returns the serialized output size, outputs are checked after decryption
+size_t outputModSwitchSize(bool mod_switch) {
+  vector<double> vec_x1, vec_x2, vec_big, vec_small;
+  for (int i = 0; i < 1024; i++) {
+    vec_x1.emplace_back(static_cast<double>(rand() % 8));
+    vec_x2.emplace_back(static_cast<double>(rand() % 8));
+    vec_big.emplace_back(vec_x1[i] * vec_x2[i]);
+    vec_small.emplace_back(vec_x1[i] + vec_x2[i]);
+  }
+  DagPtr dag = initDag("OUTPUT_MOD_SWITCH", 1024);
+  setScale(dag, 40);
+  Expr x1 = setInputName(dag, "x1");
+  Expr x2 = setInputName(dag, "x2");
+  setOutput(dag, "big", x1 * x2);
+  setOutput(dag, "small", x1 + x2);
+  setOutputRange(dag, "big", 50);
+  setOutputRange(dag, "small", 10);
+  setOutputModSwitch(dag, mod_switch);
+  compileDag(dag);
+  genKeys(dag);
+
+  Valuation inputs{{"x1", vec_x1}, {"x2", vec_x2}};
+  encryptInput(dag, inputs);
+  exeDag(dag);
+  string str_output;
+  savaOutputTostr(dag, str_output);
+
+  Valuation output;
+  decryptOutput(dag, output);
+  Valuation big{{"big", output["big"]}};
+  Valuation small{{"small", output["small"]}};
+  check_result(big, vec_big, 0.01);
+  check_result(small, vec_small, 0.01);
+  releaseDag(dag);
+  return str_output.size();
+}
+
+// The small output needs one prime less than the big one
+TEST(TEST_SERIALIZE, seal_ckks_output_mod_switch) {
+  EXPECT_LT(outputModSwitchSize(true), outputModSwitchSize(false));
+}
+
+// OpenFHE compresses each output to the towers its range needs: the first
+// tower plus one per scale - 1 bits of range
+TEST(TEST_SERIALIZE, openfhe_ckks_output_towers) {
+  vector<double> vec_x, vec_deep, vec_small;
+  for (int i = 0; i < 1024; i++) {
+    double x = static_cast<double>(rand() % 2);
+    double y = x;
+    for (int d = 0; d < 13; d++) y = y * x - x;
+    vec_x.emplace_back(x);
+    vec_deep.emplace_back(y);
+    vec_small.emplace_back(y + x);
+  }
+  DagPtr dag = initDag("OPENFHE_OUTPUT_TOWERS", 1024);
+  setScale(dag, 60);
+  Expr x = setInputName(dag, "x");
+  // Deeper than SEAL allows, so the DAG compiles to openfhe_ckks
+  Expr y = x;
+  for (int d = 0; d < 13; d++) y = y * x - x;
+  setOutput(dag, "deep", y);
+  setOutput(dag, "small", y + x);
+  setOutputRange(dag, "small", 10);
+  setOutputModSwitch(dag, true);
+  compileDag(dag);
+  checkLib(dag, "openfhe_ckks");
+  genKeys(dag);
+  Valuation inputs{{"x", vec_x}};
+  encryptInput(dag, inputs);
+  exeDag(dag);
+
+  string str_output;
+  savaOutputTostr(dag, str_output);
+  msg::Output msg_output;
+  ASSERT_TRUE(msg_output.ParseFromString(str_output));
+  msg::OpenFheValuation msg_valuation;
+  ASSERT_TRUE(msg_valuation.ParseFromString(msg_output.outputs()));
+  auto outputs_en = deserialize(msg_valuation);
+  auto towers = [&](const string& name) {
+    auto& cipher = get<OpenFheCiphertext>((*outputs_en)[name]);
+    return cipher->GetElements()[0].GetNumOfElements();
+  };
+  // Without a range the output needs the scale: 1 + ceil(60 / 59)
+  EXPECT_EQ(towers("deep"), 3u);
+  // 1 + ceil(10 / 59)
+  EXPECT_EQ(towers("small"), 2u);
+
+  Valuation output;
+  decryptOutput(dag, output);
+  Valuation deep{{"deep", output["deep"]}};
+  Valuation small{{"small", output["small"]}};
+  check_result(deep, vec_deep, 0.1);
+  check_result(small, vec_small, 0.1);
+  releaseDag(dag);
+}
+
 TEST(TEST_SERIALIZE, seal_bfv_ser_dag) {
   serFun(
       [&](DagPtr dag) -> Expr {
@@ -39,6 +39,12 @@ Valuation execute(Valuation& inputs, DagPtr dag, Expr& out_expr) {
   return outputs;
 }
 
+void checkLib(DagPtr dag, const string& lib_name) {
+  vector<string> vec_libs = getLibInfo(dag);
+  if (vec_libs.size() == 0) FAIL();
+  EXPECT_EQ(vec_libs[0], lib_name);
+}
+
 template <typename T>
 void check_result(const Valuation& output, const vector<T>& vec_out,
                   double precision) {
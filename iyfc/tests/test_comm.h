@@ -41,4 +41,6 @@ template <typename T>
 void check_result(const Valuation& output, const vector<T>& vec_out,
                   double precision ) ;
 
+void checkLib(DagPtr dag, const string& lib_name);
+
 }
@@ -0,0 +1,185 @@
+/*
+*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <unordered_set>
+
+#include "daghandler/tile_handler.h"
+#include "iyfc_include.h"
+#include "test_comm.h"
+
+using namespace std;
+using namespace iyfc;
+
+namespace iyfctest {
+
+const uint32_t TILE_VEC_SIZE = 4096;
+const uint32_t TILE_SIZE = 1024;
+
+// The constant of each DAG is a T, so int64_t DAGs compile to seal_bfv and
+// double DAGs to seal_ckks
+
+template <typename T>
+void checkTiledDag(const string& dag_name, const string& lib_name) {
+  const T one = 1;
+  vector<T> vec_x1, vec_x2, vec_out, vec_rot;
+  for (uint32_t i = 0; i < TILE_VEC_SIZE; i++) {
+    vec_x1.emplace_back(static_cast<T>(rand() % 8));
+    vec_x2.emplace_back(static_cast<T>(rand() % 8));
+  }
+  // Rotation steps cross tile borders and are not a tile multiple
+  const uint32_t steps = TILE_SIZE + 3;
+  for (uint32_t i = 0; i < TILE_VEC_SIZE; i++) {
+    vec_out.emplace_back(vec_x1[i] * vec_x2[i] + vec_x1[i] + one);
+    vec_rot.emplace_back(vec_x1[(i + steps) % TILE_VEC_SIZE] + vec_x2[i]);
+  }
+
+  DagPtr dag = initDag(dag_name, TILE_VEC_SIZE);
+  setTileSize(dag, TILE_SIZE);
+  Expr x1 = setInputName(dag, "x1");
+  Expr x2 = setInputName(dag, "x2");
+  setOutput(dag, "test_out", x1 * x2 + x1 + one);
+  setOutput(dag, "rot_out", (x1 << steps) + x2);
+  compileDag(dag);
+  checkLib(dag, lib_name);
+  EXPECT_EQ(getVecSize(dag), TILE_VEC_SIZE);
+  genKeys(dag);
+
+  Valuation inputs{{"x1", vec_x1}, {"x2", vec_x2}};
+  encryptInput(dag, inputs);
+  exeDag(dag);
+  Valuation outputs;
+  decryptOutput(dag, outputs);
+  for (auto& expect : {make_pair("test_out", &vec_out),
+                       make_pair("rot_out", &vec_rot)}) {
+    ASSERT_TRUE(outputs.count(expect.first));
+    auto& out = get<vector<T>>(outputs[expect.first]);
+    ASSERT_EQ(out.size(), TILE_VEC_SIZE);
+    for (uint32_t i = 0; i < TILE_VEC_SIZE; i++) {
+      EXPECT_NEAR(out[i], (*expect.second)[i], 0.01) << expect.first << i;
+    }
+  }
+  releaseDag(dag);
+}
+
+TEST(TEST_TILE, seal_ckks_tiled_dag) {
+  checkTiledDag<double>("TILE_CKKS", "seal_ckks");
+}
+
+TEST(TEST_TILE, seal_bfv_tiled_dag) {
+  checkTiledDag<int64_t>("TILE_BFV", "seal_bfv");
+}
+
+template <typename T>
+void checkTiledSum(const string& dag_name, const string& lib_name) {
+  const T zero = 0;
+  vector<T> vec_x;
+  T sum = 0;
+  for (uint32_t i = 0; i < TILE_VEC_SIZE; i++) {
+    vec_x.emplace_back(static_cast<T>(rand() % 8));
+    sum += vec_x.back();
+  }
+
+  DagPtr dag = initDag(dag_name, TILE_VEC_SIZE);
+  setTileSize(dag, TILE_SIZE);
+  Expr x = setInputName(dag, "x");
+  // Rotate-and-add over the whole vector, merged across tiles by the tiler
+  Expr s = x;
+  for (uint32_t step = TILE_VEC_SIZE / 2; step > 0; step >>= 1) {
+    s = s + (s << step);
+  }
+  setOutput(dag, "sum_out", s + zero);
+  compileDag(dag);
+  checkLib(dag, lib_name);
+  genKeys(dag);
+
+  Valuation inputs{{"x", vec_x}};
+  encryptInput(dag, inputs);
+  exeDag(dag);
+  Valuation outputs;
+  decryptOutput(dag, outputs);
+  ASSERT_TRUE(outputs.count("sum_out"));
+  auto& out = get<vector<T>>(outputs["sum_out"]);
+  ASSERT_EQ(out.size(), TILE_VEC_SIZE);
+  for (uint32_t i = 0; i < TILE_VEC_SIZE; i++) {
+    EXPECT_NEAR(out[i], sum, 0.01) << i;
+  }
+  releaseDag(dag);
+}
+
+TEST(TEST_TILE, seal_ckks_tiled_sum) {
+  checkTiledSum<double>("TILE_SUM_CKKS", "seal_ckks");
+}
+
+TEST(TEST_TILE, seal_bfv_tiled_sum) {
+  checkTiledSum<int64_t>("TILE_SUM_BFV", "seal_bfv");
+}
+
+// The chain becomes per-tile sums added across tiles: every output tile is
+// the same node and no mask is multiplied in
+TEST(TEST_TILE, merged_sum_chain) {
+  Dag dag("TILE_SUM_CHAIN", TILE_VEC_SIZE);
+  NodePtr sum = dag.makeInput("x");
+  for (uint32_t step = TILE_VEC_SIZE / 2; step > 0; step >>= 1) {
+    sum = dag.makeNode(OpType::Add, {sum, dag.makeLeftRotation(sum, step)});
+  }
+  dag.makeOutput("sum_out", sum);
+  VectorTiler(dag, TILE_SIZE).run();
+
+  const uint32_t tile_cnt = TILE_VEC_SIZE / TILE_SIZE;
+  ASSERT_EQ(dag.getTileCnt(), tile_cnt);
+  auto& outputs = dag.getOutputs();
+  ASSERT_EQ(outputs.size(), tile_cnt);
+  NodePtr total = outputs.at("sum_out_0")->getOperands().at(0);
+  for (uint32_t t = 1; t < tile_cnt; t++) {
+    auto name = "sum_out_" + to_string(t);
+    EXPECT_EQ(outputs.at(name)->getOperands().at(0), total);
+  }
+  std::unordered_set<Node*> seen;
+  vector<NodePtr> stack{total};
+  uint32_t rotations = 0;
+  while (!stack.empty()) {
+    NodePtr node = stack.back();
+    stack.pop_back();
+    if (!seen.insert(node.get()).second) continue;
+    EXPECT_NE(node->m_op_type, OpType::Mul);
+    if (node->m_op_type == OpType::RotateLeftConst) rotations++;
+    for (auto& operand : node->getOperands()) stack.push_back(operand);
+  }
+  // log2(TILE_SIZE) rotations within each tile
+  EXPECT_EQ(rotations, tile_cnt * 10);
+}
+
+// Rotations wrap at the vector size, which padding to whole tiles would move
+TEST(TEST_TILE, non_multiple_vec_size) {
+  Dag dag("TILE_NON_MULTIPLE", TILE_VEC_SIZE);
+  dag.setVecSize(TILE_VEC_SIZE - TILE_SIZE / 2);
+  EXPECT_THROW(VectorTiler(dag, TILE_SIZE), std::logic_error);
+}
+
+TEST(TEST_TILE, invalid_tile_size) {
+  DagPtr dag = initDag("TILE_INVALID", TILE_VEC_SIZE);
+  EXPECT_THROW(setTileSize(dag, 1000), std::logic_error);
+  releaseDag(dag);
+}
+
+}  // namespace iyfctest
@@ -24,10 +24,12 @@
 #include "math_util.h"
 #include <algorithm>
 #include <cmath>
+#include <cstdlib>
 #include <iostream>
 #include <string>
 
 #include "comm_include.h"
+#include "logging.h"
 
 namespace iyfc {
 
@@ -45,6 +47,78 @@ std::vector<uint32_t> IYFC_SO_EXPORT decimalConvert(uint32_t num, uint32_t k,
   return vec_result;
 }
 
+// Rows per block of the bulk digit kernel
+const size_t DIGIT_BLOCK_ROWS = 256;
+
+// Digit kernel with a compile-time base so the division becomes shifts or
+// multiplications and vectorizes across the rows of a block
+template <uint32_t K>
+void digitBlock(const uint32_t* src, size_t rows, uint32_t bits, double* dst) {
+  uint32_t nums[DIGIT_BLOCK_ROWS];
+  std::copy(src, src + rows, nums);
+  for (int64_t j = int64_t(bits) - 1; j >= 0; j--) {
+#pragma omp simd
+    for (size_t r = 0; r < rows; r++) {
+      dst[r * bits + j] = double(nums[r] % K);
+      nums[r] /= K;
+    }
+  }
+}
+
+void digitBlock(const uint32_t* src, size_t rows, uint32_t k, uint32_t bits,
+                double* dst) {
+  switch (k) {
+    case 2:
+      return digitBlock<2>(src, rows, bits, dst);
+    case 3:
+      return digitBlock<3>(src, rows, bits, dst);
+    case 4:
+      return digitBlock<4>(src, rows, bits, dst);
+    case 10:
+      return digitBlock<10>(src, rows, bits, dst);
+    default:
+      break;
+  }
+  uint32_t nums[DIGIT_BLOCK_ROWS];
+  std::copy(src, src + rows, nums);
+  for (int64_t j = int64_t(bits) - 1; j >= 0; j--) {
+    for (size_t r = 0; r < rows; r++) {
+      dst[r * bits + j] = double(nums[r] % k);
+      nums[r] /= k;
+    }
+  }
+}
+
+void IYFC_SO_EXPORT bulkDecimalConvert(const uint32_t* vec_org, size_t num_cnt,
+                                       uint32_t k, uint32_t bits,
+                                       double* dst) {
+  if (k < 2) throw std::logic_error("decimal convert base must be >= 2");
+  int64_t block_cnt = (num_cnt + DIGIT_BLOCK_ROWS - 1) / DIGIT_BLOCK_ROWS;
+#pragma omp parallel for
+  for (int64_t b = 0; b < block_cnt; b++) {
+    size_t begin = b * DIGIT_BLOCK_ROWS;
+    size_t rows = std::min(DIGIT_BLOCK_ROWS, num_cnt - begin);
+    digitBlock(vec_org + begin, rows, k, bits, dst + begin * bits);
+  }
+}
+
+void IYFC_SO_EXPORT bulkDecimalConvertTiles(
+    const std::vector<uint32_t>& vec_org, uint32_t k, uint32_t bits,
+    uint32_t tile_size, std::vector<std::vector<double>>& tiles) {
+  size_t rows_per_tile = tile_size / bits;
+  if (rows_per_tile == 0) {
+    throw std::logic_error("tile size smaller than digit count");
+  }
+  size_t tile_cnt = (vec_org.size() + rows_per_tile - 1) / rows_per_tile;
+  tiles.assign(std::max(tile_cnt, size_t(1)),
+               std::vector<double>(tile_size, 0.0));
+  for (size_t t = 0; t < tile_cnt; t++) {
+    size_t begin = t * rows_per_tile;
+    size_t rows = std::min(rows_per_tile, vec_org.size() - begin);
+    bulkDecimalConvert(vec_org.data() + begin, rows, k, bits, tiles[t].data());
+  }
+}
+
 void getNumReVec(int num, std::vector<int>& vec_num, size_t total_size) {
   std::string str_num = std::to_string(num);
   for (const auto& ch : str_num) vec_num.emplace_back(ch - '0');
@@ -79,6 +153,159 @@ double getComplexNum(fftw_complex* vec_complex, int n) {
   }
   return result;
 }
+// Records per batched transform, a multiple of it keeps fftw_malloc alignment
+const int FFT_BLOCK_RECORDS = 64;
+
+FFTPlanCache& FFTPlanCache::getInstance() {
+  static FFTPlanCache instance;
+  return instance;
+}
+
+FFTPlanCache::FFTPlanCache() {
+  const char* env_path = std::getenv("IYFC_FFTW_WISDOM");
+  if (env_path != nullptr) m_wisdom_file = env_path;
+}
+
+FFTPlanCache::~FFTPlanCache() { clear(); }
+
+void FFTPlanCache::clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto& item : m_plans) fftw_destroy_plan(item.second);
+  m_plans.clear();
+  fftw_cleanup();
+  // Accumulated wisdom went with the cleanup
+  m_wisdom_loaded = false;
+}
+
+void FFTPlanCache::setWisdomFile(const std::string& path) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_wisdom_file = path;
+  m_wisdom_loaded = false;
+}
+
+void FFTPlanCache::loadWisdom() {
+  if (m_wisdom_loaded || m_wisdom_file.empty()) return;
+  m_wisdom_loaded = true;
+  if (!fftw_import_wisdom_from_filename(m_wisdom_file.c_str())) {
+    LOG(LOGLEVEL::Debug, "no fftw wisdom loaded from %s",
+        m_wisdom_file.c_str());
+  }
+}
+
+void FFTPlanCache::saveWisdom() {
+  if (m_wisdom_file.empty()) return;
+  if (!fftw_export_wisdom_to_filename(m_wisdom_file.c_str())) {
+    warn("export fftw wisdom to %s failed", m_wisdom_file.c_str());
+  }
+}
+
+fftw_plan FFTPlanCache::getPlan(int n, int howmany, int sign) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto key = std::make_tuple(n, howmany, sign);
+  auto iter = m_plans.find(key);
+  if (iter != m_plans.end()) return iter->second;
+
+  loadWisdom();
+  // FFTW_MEASURE overwrites the arrays, plan on scratch buffers
+  size_t total = size_t(n) * howmany;
+  fftw_complex* in = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * total);
+  fftw_complex* out = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * total);
+  fftw_plan plan = fftw_plan_many_dft(1, &n, howmany, in, nullptr, 1, n, out,
+                                      nullptr, 1, n, sign, FFTW_MEASURE);
+  fftw_free(in);
+  fftw_free(out);
+  if (plan == nullptr) {
+    throw std::logic_error("fftw_plan_many_dft failed");
+  }
+  m_plans.emplace(key, plan);
+  saveWisdom();
+  return plan;
+}
+
+// Run the cached block plans over num_cnt records held in in/out
+void batchFFTExecute(fftw_complex* in, fftw_complex* out, uint32_t num_cnt,
+                     int fft_n, int sign) {
+  auto& cache = FFTPlanCache::getInstance();
+  int block_cnt = (num_cnt + FFT_BLOCK_RECORDS - 1) / FFT_BLOCK_RECORDS;
+  int tail = num_cnt % FFT_BLOCK_RECORDS;
+  // Plan outside the parallel region, execution itself is thread-safe
+  fftw_plan block_plan =
+      num_cnt >= FFT_BLOCK_RECORDS
+          ? cache.getPlan(fft_n, FFT_BLOCK_RECORDS, sign)
+          : nullptr;
+  fftw_plan tail_plan = tail ? cache.getPlan(fft_n, tail, sign) : nullptr;
+
+#pragma omp parallel for
+  for (int b = 0; b < block_cnt; b++) {
+    size_t offset = size_t(b) * FFT_BLOCK_RECORDS * fft_n;
+    bool is_tail = tail && b == block_cnt - 1;
+    fftw_execute_dft(is_tail ? tail_plan : block_plan, in + offset,
+                     out + offset);
+  }
+}
+
+void batchFFTEncode(const std::vector<uint32_t>& vec_org, int fft_n,
+                    std::vector<ComplexDouble>& vec_spectrum) {
+  uint32_t num_cnt = vec_org.size();
+  vec_spectrum.resize(size_t(num_cnt) * fft_n);
+  if (num_cnt == 0) return;
+
+  size_t total = size_t(num_cnt) * fft_n;
+  fftw_complex* in = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * total);
+  fftw_complex* out = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * total);
+
+  // Reversed decimal digits, as getNumReVec
+#pragma omp parallel for
+  for (int64_t r = 0; r < int64_t(num_cnt); r++) {
+    fftw_complex* rec = in + r * fft_n;
+    uint32_t num = vec_org[r];
+    for (int i = 0; i < fft_n; i++) {
+      rec[i][0] = double(num % 10);
+      rec[i][1] = 0;
+      num /= 10;
+    }
+  }
+
+  batchFFTExecute(in, out, num_cnt, fft_n, FFTW_FORWARD);
+
+#pragma omp parallel for
+  for (int64_t i = 0; i < int64_t(total); i++) {
+    vec_spectrum[i] = ComplexDouble(out[i][0], out[i][1]);
+  }
+  fftw_free(in);
+  fftw_free(out);
+}
+
+void batchFFTDecode(const std::vector<ComplexDouble>& vec_spectrum,
+                    uint32_t num_cnt, int fft_n,
+                    std::vector<double>& vec_results) {
+  size_t total = size_t(num_cnt) * fft_n;
+  if (vec_spectrum.size() < total) {
+    throw std::logic_error("err complex outputs size");
+  }
+  if (num_cnt == 0) return;
+
+  fftw_complex* in = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * total);
+  fftw_complex* out = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * total);
+
+#pragma omp parallel for
+  for (int64_t i = 0; i < int64_t(total); i++) {
+    in[i][0] = vec_spectrum[i].real();
+    in[i][1] = vec_spectrum[i].imag();
+  }
+
+  batchFFTExecute(in, out, num_cnt, fft_n, FFTW_BACKWARD);
+
+  size_t old_size = vec_results.size();
+  vec_results.resize(old_size + num_cnt);
+#pragma omp parallel for
+  for (int64_t r = 0; r < int64_t(num_cnt); r++) {
+    vec_results[old_size + r] = getComplexNum(out + r * fft_n, fft_n);
+  }
+  fftw_free(in);
+  fftw_free(out);
+}
+
 int getLog(int k, int base) { return int(std::log(k) / std::log(base)); }
 
 double IYFC_SO_EXPORT CalculateApproximationErrorMax(
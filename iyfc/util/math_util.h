@@ -26,6 +26,10 @@
 
 #include <cmath>
 #include <complex>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
 #include <vector>
 
 namespace iyfc {
@@ -37,6 +41,34 @@ typedef std::complex<double> ComplexDouble;
  */
 std::vector<uint32_t> decimalConvert(uint32_t num, uint32_t k,
                                      uint32_t bits = 32);
+/**
+ * @brief Bulk version of decimalConvert writing into a preallocated buffer
+ * @details Row r gets its base-k digits, most significant first, at
+ * dst[r * bits, (r + 1) * bits). Rows are encoded in blocks, digit by digit,
+ * so the division by k vectorizes across rows. Multithreaded over blocks.
+ * @param[in] vec_org Rows to encode
+ * @param[in] num_cnt Number of rows
+ * @param[in] k Base
+ * @param[in] bits Digits per row
+ * @param[out] dst At least num_cnt * bits values
+ */
+void bulkDecimalConvert(const uint32_t* vec_org, size_t num_cnt, uint32_t k,
+                        uint32_t bits, double* dst);
+
+/**
+ * @brief Bulk digit decomposition into fixed-size slot tiles
+ * @details Each tile holds tile_size / bits rows, the tail of every tile is
+ * zero. One tile maps to one ciphertext.
+ * @param[in] vec_org Rows to encode
+ * @param[in] k Base
+ * @param[in] bits Digits per row
+ * @param[in] tile_size Slots per tile
+ * @param[out] tiles Encoded tiles
+ */
+void bulkDecimalConvertTiles(const std::vector<uint32_t>& vec_org, uint32_t k,
+                             uint32_t bits, uint32_t tile_size,
+                             std::vector<std::vector<double>>& tiles);
+
 /**
  * @brief Split an integer into individual digits and reverse, padding with zeros  1234 --> [4,3,2,1,0,0,0,0,0]
  */
@@ -66,6 +98,75 @@ double CalculateApproximationErrorMax(const std::vector<double>& result,
 double CalculateApproximationError(const std::vector<double>& result,
                                    const std::vector<double>& expected);
 
+/**
+ * @class FFTPlanCache
+ * @brief Process-wide cache of batched FFTW plans
+ * @details Plans are created once per (n, howmany, sign) with FFTW_MEASURE and
+ * reused through fftw_execute_dft, which is thread-safe. The FFTW planner is
+ * not, so every planner call goes through plannerMutex(). Wisdom is imported
+ * from and exported to the wisdom file when one is set (IYFC_FFTW_WISDOM
+ * environment variable or setWisdomFile).
+ */
+class FFTPlanCache {
+ public:
+  static FFTPlanCache& getInstance();
+
+  /**
+   * @brief Get a plan for howmany contiguous transforms of size n
+   * @details Buffers passed to fftw_execute_dft must come from fftw_malloc.
+   */
+  fftw_plan getPlan(int n, int howmany, int sign);
+
+  void setWisdomFile(const std::string& path);
+
+  /**
+   * @brief Destroy the cached plans and release FFTW's global state
+   * @details Plans are rebuilt on next use. fftw_cleanup invalidates every
+   * FFTW plan, so call only while no FFT runs and no FastFourierTransform
+   * exists.
+   */
+  void clear();
+
+  std::mutex& plannerMutex() { return m_mutex; }
+
+  ~FFTPlanCache();
+
+ private:
+  FFTPlanCache();
+  FFTPlanCache(const FFTPlanCache&) = delete;
+  FFTPlanCache& operator=(const FFTPlanCache&) = delete;
+
+  void loadWisdom();
+  void saveWisdom();
+
+  std::map<std::tuple<int, int, int>, fftw_plan> m_plans;
+  std::mutex m_mutex;
+  std::string m_wisdom_file;
+  bool m_wisdom_loaded{false};
+};
+
+/**
+ * @brief Batched forward FFT of the reversed digits of every record
+ * @details Records are split into fixed-size blocks that share one cached
+ * plan and are transformed in parallel.
+ * @param[in] vec_org Records
+ * @param[in] fft_n Digits per record
+ * @param[out] vec_spectrum fft_n complex values per record
+ */
+void batchFFTEncode(const std::vector<uint32_t>& vec_org, int fft_n,
+                    std::vector<ComplexDouble>& vec_spectrum);
+
+/**
+ * @brief Batched backward FFT, the inverse of batchFFTEncode
+ * @param[in] vec_spectrum At least num_cnt * fft_n complex values
+ * @param[in] num_cnt Number of records
+ * @param[in] fft_n Digits per record
+ * @param[out] vec_results One number per record, see getComplexNum
+ */
+void batchFFTDecode(const std::vector<ComplexDouble>& vec_spectrum,
+                    uint32_t num_cnt, int fft_n,
+                    std::vector<double>& vec_results);
+
 /**
  * @class FastFourierTransform
  * @brief Helper class for FFT algorithm
@@ -77,14 +178,21 @@ class FastFourierTransform {
   FastFourierTransform(int n, int sign) : N(n) {
     m_in = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * N);
     m_out = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * N);
+    std::lock_guard<std::mutex> lock(
+        FFTPlanCache::getInstance().plannerMutex());
     p = fftw_plan_dft_1d(n, m_in, m_out, sign, FFTW_MEASURE);
   }
 
   void fft() { fftw_execute(p); /* repeat as needed */ }
 
+  // No fftw_cleanup here, it would invalidate the plans cached by
+  // FFTPlanCache, see FFTPlanCache::clear
   ~FastFourierTransform() {
-    fftw_destroy_plan(p);
-    fftw_cleanup();
+    {
+      std::lock_guard<std::mutex> lock(
+          FFTPlanCache::getInstance().plannerMutex());
+      fftw_destroy_plan(p);
+    }
     if (m_in != NULL) fftw_free(m_in);
     if (m_out != NULL) fftw_free(m_out);
   }
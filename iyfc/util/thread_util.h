@@ -0,0 +1,66 @@
+/*
+ *
+ * MIT License
+ * Copyright 2023 The IDEA Authors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#include <omp.h>
+
+#include <cstdint>
+#include <exception>
+#include <mutex>
+
+namespace iyfc {
+/**
+ * @brief Set the number of threads used by encrypt/decrypt
+ * @details 0 means the OpenMP default
+ */
+void setWorkerThreadNum(uint32_t thread_num);
+
+/**
+ * @brief Get the number of threads used by encrypt/decrypt
+ */
+uint32_t getWorkerThreadNum();
+
+/**
+ * @brief Run func(i, thread_id) for i in [0, cnt) on worker threads
+ * @details thread_id is in [0, getWorkerThreadNum()), so callers can keep
+ * per-thread objects (encoders, memory pools) in a vector. The first
+ * exception thrown by func is rethrown on the calling thread. thread_num 0
+ * means getWorkerThreadNum().
+ */
+template <typename Func>
+void parallelFor(size_t cnt, Func &&func, uint32_t thread_num = 0) {
+  std::exception_ptr eptr = nullptr;
+  std::mutex eptr_mutex;
+  if (thread_num == 0) thread_num = getWorkerThreadNum();
+  if (cnt <= 1) thread_num = 1;
+#pragma omp parallel for num_threads(thread_num) schedule(dynamic)
+  for (int64_t i = 0; i < int64_t(cnt); i++) {
+    try {
+      func(size_t(i), size_t(omp_get_thread_num()));
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(eptr_mutex);
+      if (!eptr) eptr = std::current_exception();
+    }
+  }
+  if (eptr) std::rethrow_exception(eptr);
+}
+}  // namespace iyfc